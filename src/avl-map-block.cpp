@@ -0,0 +1,875 @@
+/**
+ * @file avl-map-block.cpp
+ * @author Edgar Jose Donoso Mansilla (e.donosomansilla)
+ * @course CS280
+ * @term Spring 2025
+ *
+ * @brief Implementation for the AVL map whose nodes hold a block of keys
+ */
+
+#include <algorithm>
+#include <climits>
+#include <utility>
+
+#define AVLMAPBLOCK_CPP
+
+#ifndef AVLMAPBLOCK_H
+  #include "avl-map-block.h"
+#endif
+
+namespace CS280 {
+
+  /// AVL Methods
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_block<K, V, Compare>::AVLmap_block() {}
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_block<K, V, Compare>::AVLmap_block(const Compare& comp):
+      comp(comp) {}
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_block<K, V, Compare>::AVLmap_block(const AVLmap_block& rhs):
+      comp(rhs.comp), size_(0) {
+    root = clone(rhs.root, nullptr);
+    size_ = rhs.size_;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::operator=(const AVLmap_block& rhs)
+    -> AVLmap_block& {
+    if (this == &rhs) {
+      return *this;
+    }
+
+    clear();
+
+    comp = rhs.comp;
+    root = clone(rhs.root, nullptr);
+    size_ = rhs.size_;
+
+    return *this;
+  }
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_block<K, V, Compare>::AVLmap_block(AVLmap_block&& rhs):
+      comp(std::move(rhs.comp)),
+      root(std::exchange(rhs.root, nullptr)),
+      size_(std::exchange(rhs.size_, 0)),
+      blocks(std::exchange(rhs.blocks, 0)) {}
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::operator=(AVLmap_block&& rhs)
+    -> AVLmap_block& {
+    if (this == &rhs) {
+      return *this;
+    }
+
+    clear();
+
+    comp = std::move(rhs.comp);
+    root = std::exchange(rhs.root, nullptr);
+    size_ = std::exchange(rhs.size_, 0);
+    blocks = std::exchange(rhs.blocks, 0);
+
+    return *this;
+  }
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_block<K, V, Compare>::~AVLmap_block() {
+    clear();
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::size() const -> unsigned int {
+    return size_;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::operator[](const K& key) -> V& {
+    Block* parent = nullptr;
+    bool as_left = false;
+
+    for (Block* current = root; current != nullptr;) {
+      unsigned slot = rank(current, key);
+      parent = current;
+
+      if (slot == current->count) {
+        as_left = false;
+        current = current->right;
+      } else if (!comp(key, current->keys[slot])) {
+        return current->values[slot];
+      } else if (slot == 0) {
+        as_left = true;
+        current = current->left;
+      } else {
+        // Between two keys of the block, so it goes in the block
+        return insert_at(current, slot, key);
+      }
+    }
+
+    if (parent == nullptr) {
+      return insert_at(nullptr, 0, key);
+    }
+
+    // Past the side of a block without a child, where no other block fits
+    return insert_at(parent, as_left ? 0 : parent->count, key);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::begin() -> iterator {
+    return iterator(this, next_block(nullptr), 0);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::end() -> iterator {
+    return iterator(this, nullptr, 0);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::begin() const -> const_iterator {
+    return const_iterator(this, next_block(nullptr), 0);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::end() const -> const_iterator {
+    return const_iterator(this, nullptr, 0);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::find(const K& key) -> iterator {
+    unsigned slot = 0;
+    Block* block = search(key, slot);
+    return iterator(this, block, slot);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::find(const K& key) const
+    -> const_iterator {
+    unsigned slot = 0;
+    Block* block = search(key, slot);
+    return const_iterator(this, block, slot);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::erase(iterator it) -> void {
+    Block* block = it.entry.block;
+    if (block == nullptr) {
+      return;
+    }
+
+    for (unsigned i = it.entry.slot + 1; i < block->count; ++i) {
+      block->keys[i - 1] = std::move(block->keys[i]);
+      block->values[i - 1] = std::move(block->values[i]);
+    }
+
+    // Whatever the vacated slot held is released now rather than on reuse
+    block->count--;
+    block->keys[block->count] = K{};
+    block->values[block->count] = V{};
+    size_--;
+
+    if (block->count == 0) {
+      unlink(block);
+    } else if (block->count < merge_below) {
+      merge(block);
+    }
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::sanityCheck() const -> bool {
+    unsigned count = 0;
+    if (check(root, nullptr, count) < 0 || count != size_) {
+      return false;
+    }
+
+    if (root == nullptr) {
+      return true;
+    }
+
+    const_iterator previous = begin();
+    for (const_iterator it = ++begin(); it != end(); ++it, ++previous) {
+      if (!comp(previous->Key(), it->Key())) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::bytes_reserved() const -> std::size_t {
+    return blocks * sizeof(Block);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::rank(const Block* block, const K& key)
+    const -> unsigned {
+  #if AVLMAP_BLOCK_SSE2
+    if constexpr (sse2_keys) {
+      // Unsigned keys are compared as signed ones with the top bit flipped
+      const __m128i sign = _mm_set1_epi32(std::is_unsigned_v<K> ? INT_MIN : 0);
+      const __m128i probe =
+        _mm_xor_si128(_mm_set1_epi32(static_cast<int>(key)), sign);
+
+      // One bit per key that is less than the probe
+      unsigned less = 0;
+      for (unsigned i = 0; i < block_size; i += 4) {
+        __m128i keys = _mm_xor_si128(
+          _mm_load_si128(reinterpret_cast<const __m128i*>(block->keys + i)),
+          sign
+        );
+        __m128i result = _mm_cmpgt_epi32(probe, keys);
+        less |= static_cast<unsigned>(
+                  _mm_movemask_ps(_mm_castsi128_ps(result))
+                )
+                << i;
+      }
+
+      // The keys are sorted, so the bits in use are all at the bottom
+      less &= (1u << block->count) - 1;
+    #if defined(__GNUC__) || defined(__clang__)
+      return static_cast<unsigned>(__builtin_popcount(less));
+    #else
+      unsigned count = 0;
+      for (; less != 0; less &= less - 1) {
+        count++;
+      }
+      return count;
+    #endif
+    }
+  #endif
+
+    return static_cast<unsigned>(
+      std::lower_bound(block->keys, block->keys + block->count, key, comp)
+      - block->keys
+    );
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::search(const K& key, unsigned& slot) const
+    -> Block* {
+    for (Block* current = root; current != nullptr;) {
+      unsigned position = rank(current, key);
+
+      if (position == current->count) {
+        current = current->right;
+      } else if (!comp(key, current->keys[position])) {
+        slot = position;
+        return current;
+      } else if (position == 0) {
+        current = current->left;
+      } else {
+        return nullptr;
+      }
+    }
+
+    return nullptr;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::insert_at(
+    Block* block,
+    unsigned slot,
+    const K& key
+  ) -> V& {
+    // Everything that can throw happens before the map changes, the rest only
+    // moves what is already there
+    K copy(key);
+    V value{};
+
+    if (block == nullptr) {
+      root = new Block();
+      blocks++;
+      block = root;
+    } else if (block->count == block_size) {
+      Block* fresh = new Block();
+      blocks++;
+
+      // Past either end the key starts a block of its own, so ascending or
+      // descending runs leave full blocks behind. Otherwise it splits evenly
+      if (slot == block_size) {
+        attach_after(block, fresh);
+        block = fresh;
+        slot = 0;
+      } else if (slot == 0) {
+        attach_before(block, fresh);
+        block = fresh;
+      } else {
+        unsigned half = block_size / 2;
+        append(fresh, block, half);
+        attach_after(block, fresh);
+
+        if (slot > half) {
+          block = fresh;
+          slot -= half;
+        }
+      }
+    }
+
+    for (unsigned i = block->count; i > slot; --i) {
+      block->keys[i] = std::move(block->keys[i - 1]);
+      block->values[i] = std::move(block->values[i - 1]);
+    }
+
+    block->keys[slot] = std::move(copy);
+    block->values[slot] = std::move(value);
+    block->count++;
+    size_++;
+
+    return block->values[slot];
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::append(
+    Block* to,
+    Block* from,
+    unsigned first
+  ) -> void {
+    for (unsigned i = first; i < from->count; ++i) {
+      to->keys[to->count] = std::move(from->keys[i]);
+      to->values[to->count] = std::move(from->values[i]);
+      to->count++;
+    }
+
+    from->count = static_cast<std::uint8_t>(first);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::attach_after(Block* block, Block* fresh)
+    -> void {
+    if (block->right == nullptr) {
+      block->right = fresh;
+      fresh->parent = block;
+    } else {
+      Block* parent = block->right;
+      while (parent->left != nullptr) {
+        parent = parent->left;
+      }
+      parent->left = fresh;
+      fresh->parent = parent;
+    }
+
+    retrace(fresh->parent);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::attach_before(Block* block, Block* fresh)
+    -> void {
+    if (block->left == nullptr) {
+      block->left = fresh;
+      fresh->parent = block;
+    } else {
+      Block* parent = block->left;
+      while (parent->right != nullptr) {
+        parent = parent->right;
+      }
+      parent->right = fresh;
+      fresh->parent = parent;
+    }
+
+    retrace(fresh->parent);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::merge(Block* block) -> void {
+    Block* next = next_block(block);
+    if (next != nullptr && next->count + block->count <= block_size) {
+      unsigned moved = block->count;
+
+      for (unsigned i = next->count; i-- > 0;) {
+        next->keys[i + moved] = std::move(next->keys[i]);
+        next->values[i + moved] = std::move(next->values[i]);
+      }
+      for (unsigned i = 0; i < moved; ++i) {
+        next->keys[i] = std::move(block->keys[i]);
+        next->values[i] = std::move(block->values[i]);
+      }
+
+      next->count = static_cast<std::uint8_t>(next->count + moved);
+      unlink(block);
+      return;
+    }
+
+    Block* previous = previous_block(block);
+    if (previous != nullptr && previous->count + block->count <= block_size) {
+      append(previous, block, 0);
+      unlink(block);
+    }
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::unlink(Block* block) -> void {
+    Block* parent = block->parent;
+
+    if (block->left == nullptr || block->right == nullptr) {
+      Block* child = block->left != nullptr ? block->left : block->right;
+
+      replace_child(parent, block, child);
+      if (child != nullptr) {
+        child->parent = parent;
+      }
+
+      delete block;
+      blocks--;
+      retrace(parent);
+      return;
+    }
+
+    // The predecessor is spliced into the place of the block
+    Block* moved = block->left;
+    while (moved->right != nullptr) {
+      moved = moved->right;
+    }
+
+    Block* lowest_changed = moved;
+    if (moved != block->left) {
+      lowest_changed = moved->parent;
+
+      lowest_changed->right = moved->left;
+      if (moved->left != nullptr) {
+        moved->left->parent = lowest_changed;
+      }
+
+      moved->left = block->left;
+      moved->left->parent = moved;
+    }
+
+    moved->right = block->right;
+    moved->right->parent = moved;
+    moved->parent = parent;
+    moved->height = block->height;
+    replace_child(parent, block, moved);
+
+    delete block;
+    blocks--;
+    retrace(lowest_changed);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::height_of(const Block* block) -> int {
+    return block != nullptr ? block->height : 0;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::update_height(Block* block) -> void {
+    block->height = static_cast<std::uint8_t>(
+      std::max(height_of(block->left), height_of(block->right)) + 1
+    );
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::replace_child(
+    Block* parent,
+    Block* child,
+    Block* replacement
+  ) -> void {
+    if (parent == nullptr) {
+      root = replacement;
+    } else if (parent->left == child) {
+      parent->left = replacement;
+    } else {
+      parent->right = replacement;
+    }
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::rotate_left(Block* block) -> Block* {
+    Block* promoted = block->right;
+    Block* parent = block->parent;
+
+    block->right = promoted->left;
+    if (block->right != nullptr) {
+      block->right->parent = block;
+    }
+
+    promoted->left = block;
+    block->parent = promoted;
+    promoted->parent = parent;
+    replace_child(parent, block, promoted);
+
+    update_height(block);
+    update_height(promoted);
+
+    return promoted;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::rotate_right(Block* block) -> Block* {
+    Block* promoted = block->left;
+    Block* parent = block->parent;
+
+    block->left = promoted->right;
+    if (block->left != nullptr) {
+      block->left->parent = block;
+    }
+
+    promoted->right = block;
+    block->parent = promoted;
+    promoted->parent = parent;
+    replace_child(parent, block, promoted);
+
+    update_height(block);
+    update_height(promoted);
+
+    return promoted;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::rebalance(Block* block) -> Block* {
+    update_height(block);
+    int balance = height_of(block->right) - height_of(block->left);
+
+    if (balance > 1) {
+      if (height_of(block->right->right) < height_of(block->right->left)) {
+        rotate_right(block->right);
+      }
+      return rotate_left(block);
+    }
+
+    if (balance < -1) {
+      if (height_of(block->left->left) < height_of(block->left->right)) {
+        rotate_left(block->left);
+      }
+      return rotate_right(block);
+    }
+
+    return block;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::retrace(Block* block) -> void {
+    while (block != nullptr) {
+      Block* parent = block->parent;
+      int old_height = block->height;
+
+      if (rebalance(block) == block && block->height == old_height) {
+        return;
+      }
+
+      block = parent;
+    }
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::next_block(const Block* block) const
+    -> Block* {
+    if (block == nullptr || block->right != nullptr) {
+      Block* current = block == nullptr ? root : block->right;
+      while (current != nullptr && current->left != nullptr) {
+        current = current->left;
+      }
+      return current;
+    }
+
+    Block* parent = block->parent;
+    while (parent != nullptr && parent->right == block) {
+      block = parent;
+      parent = parent->parent;
+    }
+
+    return parent;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::previous_block(const Block* block) const
+    -> Block* {
+    if (block == nullptr || block->left != nullptr) {
+      Block* current = block == nullptr ? root : block->left;
+      while (current != nullptr && current->right != nullptr) {
+        current = current->right;
+      }
+      return current;
+    }
+
+    Block* parent = block->parent;
+    while (parent != nullptr && parent->left == block) {
+      block = parent;
+      parent = parent->parent;
+    }
+
+    return parent;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::clone(const Block* source, Block* parent)
+    -> Block* {
+    if (source == nullptr) {
+      return nullptr;
+    }
+
+    Block* copy = new Block();
+    blocks++;
+    copy->height = source->height;
+    copy->parent = parent;
+
+    // A failed child cleaned up after itself, what was cloned so far hangs
+    // from copy
+    try {
+      for (unsigned i = 0; i < source->count; ++i) {
+        copy->keys[i] = source->keys[i];
+        copy->values[i] = source->values[i];
+      }
+      copy->count = source->count;
+
+      copy->left = clone(source->left, copy);
+      copy->right = clone(source->right, copy);
+    } catch (...) {
+      destroy(copy);
+      throw;
+    }
+
+    return copy;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::check(
+    const Block* block,
+    const Block* parent,
+    unsigned& count
+  ) const -> int {
+    if (block == nullptr) {
+      return 0;
+    }
+
+    // The count guards against cycles
+    count += block->count;
+    if (block->parent != parent || block->count == 0
+        || block->count > block_size || count > size_) {
+      return -1;
+    }
+
+    for (unsigned i = 1; i < block->count; ++i) {
+      if (!comp(block->keys[i - 1], block->keys[i])) {
+        return -1;
+      }
+    }
+
+    int height_l = check(block->left, block, count);
+    int height_r = height_l < 0 ? -1 : check(block->right, block, count);
+    int height = std::max(height_l, height_r) + 1;
+
+    if (height_r < 0 || height_r - height_l < -1 || height_r - height_l > 1
+        || block->height != height) {
+      return -1;
+    }
+
+    return height;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::clear() -> void {
+    destroy(root);
+    root = nullptr;
+    size_ = 0;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::destroy(Block* block) -> void {
+    if (block == nullptr) {
+      return;
+    }
+
+    Block* current = block;
+    Block* top = block->parent;
+
+    // Walks down to a leaf, deletes it and goes back up to its parent
+    while (current != top) {
+      if (current->left != nullptr) {
+        current = std::exchange(current->left, nullptr);
+      } else if (current->right != nullptr) {
+        current = std::exchange(current->right, nullptr);
+      } else {
+        Block* parent = current->parent;
+        delete current;
+        blocks--;
+        current = parent;
+      }
+    }
+  }
+
+  /// Entry Methods
+
+  template<typename K, typename V, typename Compare>
+  template<bool Const>
+  AVLmap_block<K, V, Compare>::BasicEntry<Const>::BasicEntry(
+    block_type* b,
+    unsigned s
+  ):
+      block(b), slot(s) {}
+
+  template<typename K, typename V, typename Compare>
+  template<bool Const>
+  auto AVLmap_block<K, V, Compare>::BasicEntry<Const>::Key() const
+    -> const K& {
+    return block->keys[slot];
+  }
+
+  template<typename K, typename V, typename Compare>
+  template<bool Const>
+  auto AVLmap_block<K, V, Compare>::BasicEntry<Const>::Value() const
+    -> value_type& {
+    return block->values[slot];
+  }
+
+  /// Iterator Methods
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_block<K, V, Compare>::AVLmap_block_iterator::AVLmap_block_iterator(
+    AVLmap_block* m,
+    Block* b,
+    unsigned s
+  ):
+      map(m), entry(b, s) {}
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_block<K, V, Compare>::AVLmap_block_iterator::
+  operator AVLmap_block_iterator_const() const {
+    return AVLmap_block_iterator_const(map, entry.block, entry.slot);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::AVLmap_block_iterator::operator++()
+    -> AVLmap_block_iterator& {
+    if (entry.block != nullptr && entry.slot + 1 < entry.block->count) {
+      entry.slot++;
+    } else {
+      entry.block = map->next_block(entry.block);
+      entry.slot = 0;
+    }
+    return *this;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::AVLmap_block_iterator::operator++(int)
+    -> AVLmap_block_iterator {
+    AVLmap_block_iterator previous = *this;
+    ++(*this);
+    return previous;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::AVLmap_block_iterator::operator--()
+    -> AVLmap_block_iterator& {
+    if (entry.block != nullptr && entry.slot > 0) {
+      entry.slot--;
+    } else {
+      entry.block = map->previous_block(entry.block);
+      entry.slot = entry.block != nullptr ? entry.block->count - 1u : 0;
+    }
+    return *this;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::AVLmap_block_iterator::operator--(int)
+    -> AVLmap_block_iterator {
+    AVLmap_block_iterator previous = *this;
+    --(*this);
+    return previous;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::AVLmap_block_iterator::operator*() const
+    -> const Entry& {
+    return entry;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::AVLmap_block_iterator::operator->() const
+    -> const Entry* {
+    return &entry;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::AVLmap_block_iterator::operator!=(
+    const AVLmap_block_iterator& rhs
+  ) const -> bool {
+    return !(*this == rhs);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::AVLmap_block_iterator::operator==(
+    const AVLmap_block_iterator& rhs
+  ) const -> bool {
+    return entry.block == rhs.entry.block && entry.slot == rhs.entry.slot;
+  }
+
+  /// Const Iterator Methods
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_block<K, V, Compare>::AVLmap_block_iterator_const::
+    AVLmap_block_iterator_const(
+      const AVLmap_block* m,
+      const Block* b,
+      unsigned s
+    ):
+      map(m), entry(b, s) {}
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::AVLmap_block_iterator_const::operator++()
+    -> AVLmap_block_iterator_const& {
+    if (entry.block != nullptr && entry.slot + 1 < entry.block->count) {
+      entry.slot++;
+    } else {
+      entry.block = map->next_block(entry.block);
+      entry.slot = 0;
+    }
+    return *this;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::AVLmap_block_iterator_const::operator++(
+    int
+  ) -> AVLmap_block_iterator_const {
+    AVLmap_block_iterator_const previous = *this;
+    ++(*this);
+    return previous;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::AVLmap_block_iterator_const::operator--()
+    -> AVLmap_block_iterator_const& {
+    if (entry.block != nullptr && entry.slot > 0) {
+      entry.slot--;
+    } else {
+      entry.block = map->previous_block(entry.block);
+      entry.slot = entry.block != nullptr ? entry.block->count - 1u : 0;
+    }
+    return *this;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::AVLmap_block_iterator_const::operator--(
+    int
+  ) -> AVLmap_block_iterator_const {
+    AVLmap_block_iterator_const previous = *this;
+    --(*this);
+    return previous;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::AVLmap_block_iterator_const::operator*()
+    const -> const ConstEntry& {
+    return entry;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::AVLmap_block_iterator_const::operator->()
+    const -> const ConstEntry* {
+    return &entry;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::AVLmap_block_iterator_const::operator!=(
+    const AVLmap_block_iterator_const& rhs
+  ) const -> bool {
+    return !(*this == rhs);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_block<K, V, Compare>::AVLmap_block_iterator_const::operator==(
+    const AVLmap_block_iterator_const& rhs
+  ) const -> bool {
+    return entry.block == rhs.entry.block && entry.slot == rhs.entry.slot;
+  }
+} // namespace CS280
@@ -0,0 +1,626 @@
+/**
+ * @file avl-map-block.h
+ * @author Edgar Jose Donoso Mansilla (e.donosomansilla)
+ * @course CS280
+ * @term Spring 2025
+ *
+ * @brief AVL map whose nodes hold a sorted block of keys
+ */
+
+#ifndef AVLMAPBLOCK_H
+  #define AVLMAPBLOCK_H
+
+  #include <cstddef>
+  #include <cstdint>
+  #include <functional>
+  #include <type_traits>
+
+  // Define as 0 before including to search the blocks without SSE2
+  #ifndef AVLMAP_BLOCK_SSE2
+    #if defined(__SSE2__) || defined(_M_X64)
+      #define AVLMAP_BLOCK_SSE2 1
+    #else
+      #define AVLMAP_BLOCK_SSE2 0
+    #endif
+  #endif
+
+  #if AVLMAP_BLOCK_SSE2
+    #include <emmintrin.h>
+  #endif
+
+namespace CS280 {
+
+  /**
+   * @brief AVL map whose nodes hold up to block_size keys in a sorted array
+   * (a T-tree): every key of a block is greater than the keys of its left
+   * subtree and less than the keys of its right one. The tree has about
+   * block_size times fewer nodes than a plain AVL tree, so searches follow
+   * about 4 fewer links.
+   *
+   * A full block splits in two and a block that runs low merges into a
+   * neighbour, so the AVL shape only changes (and rotates) once every few
+   * insertions or erasures. The keys of a block are apart from the values,
+   * so 16 keys of 4 bytes are one cache line. For 32-bit integral keys under
+   * std::less the block is searched with SSE2, comparing 4 keys per
+   * instruction and turning the results into the position with a movemask.
+   *
+   * K and V have to be default constructible and move assignable. Iterators
+   * are invalidated by any insertion or erasure (entries move within and
+   * between blocks).
+   *
+   * @param K The type for the key to be used
+   * @param V The type for the values to be used
+   * @param Compare The strict weak ordering of the keys
+   */
+  template<typename K, typename V, typename Compare = std::less<K>>
+  class AVLmap_block {
+
+    // Forward declarations for the structs
+    struct Block;
+    struct AVLmap_block_iterator;
+    struct AVLmap_block_iterator_const;
+
+  public:
+
+    // standard names for iterator types
+    typedef AVLmap_block_iterator iterator;
+    typedef AVLmap_block_iterator_const const_iterator;
+
+    /**
+     * @brief A key and its value, as seen through an iterator.
+     * @param Const Whether the value can be modified through it.
+     */
+    template<bool Const>
+    class BasicEntry {
+    public:
+
+      // The value as seen through the entry
+      typedef std::conditional_t<Const, const V, V> value_type;
+
+      /**
+       * @brief Getter of a reference to the key.
+       * @return Const reference to the key.
+       */
+      auto Key() const -> const K&;
+
+      /**
+       * @brief Getter of a reference to the value.
+       * @return Reference to the value.
+       */
+      auto Value() const -> value_type&;
+
+    private:
+
+      // The block as seen through the entry
+      typedef std::conditional_t<Const, const Block, Block> block_type;
+
+      /**
+       * @brief Constructor
+       * @param b The block
+       * @param s The position in the block
+       */
+      BasicEntry(block_type* b, unsigned s);
+
+      /**
+       * @brief The block holding the entry (nullptr for end).
+       */
+      block_type* block;
+
+      /**
+       * @brief The position of the entry in the block.
+       */
+      unsigned slot;
+
+      // Friending the map class so the internals can be accessed.
+      friend AVLmap_block;
+    };
+
+    // standard names for entry types
+    typedef BasicEntry<false> Entry;
+    typedef BasicEntry<true> ConstEntry;
+
+    /**
+     * @brief Most keys a block holds.
+     */
+    static constexpr unsigned block_size{16};
+
+  private:
+
+    /**
+     * @brief A node of the tree: a sorted block of keys and their values.
+     */
+    struct Block {
+      /**
+       * @brief The keys, sorted (the first count are in use).
+       */
+      alignas(64) K keys[block_size];
+
+      /**
+       * @brief The values of the keys.
+       */
+      V values[block_size];
+
+      /**
+       * @brief The left child's pointer
+       */
+      Block* left{nullptr};
+
+      /**
+       * @brief The right child's pointer
+       */
+      Block* right{nullptr};
+
+      /**
+       * @brief The parent's pointer
+       */
+      Block* parent{nullptr};
+
+      /**
+       * @brief Amount of keys in use (never 0 for a block in the tree).
+       */
+      std::uint8_t count{0};
+
+      /**
+       * @brief The distance of the block relative to the leaves of the
+       * sub-tree
+       */
+      std::uint8_t height{1};
+    };
+
+    /**
+     * @brief This class is the non const iterator of the map
+     */
+    struct AVLmap_block_iterator {
+    private:
+
+      /**
+       * @brief The map the entry belongs to.
+       */
+      AVLmap_block* map;
+
+      /**
+       * @brief The entry the iterator is at.
+       */
+      Entry entry;
+
+    public:
+
+      /**
+       * @brief Constructor for the iterator
+       * @param m The map
+       * @param b The block (nullptr for end)
+       * @param s The position in the block
+       */
+      AVLmap_block_iterator(
+        AVLmap_block* m = nullptr,
+        Block* b = nullptr,
+        unsigned s = 0
+      );
+
+      /**
+       * @brief Conversion operator into const
+       */
+      operator AVLmap_block_iterator_const() const;
+
+      /**
+       * @brief Pre-increment operator (successor)
+       */
+      auto operator++() -> AVLmap_block_iterator&;
+
+      /**
+       * @brief Post-increment operator (successor)
+       */
+      auto operator++(int) -> AVLmap_block_iterator;
+
+      /**
+       * @brief Pre-decrement operator (predecessor)
+       */
+      auto operator--() -> AVLmap_block_iterator&;
+
+      /**
+       * @brief Post-decrement operator (predecessor)
+       */
+      auto operator--(int) -> AVLmap_block_iterator;
+
+      /**
+       * @brief Dereferencing operator.
+       * @return Reference to the entry.
+       */
+      auto operator*() const -> const Entry&;
+
+      /**
+       * @brief Arrow operator.
+       * @return Pointer to the entry.
+       */
+      auto operator->() const -> const Entry*;
+
+      /**
+       * @brief Inequality operator.
+       */
+      auto operator!=(const AVLmap_block_iterator& rhs) const -> bool;
+
+      /**
+       * @brief Equality operator.
+       */
+      auto operator==(const AVLmap_block_iterator& rhs) const -> bool;
+
+      friend AVLmap_block;
+    };
+
+    /**
+     * @brief This class is the const iterator of the map
+     */
+    struct AVLmap_block_iterator_const {
+    private:
+
+      /**
+       * @brief The map the entry belongs to.
+       */
+      const AVLmap_block* map;
+
+      /**
+       * @brief The entry the iterator is at.
+       */
+      ConstEntry entry;
+
+    public:
+
+      /**
+       * @brief Constructor for the iterator
+       * @param m The map
+       * @param b The block (nullptr for end)
+       * @param s The position in the block
+       */
+      AVLmap_block_iterator_const(
+        const AVLmap_block* m = nullptr,
+        const Block* b = nullptr,
+        unsigned s = 0
+      );
+
+      /**
+       * @brief Pre-increment operator (successor)
+       */
+      auto operator++() -> AVLmap_block_iterator_const&;
+
+      /**
+       * @brief Post-increment operator (successor)
+       */
+      auto operator++(int) -> AVLmap_block_iterator_const;
+
+      /**
+       * @brief Pre-decrement operator (predecessor)
+       */
+      auto operator--() -> AVLmap_block_iterator_const&;
+
+      /**
+       * @brief Post-decrement operator (predecessor)
+       */
+      auto operator--(int) -> AVLmap_block_iterator_const;
+
+      /**
+       * @brief Dereferencing operator.
+       * @return Reference to the entry.
+       */
+      auto operator*() const -> const ConstEntry&;
+
+      /**
+       * @brief Arrow operator.
+       * @return Pointer to the entry.
+       */
+      auto operator->() const -> const ConstEntry*;
+
+      /**
+       * @brief Inequality operator.
+       */
+      auto operator!=(const AVLmap_block_iterator_const& rhs) const -> bool;
+
+      /**
+       * @brief Equality operator.
+       */
+      auto operator==(const AVLmap_block_iterator_const& rhs) const -> bool;
+
+      friend AVLmap_block;
+    };
+
+  public:
+
+    // Rule of 5
+
+    /**
+     * @brief Constructor
+     */
+    AVLmap_block();
+
+    /**
+     * @brief Constructor with a comparator
+     * @param comp The comparator used to order the keys
+     */
+    explicit AVLmap_block(const Compare& comp);
+
+    /**
+     * @brief Copy Constructor (copies the structure of rhs)
+     */
+    AVLmap_block(const AVLmap_block& rhs);
+
+    /**
+     * @brief Copy Assignment Operator
+     */
+    auto operator=(const AVLmap_block& rhs) -> AVLmap_block&;
+
+    /**
+     * @brief Move Constructor
+     */
+    AVLmap_block(AVLmap_block&& rhs);
+
+    /**
+     * @brief Move Assignment Operator
+     */
+    auto operator=(AVLmap_block&& rhs) -> AVLmap_block&;
+
+    /**
+     * @brief Destructor
+     */
+    ~AVLmap_block();
+
+    /**
+     * @brief Getter for the size of the map
+     * @return The amount of keys in the map
+     */
+    auto size() const -> unsigned int;
+
+    /**
+     * @brief Indexer for the map
+     * @param key The key to search for (will create an entry if there isn't
+     * one)
+     * @return Reference to the value
+     */
+    auto operator[](const K& key) -> V&;
+
+    /**
+     * @brief Returns an iterator to the first key
+     */
+    auto begin() -> iterator;
+
+    /**
+     * @brief Returns an iterator to one past the last key
+     */
+    auto end() -> iterator;
+
+    /**
+     * @brief Returns a const iterator to the first key
+     */
+    auto begin() const -> const_iterator;
+
+    /**
+     * @brief Returns a const iterator to one past the last key
+     */
+    auto end() const -> const_iterator;
+
+    /**
+     * @brief Searches for a value using the key
+     * @param key The key to search for
+     * @return The iterator to the entry (or end if not found)
+     */
+    auto find(const K& key) -> iterator;
+
+    /**
+     * @brief Searches for a value using the key
+     * @param key The key to search for
+     * @return The iterator to the entry (or end if not found)
+     */
+    auto find(const K& key) const -> const_iterator;
+
+    /**
+     * @brief Erases the entry the iterator points to
+     */
+    auto erase(iterator it) -> void;
+
+    /**
+     * @brief Checks the links, the heights, the balances, the blocks and the
+     * order
+     * @return Whether the tree is a valid AVL tree of blocks
+     */
+    auto sanityCheck() const -> bool;
+
+    /**
+     * @brief Amount of bytes held by the map for its blocks
+     * @return The amount of bytes
+     */
+    auto bytes_reserved() const -> std::size_t;
+
+  private:
+
+    /**
+     * @brief A block with fewer keys than this after an erasure merges into
+     * a neighbour if they fit in one block.
+     */
+    static constexpr unsigned merge_below{block_size / 4};
+
+    /**
+     * @brief Whether the blocks can be searched with SSE2.
+     */
+    static constexpr bool sse2_keys{
+      AVLMAP_BLOCK_SSE2 && std::is_integral_v<K> && sizeof(K) == 4
+      && std::is_same_v<Compare, std::less<K>>
+    };
+
+    /**
+     * @brief Amount of keys of a block that are less than a key.
+     * @param block The block.
+     * @param key The key.
+     * @return The position the key has (or would have) in the block.
+     */
+    auto rank(const Block* block, const K& key) const -> unsigned;
+
+    /**
+     * @brief Searches for the block holding a key.
+     * @param key The key to search for.
+     * @param slot Set to the position of the key in the block.
+     * @return The block (nullptr if the key is not in the map).
+     */
+    auto search(const K& key, unsigned& slot) const -> Block*;
+
+    /**
+     * @brief Puts a new key with a default value in a block, splitting the
+     * block if it is full.
+     * @param block The block (the key belongs in it, or right before or
+     * after it if it has no child on that side), nullptr if the map is empty.
+     * @param slot The position of the key in the block.
+     * @param key The key.
+     * @return Reference to the value.
+     */
+    auto insert_at(Block* block, unsigned slot, const K& key) -> V&;
+
+    /**
+     * @brief Moves the last entries of a block to the end of another.
+     * @param to The block receiving them (with room for them).
+     * @param from The block they come from.
+     * @param first The position of the first entry moved.
+     */
+    static auto append(Block* to, Block* from, unsigned first) -> void;
+
+    /**
+     * @brief Links a new block as the in order successor of a block.
+     * @param block The block.
+     * @param fresh The new block.
+     */
+    auto attach_after(Block* block, Block* fresh) -> void;
+
+    /**
+     * @brief Links a new block as the in order predecessor of a block.
+     * @param block The block.
+     * @param fresh The new block.
+     */
+    auto attach_before(Block* block, Block* fresh) -> void;
+
+    /**
+     * @brief Moves the keys of a block that ran low into a neighbour if they
+     * fit, and unlinks the emptied block.
+     * @param block The block.
+     */
+    auto merge(Block* block) -> void;
+
+    /**
+     * @brief Takes a block out of the tree and destroys it.
+     * @param block The block.
+     */
+    auto unlink(Block* block) -> void;
+
+    /**
+     * @brief Getter for the height of a subtree.
+     * @param block The root of the subtree (can be nullptr).
+     * @return The height.
+     */
+    static auto height_of(const Block* block) -> int;
+
+    /**
+     * @brief Recomputes the height of a block from its children.
+     * @param block The block.
+     */
+    static auto update_height(Block* block) -> void;
+
+    /**
+     * @brief Puts a block in the place of a child of parent.
+     * @param parent The parent (nullptr to replace the root).
+     * @param child The child to replace.
+     * @param replacement The block that takes its place.
+     */
+    auto replace_child(Block* parent, Block* child, Block* replacement)
+      -> void;
+
+    /**
+     * @brief Left rotation about a block.
+     * @param block The block to rotate about.
+     * @return The block that took its place.
+     */
+    auto rotate_left(Block* block) -> Block*;
+
+    /**
+     * @brief Right rotation about a block.
+     * @param block The block to rotate about.
+     * @return The block that took its place.
+     */
+    auto rotate_right(Block* block) -> Block*;
+
+    /**
+     * @brief Updates the height of a block and rotates it if it is out of
+     * balance.
+     * @param block The block.
+     * @return The root of the subtree after the rotations.
+     */
+    auto rebalance(Block* block) -> Block*;
+
+    /**
+     * @brief Walks up from a block updating heights and rotating where
+     * needed, until a subtree keeps its height.
+     * @param block The lowest block whose subtree changed (can be nullptr).
+     */
+    auto retrace(Block* block) -> void;
+
+    /**
+     * @brief The block after a block in order (the first one for nullptr).
+     */
+    auto next_block(const Block* block) const -> Block*;
+
+    /**
+     * @brief The block before a block in order (the last one for nullptr).
+     */
+    auto previous_block(const Block* block) const -> Block*;
+
+    /**
+     * @brief Copies a subtree. If a copy throws, the blocks cloned so far are
+     * destroyed.
+     * @param source The subtree to copy.
+     * @param parent The parent of the copy.
+     * @return The copy.
+     */
+    auto clone(const Block* source, Block* parent) -> Block*;
+
+    /**
+     * @brief Checks a subtree.
+     * @param block The root of the subtree.
+     * @param parent The expected parent.
+     * @param count Incremented for every key visited.
+     * @return The height of the subtree (-1 if it is not valid).
+     */
+    auto check(const Block* block, const Block* parent, unsigned& count) const
+      -> int;
+
+    /**
+     * @brief Destroys every block.
+     */
+    auto clear() -> void;
+
+    /**
+     * @brief Destroys every block of a subtree (its parent is left alone).
+     * @param block The root of the subtree.
+     */
+    auto destroy(Block* block) -> void;
+
+    /**
+     * @brief The comparator used to order the keys.
+     */
+    Compare comp{};
+
+    /**
+     * @brief The root of the tree.
+     */
+    Block* root{nullptr};
+
+    /**
+     * @brief The amount of keys in the map.
+     */
+    unsigned size_{0};
+
+    /**
+     * @brief The amount of blocks in the tree.
+     */
+    std::size_t blocks{0};
+  };
+} // namespace CS280
+
+  #ifndef AVLMAPBLOCK_CPP
+    #include "avl-map-block.cpp"
+  #endif
+
+#endif
@@ -0,0 +1,853 @@
+/**
+ * @file avl-map-compact.cpp
+ * @author Edgar Jose Donoso Mansilla (e.donosomansilla)
+ * @course CS280
+ * @term Spring 2025
+ *
+ * @brief Implementation for the AVL map with a compact node layout
+ */
+
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#define AVLMAPCOMPACT_CPP
+
+#ifndef AVLMAPCOMPACT_H
+  #include "avl-map-compact.h"
+#endif
+
+namespace CS280 {
+
+  /// AVL Methods
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_compact<K, V, Compare>::AVLmap_compact():
+      chunks(), free_slots() {}
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_compact<K, V, Compare>::AVLmap_compact(const Compare& comp):
+      comp(comp), chunks(), free_slots() {}
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_compact<K, V, Compare>::AVLmap_compact(const AVLmap_compact& rhs):
+      comp(rhs.comp), chunks(), free_slots(), size_(0) {
+    try {
+      root = clone(rhs, rhs.root, 0);
+    } catch (...) {
+      clear();
+      throw;
+    }
+
+    size_ = rhs.size_;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::operator=(const AVLmap_compact& rhs)
+    -> AVLmap_compact& {
+    if (this == &rhs) {
+      return *this;
+    }
+
+    clear();
+
+    comp = rhs.comp;
+    try {
+      root = clone(rhs, rhs.root, 0);
+    } catch (...) {
+      clear();
+      throw;
+    }
+
+    size_ = rhs.size_;
+    return *this;
+  }
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_compact<K, V, Compare>::AVLmap_compact(AVLmap_compact&& rhs):
+      comp(std::move(rhs.comp)),
+      chunks(std::move(rhs.chunks)),
+      free_slots(std::move(rhs.free_slots)),
+      next_slot(std::exchange(rhs.next_slot, 1)),
+      root(std::exchange(rhs.root, 0)),
+      size_(std::exchange(rhs.size_, 0)) {
+    rhs.chunks.clear();
+    rhs.free_slots.clear();
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::operator=(AVLmap_compact&& rhs)
+    -> AVLmap_compact& {
+    if (this == &rhs) {
+      return *this;
+    }
+
+    clear();
+
+    comp = std::move(rhs.comp);
+    chunks = std::move(rhs.chunks);
+    free_slots = std::move(rhs.free_slots);
+    next_slot = std::exchange(rhs.next_slot, 1);
+    root = std::exchange(rhs.root, 0);
+    size_ = std::exchange(rhs.size_, 0);
+
+    rhs.chunks.clear();
+    rhs.free_slots.clear();
+
+    return *this;
+  }
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_compact<K, V, Compare>::~AVLmap_compact() {
+    clear();
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::size() const -> unsigned int {
+    return size_;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::operator[](const K& key) -> V& {
+    std::uint32_t parent = 0;
+    std::uint32_t candidate = 0;
+    bool as_left = false;
+
+    for (std::uint32_t current = root; current != 0;) {
+      parent = current;
+      as_left = comp(key, node(current).key);
+
+      if (as_left) {
+        current = node(current).left;
+      } else {
+        candidate = current;
+        current = node(current).right;
+      }
+    }
+
+    if (candidate != 0 && !comp(node(candidate).key, key)) {
+      return node(candidate).value;
+    }
+
+    std::uint32_t index = create_node(key);
+    node(index).set_parent(parent);
+
+    if (parent == 0) {
+      root = index;
+    } else if (as_left) {
+      node(parent).left = index;
+    } else {
+      node(parent).right = index;
+    }
+
+    size_++;
+    retrace_insert(index);
+
+    return node(index).value;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::begin() -> iterator {
+    return ++iterator(this, 0);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::end() -> iterator {
+    return iterator(this, 0);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::begin() const -> const_iterator {
+    return ++const_iterator(this, 0);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::end() const -> const_iterator {
+    return const_iterator(this, 0);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::find(const K& key) -> iterator {
+    return iterator(this, search(key));
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::find(const K& key) const
+    -> const_iterator {
+    return const_iterator(this, search(key));
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::erase(iterator it) -> void {
+    std::uint32_t erased = it.index;
+    if (erased == 0) {
+      return;
+    }
+
+    Node& target = node(erased);
+    std::uint32_t parent = target.parent();
+
+    if (target.left == 0 || target.right == 0) {
+      std::uint32_t child = target.left != 0 ? target.left : target.right;
+      bool from_left = parent != 0 && node(parent).left == erased;
+
+      replace_child(parent, erased, child);
+      if (child != 0) {
+        node(child).set_parent(parent);
+      }
+
+      size_--;
+      if (parent != 0) {
+        retrace_erase(parent, from_left);
+      }
+
+      destroy_node(erased);
+      return;
+    }
+
+    // The predecessor is spliced into the place of the node, keeping the
+    // balance of the node
+    std::uint32_t predecessor = target.left;
+    while (node(predecessor).right != 0) {
+      predecessor = node(predecessor).right;
+    }
+
+    Node& moved = node(predecessor);
+    std::uint32_t lowest_changed = predecessor;
+    bool from_left = true;
+
+    if (predecessor != target.left) {
+      lowest_changed = moved.parent();
+      from_left = false;
+
+      node(lowest_changed).right = moved.left;
+      if (moved.left != 0) {
+        node(moved.left).set_parent(lowest_changed);
+      }
+
+      moved.left = target.left;
+      node(moved.left).set_parent(predecessor);
+    }
+
+    moved.right = target.right;
+    node(moved.right).set_parent(predecessor);
+    moved.parent_balance = target.parent_balance;
+    replace_child(parent, erased, predecessor);
+
+    size_--;
+    retrace_erase(lowest_changed, from_left);
+
+    destroy_node(erased);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::sanityCheck() const -> bool {
+    unsigned count = 0;
+    if (check(root, 0, count) < 0 || count != size_) {
+      return false;
+    }
+
+    if (root == 0) {
+      return true;
+    }
+
+    const_iterator previous = begin();
+    for (const_iterator it = ++begin(); it != end(); ++it, ++previous) {
+      if (!comp(previous->key, it->key)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::bytes_reserved() const -> std::size_t {
+    return chunks.size() * chunk_size * sizeof(Node)
+           + chunks.capacity() * sizeof(Node*)
+           + free_slots.capacity() * sizeof(std::uint32_t);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::node(std::uint32_t index) -> Node& {
+    return chunks[index >> chunk_bits][index & (chunk_size - 1)];
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::node(std::uint32_t index) const
+    -> const Node& {
+    return chunks[index >> chunk_bits][index & (chunk_size - 1)];
+  }
+
+  template<typename K, typename V, typename Compare>
+  template<typename KeyArg, typename... Args>
+  auto AVLmap_compact<K, V, Compare>::create_node(
+    KeyArg&& key,
+    Args&&... args
+  ) -> std::uint32_t {
+    std::uint32_t index = 0;
+
+    if (!free_slots.empty()) {
+      index = free_slots.back();
+      free_slots.pop_back();
+    } else {
+      if (next_slot > max_index) {
+        throw std::length_error("AVLmap_compact: too many nodes");
+      }
+
+      if ((next_slot >> chunk_bits) == chunks.size()) {
+        chunks.push_back(std::allocator<Node>().allocate(chunk_size));
+      }
+
+      index = next_slot++;
+    }
+
+    Node* memory = chunks[index >> chunk_bits] + (index & (chunk_size - 1));
+
+    try {
+      new (memory)
+        Node(std::forward<KeyArg>(key), std::forward<Args>(args)...);
+    } catch (...) {
+      free_slots.push_back(index);
+      throw;
+    }
+
+    return index;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::destroy_node(std::uint32_t index)
+    -> void {
+    node(index).~Node();
+    free_slots.push_back(index);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::clear() -> void {
+    destroy_subtree(root);
+
+    for (Node* chunk: chunks) {
+      std::allocator<Node>().deallocate(chunk, chunk_size);
+    }
+
+    chunks.clear();
+    free_slots.clear();
+    next_slot = 1;
+    root = 0;
+    size_ = 0;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::destroy_subtree(std::uint32_t index)
+    -> void {
+    if (std::is_trivially_destructible<Node>::value || index == 0) {
+      return;
+    }
+
+    std::vector<std::uint32_t> pending{index};
+
+    while (!pending.empty()) {
+      Node& current = node(pending.back());
+      pending.pop_back();
+
+      if (current.left != 0) {
+        pending.push_back(current.left);
+      }
+
+      if (current.right != 0) {
+        pending.push_back(current.right);
+      }
+
+      current.~Node();
+    }
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::clone(
+    const AVLmap_compact& rhs,
+    std::uint32_t source,
+    std::uint32_t parent
+  ) -> std::uint32_t {
+    if (source == 0) {
+      return 0;
+    }
+
+    const Node& original = rhs.node(source);
+    std::uint32_t index = create_node(original.key, original.value);
+
+    // Chunks never move, so the reference survives the recursive calls
+    Node& copy = node(index);
+    copy.parent_balance = original.parent_balance;
+    copy.set_parent(parent);
+
+    // A failed child cleaned up after itself, what was cloned so far hangs
+    // from copy
+    try {
+      copy.left = clone(rhs, original.left, index);
+      copy.right = clone(rhs, original.right, index);
+    } catch (...) {
+      destroy_subtree(index);
+      throw;
+    }
+
+    return index;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::search(const K& key) const
+    -> std::uint32_t {
+    std::uint32_t candidate = 0;
+
+    for (std::uint32_t current = root; current != 0;) {
+      const Node& visited = node(current);
+
+      if (comp(key, visited.key)) {
+        current = visited.left;
+      } else {
+        candidate = current;
+        current = visited.right;
+      }
+    }
+
+    if (candidate == 0 || comp(node(candidate).key, key)) {
+      return 0;
+    }
+
+    return candidate;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::replace_child(
+    std::uint32_t parent,
+    std::uint32_t child,
+    std::uint32_t replacement
+  ) -> void {
+    if (parent == 0) {
+      root = replacement;
+    } else if (node(parent).left == child) {
+      node(parent).left = replacement;
+    } else {
+      node(parent).right = replacement;
+    }
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::rotate_left(std::uint32_t index)
+    -> std::uint32_t {
+    Node& demoted = node(index);
+    std::uint32_t promoted_index = demoted.right;
+    Node& promoted = node(promoted_index);
+    std::uint32_t parent = demoted.parent();
+
+    demoted.right = promoted.left;
+    if (promoted.left != 0) {
+      node(promoted.left).set_parent(index);
+    }
+
+    promoted.left = index;
+    demoted.set_parent(promoted_index);
+    promoted.set_parent(parent);
+    replace_child(parent, index, promoted_index);
+
+    return promoted_index;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::rotate_right(std::uint32_t index)
+    -> std::uint32_t {
+    Node& demoted = node(index);
+    std::uint32_t promoted_index = demoted.left;
+    Node& promoted = node(promoted_index);
+    std::uint32_t parent = demoted.parent();
+
+    demoted.left = promoted.right;
+    if (promoted.right != 0) {
+      node(promoted.right).set_parent(index);
+    }
+
+    promoted.right = index;
+    demoted.set_parent(promoted_index);
+    promoted.set_parent(parent);
+    replace_child(parent, index, promoted_index);
+
+    return promoted_index;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::fix_balance(
+    std::uint32_t index,
+    int balance,
+    bool& height_changed
+  ) -> std::uint32_t {
+    // Without heights the new balances follow from the balance of the heavy
+    // child (and of its inner child for the double rotations)
+    if (balance > 0) {
+      std::uint32_t heavy = node(index).right;
+      int heavy_balance = node(heavy).balance();
+
+      if (heavy_balance >= 0) {
+        rotate_left(index);
+        node(index).set_balance(heavy_balance == 0 ? 1 : 0);
+        node(heavy).set_balance(heavy_balance == 0 ? -1 : 0);
+        height_changed = heavy_balance != 0;
+        return heavy;
+      }
+
+      std::uint32_t inner = node(heavy).left;
+      int inner_balance = node(inner).balance();
+      rotate_right(heavy);
+      rotate_left(index);
+      node(index).set_balance(inner_balance > 0 ? -1 : 0);
+      node(heavy).set_balance(inner_balance < 0 ? 1 : 0);
+      node(inner).set_balance(0);
+      height_changed = true;
+      return inner;
+    }
+
+    std::uint32_t heavy = node(index).left;
+    int heavy_balance = node(heavy).balance();
+
+    if (heavy_balance <= 0) {
+      rotate_right(index);
+      node(index).set_balance(heavy_balance == 0 ? -1 : 0);
+      node(heavy).set_balance(heavy_balance == 0 ? 1 : 0);
+      height_changed = heavy_balance != 0;
+      return heavy;
+    }
+
+    std::uint32_t inner = node(heavy).right;
+    int inner_balance = node(inner).balance();
+    rotate_left(heavy);
+    rotate_right(index);
+    node(index).set_balance(inner_balance < 0 ? 1 : 0);
+    node(heavy).set_balance(inner_balance > 0 ? -1 : 0);
+    node(inner).set_balance(0);
+    height_changed = true;
+    return inner;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::retrace_insert(std::uint32_t index)
+    -> void {
+    std::uint32_t child = index;
+    std::uint32_t current = node(index).parent();
+
+    while (current != 0) {
+      Node& visited = node(current);
+      int balance = visited.balance() + (visited.left == child ? -1 : 1);
+
+      // The subtree kept its height
+      if (balance == 0) {
+        visited.set_balance(0);
+        return;
+      }
+
+      // A rotation after an insertion always restores the old height
+      if (balance < -1 || balance > 1) {
+        bool height_changed = false;
+        fix_balance(current, balance, height_changed);
+        return;
+      }
+
+      visited.set_balance(balance);
+      child = current;
+      current = visited.parent();
+    }
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::retrace_erase(
+    std::uint32_t index,
+    bool from_left
+  ) -> void {
+    std::uint32_t current = index;
+
+    while (current != 0) {
+      Node& visited = node(current);
+      std::uint32_t parent = visited.parent();
+      int balance = visited.balance() + (from_left ? 1 : -1);
+
+      // The subtree kept its height
+      if (balance == -1 || balance == 1) {
+        visited.set_balance(balance);
+        return;
+      }
+
+      if (balance == 0) {
+        visited.set_balance(0);
+      } else {
+        bool height_changed = false;
+        current = fix_balance(current, balance, height_changed);
+        if (!height_changed) {
+          return;
+        }
+      }
+
+      // The subtree got shorter, so its parent lost height on this side
+      if (parent != 0) {
+        from_left = node(parent).left == current;
+      }
+      current = parent;
+    }
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::check(
+    std::uint32_t index,
+    std::uint32_t parent,
+    unsigned& count
+  ) const -> int {
+    if (index == 0) {
+      return 0;
+    }
+
+    const Node& visited = node(index);
+    count++;
+
+    // The count guards against cycles
+    if (visited.parent() != parent || count > size_) {
+      return -1;
+    }
+
+    int height_l = check(visited.left, index, count);
+    int height_r = height_l < 0 ? -1 : check(visited.right, index, count);
+
+    if (height_r < 0 || height_r - height_l != visited.balance()) {
+      return -1;
+    }
+
+    return std::max(height_l, height_r) + 1;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::increment(std::uint32_t index) const
+    -> std::uint32_t {
+    if (index == 0) {
+      index = root;
+      while (index != 0 && node(index).left != 0) {
+        index = node(index).left;
+      }
+      return index;
+    }
+
+    if (node(index).right != 0) {
+      index = node(index).right;
+      while (node(index).left != 0) {
+        index = node(index).left;
+      }
+      return index;
+    }
+
+    std::uint32_t parent = node(index).parent();
+    while (parent != 0 && node(parent).right == index) {
+      index = parent;
+      parent = node(parent).parent();
+    }
+
+    return parent;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::decrement(std::uint32_t index) const
+    -> std::uint32_t {
+    if (index == 0) {
+      index = root;
+      while (index != 0 && node(index).right != 0) {
+        index = node(index).right;
+      }
+      return index;
+    }
+
+    if (node(index).left != 0) {
+      index = node(index).left;
+      while (node(index).right != 0) {
+        index = node(index).right;
+      }
+      return index;
+    }
+
+    std::uint32_t parent = node(index).parent();
+    while (parent != 0 && node(parent).left == index) {
+      index = parent;
+      parent = node(parent).parent();
+    }
+
+    return parent;
+  }
+
+  /// Node Methods
+
+  template<typename K, typename V, typename Compare>
+  template<typename KeyArg, typename... Args>
+  AVLmap_compact<K, V, Compare>::Node::Node(KeyArg&& k, Args&&... args):
+      key(std::forward<KeyArg>(k)), value(std::forward<Args>(args)...) {}
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::Node::Key() const -> const K& {
+    return key;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::Node::Value() -> V& {
+    return value;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::Node::Value() const -> const V& {
+    return value;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::Node::parent() const -> std::uint32_t {
+    return parent_balance >> 2;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::Node::set_parent(std::uint32_t index)
+    -> void {
+    parent_balance = (index << 2) | (parent_balance & 3u);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::Node::balance() const -> int {
+    return static_cast<int>(parent_balance & 3u) - 1;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::Node::set_balance(int b) -> void {
+    parent_balance = (parent_balance & ~3u) | static_cast<std::uint32_t>(b + 1);
+  }
+
+  /// Iterator Methods
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_compact<K, V, Compare>::AVLmap_compact_iterator::
+    AVLmap_compact_iterator(AVLmap_compact* m, std::uint32_t i):
+      map(m), index(i) {}
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_compact<K, V, Compare>::AVLmap_compact_iterator::
+  operator AVLmap_compact_iterator_const() const {
+    return AVLmap_compact_iterator_const(map, index);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::AVLmap_compact_iterator::operator++()
+    -> AVLmap_compact_iterator& {
+    index = map->increment(index);
+    return *this;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::AVLmap_compact_iterator::operator++(int)
+    -> AVLmap_compact_iterator {
+    AVLmap_compact_iterator previous = *this;
+    index = map->increment(index);
+    return previous;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::AVLmap_compact_iterator::operator--()
+    -> AVLmap_compact_iterator& {
+    index = map->decrement(index);
+    return *this;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::AVLmap_compact_iterator::operator--(int)
+    -> AVLmap_compact_iterator {
+    AVLmap_compact_iterator previous = *this;
+    index = map->decrement(index);
+    return previous;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::AVLmap_compact_iterator::operator*()
+    const -> Node& {
+    return map->node(index);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::AVLmap_compact_iterator::operator->()
+    const -> Node* {
+    return &map->node(index);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::AVLmap_compact_iterator::operator!=(
+    const AVLmap_compact_iterator& rhs
+  ) const -> bool {
+    return index != rhs.index;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::AVLmap_compact_iterator::operator==(
+    const AVLmap_compact_iterator& rhs
+  ) const -> bool {
+    return index == rhs.index;
+  }
+
+  /// Const Iterator Methods
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_compact<K, V, Compare>::AVLmap_compact_iterator_const::
+    AVLmap_compact_iterator_const(const AVLmap_compact* m, std::uint32_t i):
+      map(m), index(i) {}
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::AVLmap_compact_iterator_const::
+  operator++() -> AVLmap_compact_iterator_const& {
+    index = map->increment(index);
+    return *this;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::AVLmap_compact_iterator_const::
+  operator++(int) -> AVLmap_compact_iterator_const {
+    AVLmap_compact_iterator_const previous = *this;
+    index = map->increment(index);
+    return previous;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::AVLmap_compact_iterator_const::
+  operator--() -> AVLmap_compact_iterator_const& {
+    index = map->decrement(index);
+    return *this;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::AVLmap_compact_iterator_const::
+  operator--(int) -> AVLmap_compact_iterator_const {
+    AVLmap_compact_iterator_const previous = *this;
+    index = map->decrement(index);
+    return previous;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::AVLmap_compact_iterator_const::
+  operator*() const -> const Node& {
+    return map->node(index);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::AVLmap_compact_iterator_const::
+  operator->() const -> const Node* {
+    return &map->node(index);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::AVLmap_compact_iterator_const::
+  operator!=(const AVLmap_compact_iterator_const& rhs) const -> bool {
+    return index != rhs.index;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_compact<K, V, Compare>::AVLmap_compact_iterator_const::
+  operator==(const AVLmap_compact_iterator_const& rhs) const -> bool {
+    return index == rhs.index;
+  }
+} // namespace CS280
@@ -0,0 +1,585 @@
+/**
+ * @file avl-map-compact.h
+ * @author Edgar Jose Donoso Mansilla (e.donosomansilla)
+ * @course CS280
+ * @term Spring 2025
+ *
+ * @brief AVL map with a compact node layout (32-bit links, no heights)
+ */
+
+#ifndef AVLMAPCOMPACT_H
+  #define AVLMAPCOMPACT_H
+
+  #include <cstdint>
+  #include <functional>
+  #include <vector>
+
+namespace CS280 {
+
+  /**
+   * @brief AVL map that keeps its nodes in an array of chunks and links them
+   * with 32-bit indices. Nodes store no height, only a balance of -1, 0 or 1
+   * that lives in the two low bits of the parent index, so a node is the key,
+   * the value and three 32-bit words (20 bytes for <int,int>).
+   *
+   * It holds at most 2^30 - 1 nodes. Iterators stay valid until their node is
+   * erased (nodes are never moved).
+   *
+   * @param K The type for the key to be used
+   * @param V The type for the values to be used
+   * @param Compare The strict weak ordering of the keys
+   */
+  template<typename K, typename V, typename Compare = std::less<K>>
+  class AVLmap_compact {
+
+    // Forward declarations for the struct
+    struct AVLmap_compact_iterator;
+    struct AVLmap_compact_iterator_const;
+
+  public:
+
+    // standard names for iterator types
+    typedef AVLmap_compact_iterator iterator;
+    typedef AVLmap_compact_iterator_const const_iterator;
+
+    /**
+     * @brief This class represents a Node in the map. Links are indices into
+     * the chunks of the map, 0 meaning no node.
+     */
+    class Node {
+    public:
+
+      /**
+       * @brief Constructor for an unlinked leaf that builds the key and the
+       * value in place.
+       *
+       * @param k The argument to construct the key from.
+       * @param args The arguments to construct the value from.
+       */
+      template<typename KeyArg, typename... Args>
+      Node(KeyArg&& k, Args&&... args);
+
+      // Deleted copy constructor
+      Node(const Node&) = delete;
+
+      // Deleted copy assignment operator
+      auto operator=(const Node&) -> Node& = delete;
+
+      /**
+       * @brief Getter of a reference to the key of this node.
+       * @return Const reference to the key.
+       */
+      auto Key() const -> const K&;
+
+      /**
+       * @brief Getter of a reference to the value of this node.
+       * @return Reference to the value.
+       */
+      auto Value() -> V&;
+
+      /**
+       * @brief Getter of a reference to the value of this node.
+       * @return Reference to the value.
+       */
+      auto Value() const -> const V&;
+
+    private:
+
+      /**
+       * @brief Getter for the index of the parent.
+       * @return The index of the parent (0 for the root).
+       */
+      auto parent() const -> std::uint32_t;
+
+      /**
+       * @brief Setter for the index of the parent (keeps the balance).
+       * @param index The index of the parent.
+       */
+      auto set_parent(std::uint32_t index) -> void;
+
+      /**
+       * @brief Getter for the balance (height of the right subtree minus
+       * height of the left one).
+       * @return The balance.
+       */
+      auto balance() const -> int;
+
+      /**
+       * @brief Setter for the balance (keeps the parent).
+       * @param b The balance (-1, 0 or 1).
+       */
+      auto set_balance(int b) -> void;
+
+      /**
+       * @brief The key of this node.
+       */
+      K key;
+
+      /**
+       * @brief The value that is being held by the node.
+       */
+      V value;
+
+      /**
+       * @brief Index of the left child.
+       */
+      std::uint32_t left{0};
+
+      /**
+       * @brief Index of the right child.
+       */
+      std::uint32_t right{0};
+
+      /**
+       * @brief Index of the parent shifted left by two, plus the balance + 1.
+       */
+      std::uint32_t parent_balance{1};
+
+      // Friending the map class so the internals can be accessed.
+      friend AVLmap_compact;
+    };
+
+  private:
+
+    /**
+     * @brief This class is the non const iterator of the map
+     */
+    struct AVLmap_compact_iterator {
+    private:
+
+      /**
+       * @brief The map the node belongs to.
+       */
+      AVLmap_compact* map;
+
+      /**
+       * @brief Index of the iterator's node (0 for end).
+       */
+      std::uint32_t index;
+
+    public:
+
+      /**
+       * @brief Constructor for the iterator
+       * @param m The map
+       * @param i Index of the node
+       */
+      AVLmap_compact_iterator(AVLmap_compact* m = nullptr, std::uint32_t i = 0);
+
+      /**
+       * @brief Conversion operator into const
+       */
+      operator AVLmap_compact_iterator_const() const;
+
+      /**
+       * @brief Pre-increment operator (successor)
+       */
+      auto operator++() -> AVLmap_compact_iterator&;
+
+      /**
+       * @brief Post-increment operator (successor)
+       */
+      auto operator++(int) -> AVLmap_compact_iterator;
+
+      /**
+       * @brief Pre-decrement operator (predecessor)
+       */
+      auto operator--() -> AVLmap_compact_iterator&;
+
+      /**
+       * @brief Post-decrement operator (predecessor)
+       */
+      auto operator--(int) -> AVLmap_compact_iterator;
+
+      /**
+       * @brief Dereferencing operator.
+       * @return Reference to the node.
+       */
+      auto operator*() const -> Node&;
+
+      /**
+       * @brief Arrow operator.
+       * @return Pointer to the node.
+       */
+      auto operator->() const -> Node*;
+
+      /**
+       * @brief Inequality operator.
+       */
+      auto operator!=(const AVLmap_compact_iterator& rhs) const -> bool;
+
+      /**
+       * @brief Equality operator.
+       */
+      auto operator==(const AVLmap_compact_iterator& rhs) const -> bool;
+
+      friend AVLmap_compact;
+    };
+
+    /**
+     * @brief This class is the const iterator of the map
+     */
+    struct AVLmap_compact_iterator_const {
+    private:
+
+      /**
+       * @brief The map the node belongs to.
+       */
+      const AVLmap_compact* map;
+
+      /**
+       * @brief Index of the iterator's node (0 for end).
+       */
+      std::uint32_t index;
+
+    public:
+
+      /**
+       * @brief Constructor for the iterator
+       * @param m The map
+       * @param i Index of the node
+       */
+      AVLmap_compact_iterator_const(
+        const AVLmap_compact* m = nullptr,
+        std::uint32_t i = 0
+      );
+
+      /**
+       * @brief Pre-increment operator (successor)
+       */
+      auto operator++() -> AVLmap_compact_iterator_const&;
+
+      /**
+       * @brief Post-increment operator (successor)
+       */
+      auto operator++(int) -> AVLmap_compact_iterator_const;
+
+      /**
+       * @brief Pre-decrement operator (predecessor)
+       */
+      auto operator--() -> AVLmap_compact_iterator_const&;
+
+      /**
+       * @brief Post-decrement operator (predecessor)
+       */
+      auto operator--(int) -> AVLmap_compact_iterator_const;
+
+      /**
+       * @brief Dereferencing operator.
+       * @return Reference to the node.
+       */
+      auto operator*() const -> const Node&;
+
+      /**
+       * @brief Arrow operator.
+       * @return Pointer to the node.
+       */
+      auto operator->() const -> const Node*;
+
+      /**
+       * @brief Inequality operator.
+       */
+      auto operator!=(const AVLmap_compact_iterator_const& rhs) const -> bool;
+
+      /**
+       * @brief Equality operator.
+       */
+      auto operator==(const AVLmap_compact_iterator_const& rhs) const -> bool;
+
+      friend AVLmap_compact;
+    };
+
+  public:
+
+    // Rule of 5
+
+    /**
+     * @brief Constructor
+     */
+    AVLmap_compact();
+
+    /**
+     * @brief Constructor with a comparator
+     * @param comp The comparator used to order the keys
+     */
+    explicit AVLmap_compact(const Compare& comp);
+
+    /**
+     * @brief Copy Constructor (copies the structure of rhs)
+     */
+    AVLmap_compact(const AVLmap_compact& rhs);
+
+    /**
+     * @brief Copy Assignment Operator
+     */
+    auto operator=(const AVLmap_compact& rhs) -> AVLmap_compact&;
+
+    /**
+     * @brief Move Constructor
+     */
+    AVLmap_compact(AVLmap_compact&& rhs);
+
+    /**
+     * @brief Move Assignment Operator
+     */
+    auto operator=(AVLmap_compact&& rhs) -> AVLmap_compact&;
+
+    /**
+     * @brief Destructor
+     */
+    ~AVLmap_compact();
+
+    /**
+     * @brief Getter for the size of the map
+     * @return The amount of nodes in the map
+     */
+    auto size() const -> unsigned int;
+
+    /**
+     * @brief Indexer for the map
+     * @param key The key to search for (will create a node if there isn't one)
+     * @return Reference to the value
+     */
+    auto operator[](const K& key) -> V&;
+
+    /**
+     * @brief Returns an iterator to the first node of the tree
+     */
+    auto begin() -> iterator;
+
+    /**
+     * @brief Returns an iterator to one past the last node of the tree
+     */
+    auto end() -> iterator;
+
+    /**
+     * @brief Returns a const iterator to the first node of the tree
+     */
+    auto begin() const -> const_iterator;
+
+    /**
+     * @brief Returns a const iterator to one past the last node of the tree
+     */
+    auto end() const -> const_iterator;
+
+    /**
+     * @brief Searches for a value using the key
+     * @param key The key to search for
+     * @return The iterator to the node (or end if not found)
+     */
+    auto find(const K& key) -> iterator;
+
+    /**
+     * @brief Searches for a value using the key
+     * @param key The key to search for
+     * @return The iterator to the node (or end if not found)
+     */
+    auto find(const K& key) const -> const_iterator;
+
+    /**
+     * @brief Erases the node the iterator points to. Nodes are relinked, never
+     * moved, so every other iterator stays valid
+     */
+    auto erase(iterator it) -> void;
+
+    /**
+     * @brief Checks that the links, the order and the balances are right
+     * @return Whether the tree is a valid AVL tree
+     */
+    auto sanityCheck() const -> bool;
+
+    /**
+     * @brief Amount of bytes held by the map for its nodes and bookkeeping
+     * @return The amount of bytes
+     */
+    auto bytes_reserved() const -> std::size_t;
+
+  private:
+
+    /**
+     * @brief Amount of bits of an index used for the position in a chunk.
+     */
+    static constexpr std::uint32_t chunk_bits{14};
+
+    /**
+     * @brief Amount of nodes in a chunk.
+     */
+    static constexpr std::uint32_t chunk_size{1u << chunk_bits};
+
+    /**
+     * @brief Largest index that fits next to the balance.
+     */
+    static constexpr std::uint32_t max_index{(1u << 30) - 1};
+
+    /**
+     * @brief Getter for a node from its index.
+     * @param index The index of the node (not 0).
+     * @return Reference to the node.
+     */
+    auto node(std::uint32_t index) -> Node&;
+
+    /**
+     * @brief Getter for a node from its index.
+     * @param index The index of the node (not 0).
+     * @return Reference to the node.
+     */
+    auto node(std::uint32_t index) const -> const Node&;
+
+    /**
+     * @brief Constructs a node in a free slot.
+     * @param key The argument to construct the key from.
+     * @param args The arguments to construct the value from.
+     * @return The index of the node.
+     */
+    template<typename KeyArg, typename... Args>
+    auto create_node(KeyArg&& key, Args&&... args) -> std::uint32_t;
+
+    /**
+     * @brief Destroys a node and frees its slot.
+     * @param index The index of the node.
+     */
+    auto destroy_node(std::uint32_t index) -> void;
+
+    /**
+     * @brief Destroys every node and gives back every chunk.
+     */
+    auto clear() -> void;
+
+    /**
+     * @brief Destroys every node of a subtree, leaving their slots to be
+     * given back with the chunks.
+     * @param index The index of the subtree root.
+     */
+    auto destroy_subtree(std::uint32_t index) -> void;
+
+    /**
+     * @brief Copies a subtree of another map. If a copy throws, the nodes
+     * cloned so far are destroyed (clear() gives back their slots).
+     * @param rhs The map to copy from.
+     * @param source The index of the subtree root in rhs.
+     * @param parent The index of the parent of the copy.
+     * @return The index of the copy.
+     */
+    auto clone(
+      const AVLmap_compact& rhs,
+      std::uint32_t source,
+      std::uint32_t parent
+    ) -> std::uint32_t;
+
+    /**
+     * @brief Searches for the node holding a key.
+     * @param key The key to search for.
+     * @return The index of the node (0 if there is none).
+     */
+    auto search(const K& key) const -> std::uint32_t;
+
+    /**
+     * @brief Puts a node in the place of a child of parent.
+     * @param parent The parent (0 to replace the root).
+     * @param child The child to replace.
+     * @param replacement The node that takes its place.
+     */
+    auto replace_child(
+      std::uint32_t parent,
+      std::uint32_t child,
+      std::uint32_t replacement
+    ) -> void;
+
+    /**
+     * @brief Left rotation about a node (balances are not updated).
+     * @param index The node to rotate about.
+     * @return The node that took its place.
+     */
+    auto rotate_left(std::uint32_t index) -> std::uint32_t;
+
+    /**
+     * @brief Right rotation about a node (balances are not updated).
+     * @param index The node to rotate about.
+     * @return The node that took its place.
+     */
+    auto rotate_right(std::uint32_t index) -> std::uint32_t;
+
+    /**
+     * @brief Rotates a node whose balance would be -2 or 2 (which does not
+     * fit in the node) back into shape.
+     * @param index The node to fix.
+     * @param balance The balance it would have.
+     * @param height_changed Set to whether the subtree got shorter than it
+     * was before the fix.
+     * @return The root of the fixed subtree.
+     */
+    auto fix_balance(std::uint32_t index, int balance, bool& height_changed)
+      -> std::uint32_t;
+
+    /**
+     * @brief Walks up from a new leaf updating balances until a subtree keeps
+     * its height.
+     * @param index The new leaf.
+     */
+    auto retrace_insert(std::uint32_t index) -> void;
+
+    /**
+     * @brief Walks up from a node whose subtree got shorter on one side
+     * updating balances until a subtree keeps its height.
+     * @param index The node.
+     * @param from_left Whether the shorter side is the left one.
+     */
+    auto retrace_erase(std::uint32_t index, bool from_left) -> void;
+
+    /**
+     * @brief Checks a subtree.
+     * @param index The root of the subtree.
+     * @param parent The expected parent.
+     * @param count Incremented for every node visited.
+     * @return The height of the subtree (-1 if it is not valid).
+     */
+    auto check(std::uint32_t index, std::uint32_t parent, unsigned& count)
+      const -> int;
+
+    /**
+     * @brief Index of the successor of a node (0 if there is none).
+     */
+    auto increment(std::uint32_t index) const -> std::uint32_t;
+
+    /**
+     * @brief Index of the predecessor of a node (the last node for 0).
+     */
+    auto decrement(std::uint32_t index) const -> std::uint32_t;
+
+    /**
+     * @brief The comparator used to order the keys.
+     */
+    Compare comp{};
+
+    /**
+     * @brief The chunks holding the nodes (slot 0 is never used).
+     */
+    std::vector<Node*> chunks;
+
+    /**
+     * @brief Slots freed by erase, reused by later inserts.
+     */
+    std::vector<std::uint32_t> free_slots;
+
+    /**
+     * @brief The first slot that has never been used.
+     */
+    std::uint32_t next_slot{1};
+
+    /**
+     * @brief Index of the root (0 if the map is empty).
+     */
+    std::uint32_t root{0};
+
+    /**
+     * @brief The amount of nodes in the map.
+     */
+    unsigned size_{0};
+  };
+} // namespace CS280
+
+  #ifndef AVLMAPCOMPACT_CPP
+    #include "avl-map-compact.cpp"
+  #endif
+
+#endif
@@ -0,0 +1,273 @@
+/**
+ * @file avl-map-concurrent.cpp
+ * @author Edgar Jose Donoso Mansilla (e.donosomansilla)
+ * @course CS280
+ * @term Spring 2025
+ *
+ * @brief Implementation for the thread safe front end of a map
+ */
+
+#include <algorithm>
+
+#define AVLMAPCONCURRENT_CPP
+
+#ifndef AVLMAPCONCURRENT_H
+  #include "avl-map-concurrent.h"
+#endif
+
+namespace CS280 {
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap_concurrent<K, V, Compare, Pool>::AVLmap_concurrent(): map() {}
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap_concurrent<K, V, Compare, Pool>::AVLmap_concurrent(map_type m):
+      map(std::move(m)) {}
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_concurrent<K, V, Compare, Pool>::size() const -> unsigned int {
+    std::shared_lock<std::shared_mutex> lock = lock_shared();
+
+    // size() only reads, it is just not marked const
+    return const_cast<map_type&>(map).size();
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_concurrent<K, V, Compare, Pool>::find(const K& key) const
+    -> std::optional<V> {
+    std::shared_lock<std::shared_mutex> lock = lock_shared();
+
+    typename map_type::const_iterator found = map.find(key);
+    if (found == map.end()) {
+      return std::nullopt;
+    }
+
+    return found->Value();
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_concurrent<K, V, Compare, Pool>::contains(const K& key) const
+    -> bool {
+    std::shared_lock<std::shared_mutex> lock = lock_shared();
+    return map.find(key) != map.end();
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename Function>
+  auto AVLmap_concurrent<K, V, Compare, Pool>::read(Function&& function)
+    const -> std::invoke_result_t<Function, const map_type&> {
+    std::shared_lock<std::shared_mutex> lock = lock_shared();
+    return std::forward<Function>(function)(map);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_concurrent<K, V, Compare, Pool>::assign(
+    const K& key,
+    const V& value
+  ) -> void {
+    write([&key, &value](map_type& m) {
+      m[key] = value;
+    });
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename Function>
+  auto AVLmap_concurrent<K, V, Compare, Pool>::update(
+    const K& key,
+    Function&& function
+  ) -> void {
+    write([&key, &function](map_type& m) {
+      function(m[key]);
+    });
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_concurrent<K, V, Compare, Pool>::erase(const K& key) -> bool {
+    bool erased = false;
+
+    write([&key, &erased](map_type& m) {
+      typename map_type::iterator found = m.find(key);
+      if (found != m.end()) {
+        m.erase(found);
+        erased = true;
+      }
+    });
+
+    return erased;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename Function>
+  auto AVLmap_concurrent<K, V, Compare, Pool>::write(Function&& function)
+    -> void {
+    typedef std::remove_reference_t<Function> FunctionType;
+    Request request{&call<FunctionType>, &function, clock::now()};
+
+    std::unique_lock<std::mutex> lock(queue_lock);
+    queue.push_back(&request);
+
+    // Whoever finds no batch running takes everything queued so far. The
+    // others sleep until a batch served them, or until they can start one
+    while (!request.done) {
+      if (combining) {
+        served.wait(lock);
+        continue;
+      }
+
+      std::vector<Request*> batch;
+      batch.swap(queue);
+      combining = true;
+      lock.unlock();
+
+      run(batch);
+
+      lock.lock();
+      for (Request* served_request: batch) {
+        served_request->done = true;
+      }
+      combining = false;
+      served.notify_all();
+    }
+
+    lock.unlock();
+    if (request.error) {
+      std::rethrow_exception(request.error);
+    }
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_concurrent<K, V, Compare, Pool>::stats() const -> LockStats {
+    LockStats copy;
+    {
+      std::shared_lock<std::shared_mutex> lock(map_lock);
+      copy = write_stats;
+    }
+
+    copy.contended_reads = contended_reads.load(std::memory_order_relaxed);
+    copy.read_wait_ns = read_wait_ns.load(std::memory_order_relaxed);
+    return copy;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename Function>
+  auto AVLmap_concurrent<K, V, Compare, Pool>::call(
+    void* function,
+    map_type& m
+  ) -> void {
+    (*static_cast<Function*>(function))(m);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_concurrent<K, V, Compare, Pool>::lock_shared() const
+    -> std::shared_lock<std::shared_mutex> {
+    // Only the reads that have to wait touch the counters, so uncontended
+    // reads do not fight over their cache line
+    if (!writer_waiting.load(std::memory_order_acquire)
+        && map_lock.try_lock_shared()) {
+      return std::shared_lock<std::shared_mutex>(map_lock, std::adopt_lock);
+    }
+
+    clock::time_point start = clock::now();
+    if (writer_waiting.load(std::memory_order_acquire)) {
+      std::lock_guard<std::mutex> gate(writer_gate);
+    }
+    std::shared_lock<std::shared_mutex> lock(map_lock);
+    std::uint64_t waited = static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        clock::now() - start
+      )
+        .count()
+    );
+
+    contended_reads.fetch_add(1, std::memory_order_relaxed);
+    read_wait_ns.fetch_add(waited, std::memory_order_relaxed);
+    return lock;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_concurrent<K, V, Compare, Pool>::run(
+    const std::vector<Request*>& batch
+  ) -> void {
+    std::lock_guard<std::mutex> gate(writer_gate);
+    writer_waiting.store(true, std::memory_order_release);
+    std::unique_lock<std::shared_mutex> lock(map_lock);
+    clock::time_point start = clock::now();
+
+    for (Request* request: batch) {
+      write_stats.write_wait_ns += static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+          start - request->queued
+        )
+          .count()
+      );
+
+      try {
+        request->call(request->function, map);
+      } catch (...) {
+        request->error = std::current_exception();
+      }
+    }
+
+    write_stats.writes += batch.size();
+    write_stats.batches++;
+    write_stats.largest_batch =
+      std::max<std::uint64_t>(write_stats.largest_batch, batch.size());
+    writer_waiting.store(false, std::memory_order_release);
+  }
+} // namespace CS280
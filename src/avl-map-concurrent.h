@@ -0,0 +1,298 @@
+/**
+ * @file avl-map-concurrent.h
+ * @author Edgar Jose Donoso Mansilla (e.donosomansilla)
+ * @course CS280
+ * @term Spring 2025
+ *
+ * @brief Thread safe front end for a map with shared reads and batched writes
+ */
+
+#ifndef AVLMAPCONCURRENT_H
+  #define AVLMAPCONCURRENT_H
+
+  #include <atomic>
+  #include <chrono>
+  #include <condition_variable>
+  #include <cstdint>
+  #include <exception>
+  #include <mutex>
+  #include <optional>
+  #include <shared_mutex>
+  #include <type_traits>
+  #include <utility>
+  #include <vector>
+
+  #include "avl-map.h"
+
+namespace CS280 {
+
+  /**
+   * @brief Counters describing the contention on a concurrent map.
+   */
+  struct LockStats {
+    /**
+     * @brief Amount of reads that had to wait for a writer.
+     */
+    std::uint64_t contended_reads{0};
+
+    /**
+     * @brief Nanoseconds readers spent waiting for writers.
+     */
+    std::uint64_t read_wait_ns{0};
+
+    /**
+     * @brief Amount of writes done.
+     */
+    std::uint64_t writes{0};
+
+    /**
+     * @brief Amount of times writers took the map (each one ran a batch).
+     */
+    std::uint64_t batches{0};
+
+    /**
+     * @brief Most writes run in one batch.
+     */
+    std::uint64_t largest_batch{0};
+
+    /**
+     * @brief Nanoseconds writes spent queued before their batch started.
+     */
+    std::uint64_t write_wait_ns{0};
+  };
+
+  /**
+   * @brief Map that can be used from many threads at once. Reads share the
+   * map, writes take it alone.
+   *
+   * Writes are queued and run in batches: the first writer to find no batch
+   * running takes the map once and runs every write queued so far (its own
+   * and those of the writers waiting behind it), so a burst of writes costs
+   * one exclusive acquisition instead of one each.
+   *
+   * While a batch waits for the map, new reads wait behind it instead of
+   * joining the readers already in (the shared mutex alone prefers readers
+   * on some platforms, which left writers starved under steady reads).
+   *
+   * Nothing handed out refers into the map, since it could change as soon
+   * as the lock is released: lookups return copies of the values and read
+   * runs a function with the lock held.
+   *
+   * @param K The type for the key to be used
+   * @param V The type for the values to be used
+   * @param Compare The strict weak ordering of the keys
+   * @param Pool The allocation policy for the nodes
+   */
+  template<
+    typename K,
+    typename V,
+    typename Compare = std::less<K>,
+    template<typename> class Pool = NodePool>
+  class AVLmap_concurrent {
+  public:
+
+    // the map behind the lock
+    typedef AVLmap<K, V, Compare, Pool> map_type;
+
+    /**
+     * @brief Constructor
+     */
+    AVLmap_concurrent();
+
+    /**
+     * @brief Constructor taking over a map
+     * @param map The map
+     */
+    explicit AVLmap_concurrent(map_type map);
+
+    // Deleted copy constructor
+    AVLmap_concurrent(const AVLmap_concurrent&) = delete;
+
+    // Deleted copy assignment operator
+    auto operator=(const AVLmap_concurrent&) -> AVLmap_concurrent& = delete;
+
+    /**
+     * @brief Getter for the size of the map
+     * @return The amount of nodes in the map
+     */
+    auto size() const -> unsigned int;
+
+    /**
+     * @brief Searches for a value using the key
+     * @param key The key to search for
+     * @return A copy of the value (empty if the key is not in the map)
+     */
+    auto find(const K& key) const -> std::optional<V>;
+
+    /**
+     * @brief Checks whether a key is in the map
+     * @param key The key to search for
+     * @return Whether it is there
+     */
+    auto contains(const K& key) const -> bool;
+
+    /**
+     * @brief Runs a function on the map while reads are shared
+     * @param function Called with a const reference to the map
+     * @return What the function returns
+     */
+    template<typename Function>
+    auto read(Function&& function) const
+      -> std::invoke_result_t<Function, const map_type&>;
+
+    /**
+     * @brief Sets the value of a key, adding it if it is not there
+     * @param key The key
+     * @param value The value
+     */
+    auto assign(const K& key, const V& value) -> void;
+
+    /**
+     * @brief Runs a function on the value of a key (as operator[] would
+     * give it, adding the key if it is not there)
+     * @param key The key
+     * @param function Called with a reference to the value
+     */
+    template<typename Function>
+    auto update(const K& key, Function&& function) -> void;
+
+    /**
+     * @brief Erases a key
+     * @param key The key
+     * @return Whether the key was there
+     */
+    auto erase(const K& key) -> bool;
+
+    /**
+     * @brief Runs a function on the map as a write (batched with others)
+     * @param function Called with a reference to the map. If it throws, the
+     * exception is rethrown here and the rest of the batch still runs
+     */
+    template<typename Function>
+    auto write(Function&& function) -> void;
+
+    /**
+     * @brief Getter for the contention counters
+     * @return A copy of the counters
+     */
+    auto stats() const -> LockStats;
+
+  private:
+
+    typedef std::chrono::steady_clock clock;
+
+    /**
+     * @brief A write waiting for its batch, owned by the thread that queued
+     * it
+     */
+    struct Request {
+      /**
+       * @brief Calls the function
+       */
+      void (*call)(void*, map_type&);
+
+      /**
+       * @brief The function
+       */
+      void* function;
+
+      /**
+       * @brief When it was queued
+       */
+      clock::time_point queued;
+
+      /**
+       * @brief Set once the function ran (guarded by queue_lock)
+       */
+      bool done{false};
+
+      /**
+       * @brief The exception thrown by the function
+       */
+      std::exception_ptr error{};
+    };
+
+    /**
+     * @brief Calls a function of a given type through a type erased pointer
+     * @param function The function
+     * @param map The map
+     */
+    template<typename Function>
+    static auto call(void* function, map_type& map) -> void;
+
+    /**
+     * @brief Takes the map for reading, counting the wait if a writer has it
+     * or is waiting for it
+     * @return The held lock
+     */
+    auto lock_shared() const -> std::shared_lock<std::shared_mutex>;
+
+    /**
+     * @brief Runs a batch of writes with the map taken alone
+     * @param batch The writes
+     */
+    auto run(const std::vector<Request*>& batch) -> void;
+
+    /**
+     * @brief The map.
+     */
+    map_type map;
+
+    /**
+     * @brief Shared by reads, taken alone by batches.
+     */
+    mutable std::shared_mutex map_lock{};
+
+    /**
+     * @brief Held by a batch from before it waits for the map until it is
+     * done, new reads queue on it meanwhile.
+     */
+    mutable std::mutex writer_gate{};
+
+    /**
+     * @brief Whether a batch holds the writer gate.
+     */
+    std::atomic<bool> writer_waiting{false};
+
+    /**
+     * @brief Guards the queue and the done flags.
+     */
+    std::mutex queue_lock{};
+
+    /**
+     * @brief Wakes the writers when a batch finished.
+     */
+    std::condition_variable served{};
+
+    /**
+     * @brief The writes waiting for the next batch.
+     */
+    std::vector<Request*> queue{};
+
+    /**
+     * @brief Whether a writer is running a batch.
+     */
+    bool combining{false};
+
+    /**
+     * @brief Counters of the writers (guarded by map_lock).
+     */
+    LockStats write_stats{};
+
+    /**
+     * @brief Amount of reads that had to wait for a writer.
+     */
+    mutable std::atomic<std::uint64_t> contended_reads{0};
+
+    /**
+     * @brief Nanoseconds readers spent waiting for writers.
+     */
+    mutable std::atomic<std::uint64_t> read_wait_ns{0};
+  };
+} // namespace CS280
+
+  #ifndef AVLMAPCONCURRENT_CPP
+    #include "avl-map-concurrent.cpp"
+  #endif
+
+#endif
@@ -0,0 +1,370 @@
+/**
+ * @file avl-map-eytzinger.cpp
+ * @author Edgar Jose Donoso Mansilla (e.donosomansilla)
+ * @course CS280
+ * @term Spring 2025
+ *
+ * @brief Implementation for the breadth first snapshot of a map
+ */
+
+#include <climits>
+#include <utility>
+
+#define AVLMAPEYTZINGER_CPP
+
+#ifndef AVLMAPEYTZINGER_H
+  #include "avl-map-eytzinger.h"
+#endif
+
+namespace CS280 {
+
+  /// Entry Methods
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_eytzinger<K, V, Compare>::Entry::Entry(
+    const AVLmap_eytzinger* m,
+    std::size_t i
+  ):
+      map(m),
+      index(i) {}
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_eytzinger<K, V, Compare>::Entry::Key() const -> const K& {
+    return map->keys[index];
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_eytzinger<K, V, Compare>::Entry::Value() const -> const V& {
+    return map->values[index - 1];
+  }
+
+  /// Iterator Methods
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_eytzinger<K, V, Compare>::AVLmap_eytzinger_iterator::
+    AVLmap_eytzinger_iterator(const AVLmap_eytzinger* m, std::size_t i):
+      entry(m, i) {}
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_eytzinger<K, V, Compare>::AVLmap_eytzinger_iterator::operator++()
+    -> AVLmap_eytzinger_iterator& {
+    entry.index = next(entry.index, entry.map->values.size());
+    return *this;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_eytzinger<K, V, Compare>::AVLmap_eytzinger_iterator::operator++(
+    int
+  ) -> AVLmap_eytzinger_iterator {
+    AVLmap_eytzinger_iterator copy(*this);
+    ++(*this);
+    return copy;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_eytzinger<K, V, Compare>::AVLmap_eytzinger_iterator::operator--()
+    -> AVLmap_eytzinger_iterator& {
+    entry.index = previous(entry.index, entry.map->values.size());
+    return *this;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_eytzinger<K, V, Compare>::AVLmap_eytzinger_iterator::operator--(
+    int
+  ) -> AVLmap_eytzinger_iterator {
+    AVLmap_eytzinger_iterator copy(*this);
+    --(*this);
+    return copy;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_eytzinger<K, V, Compare>::AVLmap_eytzinger_iterator::operator*(
+  ) const -> const Entry& {
+    return entry;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_eytzinger<K, V, Compare>::AVLmap_eytzinger_iterator::operator->(
+  ) const -> const Entry* {
+    return &entry;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_eytzinger<K, V, Compare>::AVLmap_eytzinger_iterator::operator!=(
+    const AVLmap_eytzinger_iterator& rhs
+  ) const -> bool {
+    return !(*this == rhs);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_eytzinger<K, V, Compare>::AVLmap_eytzinger_iterator::operator==(
+    const AVLmap_eytzinger_iterator& rhs
+  ) const -> bool {
+    return entry.map == rhs.entry.map && entry.index == rhs.entry.index;
+  }
+
+  /// AVLmap_eytzinger Methods
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_eytzinger<K, V, Compare>::AVLmap_eytzinger() {}
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_eytzinger<K, V, Compare>::AVLmap_eytzinger(
+    const std::vector<K>& sorted_keys,
+    std::vector<V> sorted_values,
+    const Compare& c
+  ):
+      comp(c) {
+    std::size_t count = sorted_values.size();
+    if (count == 0) {
+      return;
+    }
+
+    while ((std::size_t{1} << levels) - 1 < count) {
+      levels++;
+    }
+
+    // Walking the positions in order tells which rank goes to each one
+    std::vector<std::size_t> order(count + 1);
+    std::size_t index = 1;
+    while (2 * index <= count) {
+      index = 2 * index;
+    }
+    for (std::size_t rank = 0; rank < count; ++rank) {
+      order[index] = rank;
+      index = next(index, count);
+    }
+
+    keys.reserve(count + 1);
+    values.reserve(count);
+    keys.push_back(sorted_keys[0]);
+    for (index = 1; index <= count; ++index) {
+      keys.push_back(sorted_keys[order[index]]);
+      values.push_back(std::move(sorted_values[order[index]]));
+    }
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_eytzinger<K, V, Compare>::size() const -> unsigned int {
+    return static_cast<unsigned int>(values.size());
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_eytzinger<K, V, Compare>::begin() const -> const_iterator {
+    return const_iterator(this, next(0, values.size()));
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_eytzinger<K, V, Compare>::end() const -> const_iterator {
+    return const_iterator(this, 0);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_eytzinger<K, V, Compare>::find(const K& key) const
+    -> const_iterator {
+    std::size_t index = search(key);
+
+    if (index == 0 || comp(key, keys[index])) {
+      return end();
+    }
+
+    return const_iterator(this, index);
+  }
+
+  template<typename K, typename V, typename Compare>
+  template<typename RandomIt, typename OutIt>
+  auto AVLmap_eytzinger<K, V, Compare>::find_batch(
+    RandomIt first,
+    RandomIt last,
+    OutIt out
+  ) const -> void {
+    std::size_t count = static_cast<std::size_t>(last - first);
+    std::size_t done = 0;
+
+  #if AVLMAP_EYTZINGER_AVX2
+    if constexpr (avx2_keys) {
+      // The lanes hold the positions too, so they have to fit
+      bool fits = values.size() < (std::size_t{1} << 30);
+
+      if (uses_avx2() && !values.empty() && fits) {
+        K probes[avx2_lanes];
+        std::size_t found[avx2_lanes];
+
+        for (; done + avx2_lanes <= count; done += avx2_lanes) {
+          for (std::size_t lane = 0; lane < avx2_lanes; ++lane) {
+            probes[lane] = first[done + lane];
+          }
+
+          search_avx2(probes, found);
+
+          for (std::size_t lane = 0; lane < avx2_lanes; ++lane) {
+            std::size_t index = found[lane];
+            out[done + lane] =
+              index == 0 || comp(probes[lane], keys[index])
+                ? end()
+                : const_iterator(this, index);
+          }
+        }
+      }
+    }
+  #endif
+
+    // What is left over (or everything without AVX2)
+    for (; done < count; ++done) {
+      out[done] = find(first[done]);
+    }
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_eytzinger<K, V, Compare>::lower_bound(const K& key) const
+    -> const_iterator {
+    return const_iterator(this, search(key));
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_eytzinger<K, V, Compare>::bytes_reserved() const
+    -> std::size_t {
+    return keys.capacity() * sizeof(K) + values.capacity() * sizeof(V);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_eytzinger<K, V, Compare>::uses_avx2() -> bool {
+  #if AVLMAP_EYTZINGER_AVX2
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return avx2_keys && supported;
+  #else
+    return false;
+  #endif
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_eytzinger<K, V, Compare>::trailing_ones(std::size_t value)
+    -> unsigned {
+  #if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(~value));
+  #else
+    unsigned count = 0;
+    while (value & 1) {
+      value >>= 1;
+      count++;
+    }
+    return count;
+  #endif
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_eytzinger<K, V, Compare>::next(
+    std::size_t index,
+    std::size_t count
+  ) -> std::size_t {
+    // From end (or a key with a right child) it is the leftmost key below
+    std::size_t right = index == 0 ? 1 : 2 * index + 1;
+    if (right <= count) {
+      while (2 * right <= count) {
+        right = 2 * right;
+      }
+      return right;
+    }
+
+    // Otherwise it is the first ancestor reached from its left
+    return index >> (trailing_ones(index) + 1);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_eytzinger<K, V, Compare>::previous(
+    std::size_t index,
+    std::size_t count
+  ) -> std::size_t {
+    // From end (or a key with a left child) it is the rightmost key below
+    std::size_t left = index == 0 ? 1 : 2 * index;
+    if (left <= count) {
+      while (2 * left + 1 <= count) {
+        left = 2 * left + 1;
+      }
+      return left;
+    }
+
+    // Otherwise it is the first ancestor reached from its right
+    return index >> (trailing_ones(~index) + 1);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_eytzinger<K, V, Compare>::search(const K& key) const
+    -> std::size_t {
+    std::size_t count = values.size();
+    std::uintptr_t base = reinterpret_cast<std::uintptr_t>(keys.data());
+    std::size_t index = 1;
+
+    // Going right appends a 1 to the index, so once past the leaves the
+    // last left turn (the answer) is what is left after the trailing ones.
+    // The prefetch is computed as an integer since it may be past the end
+    while (index <= count) {
+      AVLMAP_PREFETCH(reinterpret_cast<const void*>(
+        base + index * prefetch_stride * sizeof(K)
+      ));
+      index = 2 * index + static_cast<std::size_t>(comp(keys[index], key));
+    }
+
+    return index >> (trailing_ones(index) + 1);
+  }
+
+  #if AVLMAP_EYTZINGER_AVX2
+  template<typename K, typename V, typename Compare>
+  __attribute__((target("avx2"))) auto
+    AVLmap_eytzinger<K, V, Compare>::search_avx2(
+      const K* probes,
+      std::size_t* found
+    ) const -> void {
+    // Unsigned keys are compared as signed ones with the top bit flipped
+    const __m256i sign = _mm256_set1_epi32(std::is_unsigned_v<K> ? INT_MIN : 0);
+    const __m256i limit = _mm256_set1_epi32(static_cast<int>(values.size()));
+    const __m256i key = _mm256_xor_si256(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(probes)),
+      sign
+    );
+    const int* base = reinterpret_cast<const int*>(keys.data());
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(base);
+
+    // Prefetching one line per lane only pays off once the keys miss L2
+    bool ahead = keys.size() * sizeof(K) > avx2_prefetch_bytes;
+
+    __m256i index = _mm256_set1_epi32(1);
+    alignas(32) std::uint32_t lanes[avx2_lanes];
+
+    for (std::size_t level = 0; level < levels; ++level) {
+      // Searches already past the leaves keep their index
+      __m256i active = _mm256_xor_si256(
+        _mm256_cmpgt_epi32(index, limit),
+        _mm256_set1_epi32(-1)
+      );
+      __m256i node = _mm256_xor_si256(
+        _mm256_mask_i32gather_epi32(
+          _mm256_setzero_si256(),
+          base,
+          index,
+          active,
+          4
+        ),
+        sign
+      );
+      __m256i less = _mm256_cmpgt_epi32(key, node);
+      __m256i child = _mm256_sub_epi32(_mm256_add_epi32(index, index), less);
+      index = _mm256_blendv_epi8(index, child, active);
+
+      if (ahead) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), index);
+        for (std::size_t lane = 0; lane < avx2_lanes; ++lane) {
+          AVLMAP_PREFETCH(reinterpret_cast<const void*>(
+            address + lanes[lane] * prefetch_stride * sizeof(K)
+          ));
+        }
+      }
+    }
+
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), index);
+    for (std::size_t lane = 0; lane < avx2_lanes; ++lane) {
+      found[lane] = lanes[lane] >> (trailing_ones(lanes[lane]) + 1);
+    }
+  }
+  #endif
+} // namespace CS280
@@ -0,0 +1,350 @@
+/**
+ * @file avl-map-eytzinger.h
+ * @author Edgar Jose Donoso Mansilla (e.donosomansilla)
+ * @course CS280
+ * @term Spring 2025
+ *
+ * @brief Read only snapshot of a map in Eytzinger (breadth first) layout
+ */
+
+#ifndef AVLMAPEYTZINGER_H
+  #define AVLMAPEYTZINGER_H
+
+  #include <cstddef>
+  #include <cstdint>
+  #include <functional>
+  #include <type_traits>
+  #include <vector>
+
+  // Define as 0 before including to drop the AVX2 batch search (it is only
+  // built for x86 with GCC or Clang, and only used if the CPU has AVX2)
+  #ifndef AVLMAP_EYTZINGER_AVX2
+    #if (defined(__GNUC__) || defined(__clang__)) \
+      && (defined(__x86_64__) || defined(__i386__))
+      #define AVLMAP_EYTZINGER_AVX2 1
+    #else
+      #define AVLMAP_EYTZINGER_AVX2 0
+    #endif
+  #endif
+
+  #if AVLMAP_EYTZINGER_AVX2
+    #include <immintrin.h>
+  #endif
+
+  // Hint to start loading a node into the cache (no-op where unsupported)
+  #ifndef AVLMAP_PREFETCH
+    #if defined(__GNUC__) || defined(__clang__)
+      #define AVLMAP_PREFETCH(address) __builtin_prefetch(address)
+    #else
+      #define AVLMAP_PREFETCH(address) static_cast<void>(address)
+    #endif
+  #endif
+
+namespace CS280 {
+
+  /**
+   * @brief Immutable sorted map searched as an implicit binary tree stored
+   * in breadth first (Eytzinger) order: the children of position k are 2k and
+   * 2k + 1. The search has no branch to mispredict (the comparison picks the
+   * child arithmetically) and prefetches the cache line holding the
+   * descendants a few levels down, so several misses of the same search
+   * overlap.
+   *
+   * For 32 bit integral keys under std::less, find_batch compares a block of
+   * 8 keys (one per search) in a single AVX2 instruction, gathering the next
+   * node of every search at once. This is picked at run time, so the same
+   * binary runs on CPUs without AVX2. Wider keys only get 4 lanes, which lost
+   * to the scalar search, so they always take it.
+   *
+   * @param K The type for the key to be used
+   * @param V The type for the values to be used
+   * @param Compare The strict weak ordering of the keys
+   */
+  template<typename K, typename V, typename Compare = std::less<K>>
+  class AVLmap_eytzinger {
+
+    // Forward declaration for the struct
+    struct AVLmap_eytzinger_iterator;
+
+  public:
+
+    // standard names for iterator types (everything is const)
+    typedef AVLmap_eytzinger_iterator iterator;
+    typedef AVLmap_eytzinger_iterator const_iterator;
+
+    /**
+     * @brief A key and its value, as seen through an iterator.
+     */
+    class Entry {
+    public:
+
+      /**
+       * @brief Getter of a reference to the key.
+       * @return Const reference to the key.
+       */
+      auto Key() const -> const K&;
+
+      /**
+       * @brief Getter of a reference to the value.
+       * @return Const reference to the value.
+       */
+      auto Value() const -> const V&;
+
+    private:
+
+      /**
+       * @brief Constructor
+       * @param m The map
+       * @param i The position of the key in the layout
+       */
+      Entry(const AVLmap_eytzinger* m, std::size_t i);
+
+      /**
+       * @brief The map the entry belongs to.
+       */
+      const AVLmap_eytzinger* map;
+
+      /**
+       * @brief The position of the key in the layout (0 for end).
+       */
+      std::size_t index;
+
+      // Friending the map class so the internals can be accessed.
+      friend AVLmap_eytzinger;
+    };
+
+  private:
+
+    /**
+     * @brief This class is the iterator of the map (walks the keys in order).
+     */
+    struct AVLmap_eytzinger_iterator {
+    private:
+
+      /**
+       * @brief The entry the iterator is at.
+       */
+      Entry entry;
+
+    public:
+
+      /**
+       * @brief Constructor for the iterator
+       * @param m The map
+       * @param i The position of the key in the layout (0 for end)
+       */
+      AVLmap_eytzinger_iterator(const AVLmap_eytzinger* m, std::size_t i);
+
+      /**
+       * @brief Pre-increment operator (successor)
+       */
+      auto operator++() -> AVLmap_eytzinger_iterator&;
+
+      /**
+       * @brief Post-increment operator (successor)
+       */
+      auto operator++(int) -> AVLmap_eytzinger_iterator;
+
+      /**
+       * @brief Pre-decrement operator (predecessor)
+       */
+      auto operator--() -> AVLmap_eytzinger_iterator&;
+
+      /**
+       * @brief Post-decrement operator (predecessor)
+       */
+      auto operator--(int) -> AVLmap_eytzinger_iterator;
+
+      /**
+       * @brief Dereferencing operator.
+       * @return Reference to the entry.
+       */
+      auto operator*() const -> const Entry&;
+
+      /**
+       * @brief Arrow operator.
+       * @return Pointer to the entry.
+       */
+      auto operator->() const -> const Entry*;
+
+      /**
+       * @brief Inequality operator.
+       */
+      auto operator!=(const AVLmap_eytzinger_iterator& rhs) const -> bool;
+
+      /**
+       * @brief Equality operator.
+       */
+      auto operator==(const AVLmap_eytzinger_iterator& rhs) const -> bool;
+    };
+
+  public:
+
+    /**
+     * @brief Constructor for an empty map
+     */
+    AVLmap_eytzinger();
+
+    /**
+     * @brief Constructor from the contents in key order
+     * @param keys The keys, strictly increasing
+     * @param values The value of every key
+     * @param comp The comparator used to order the keys
+     */
+    AVLmap_eytzinger(
+      const std::vector<K>& keys,
+      std::vector<V> values,
+      const Compare& comp = Compare{}
+    );
+
+    /**
+     * @brief Getter for the size of the map
+     * @return The amount of keys in the map
+     */
+    auto size() const -> unsigned int;
+
+    /**
+     * @brief Returns an iterator to the first key
+     */
+    auto begin() const -> const_iterator;
+
+    /**
+     * @brief Returns an iterator to one past the last key
+     */
+    auto end() const -> const_iterator;
+
+    /**
+     * @brief Searches for a value using the key
+     * @param key The key to search for
+     * @return The iterator to the key (or end if not found)
+     */
+    auto find(const K& key) const -> const_iterator;
+
+    /**
+     * @brief Searches for many keys at once (with AVX2 where possible)
+     * @param first The start of the keys (random access)
+     * @param last The end of the keys
+     * @param out Where the iterators go (random access, out[i] gets the
+     * result for first[i], end if the key is not in the map)
+     */
+    template<typename RandomIt, typename OutIt>
+    auto find_batch(RandomIt first, RandomIt last, OutIt out) const -> void;
+
+    /**
+     * @brief Searches for the first key that is not less than a key
+     * @param key The key to search for
+     * @return The iterator to the key (or end if every key is less)
+     */
+    auto lower_bound(const K& key) const -> const_iterator;
+
+    /**
+     * @brief Getter for the memory held by the keys and values
+     * @return The size in bytes
+     */
+    auto bytes_reserved() const -> std::size_t;
+
+    /**
+     * @brief Whether find_batch compares blocks of keys with AVX2 (the keys
+     * are integral, the order is std::less and the CPU supports it)
+     */
+    static auto uses_avx2() -> bool;
+
+  private:
+
+    /**
+     * @brief Keys in a cache line, the descendants that far down are
+     * prefetched (16 keys of 4 bytes are 4 levels down).
+     */
+    static constexpr std::size_t prefetch_stride{
+      sizeof(K) < 64 ? 64 / sizeof(K) : 1
+    };
+
+    /**
+     * @brief Whether the keys can be compared with AVX2 at all.
+     */
+    static constexpr bool avx2_keys{
+      AVLMAP_EYTZINGER_AVX2 && std::is_integral_v<K>
+      && sizeof(K) == 4 && std::is_same_v<Compare, std::less<K>>
+    };
+
+    /**
+     * @brief Searches processed by one AVX2 block.
+     */
+    static constexpr std::size_t avx2_lanes{8};
+
+    /**
+     * @brief Size of the keys past which the AVX2 search prefetches.
+     */
+    static constexpr std::size_t avx2_prefetch_bytes{1 << 20};
+
+    /**
+     * @brief Amount of ones at the bottom of a number.
+     * @param value The number.
+     * @return The amount.
+     */
+    static auto trailing_ones(std::size_t value) -> unsigned;
+
+    /**
+     * @brief Position of the successor of a key in the layout.
+     * @param index The position of the key (0 for end).
+     * @param count The amount of keys.
+     * @return The position (0 if it was the last key).
+     */
+    static auto next(std::size_t index, std::size_t count) -> std::size_t;
+
+    /**
+     * @brief Position of the predecessor of a key in the layout.
+     * @param index The position of the key (0 for end).
+     * @param count The amount of keys.
+     * @return The position (0 if it was the first key).
+     */
+    static auto previous(std::size_t index, std::size_t count) -> std::size_t;
+
+    /**
+     * @brief Searches for the first key that is not less than a key
+     * @param key The key to search for
+     * @return Its position in the layout (0 if every key is less)
+     */
+    auto search(const K& key) const -> std::size_t;
+
+  #if AVLMAP_EYTZINGER_AVX2
+    /**
+     * @brief Searches a block of avx2_lanes keys at once (each lane one
+     * search, stepping down the levels together).
+     * @param probes The keys to search for.
+     * @param found Where the positions go (as search returns them).
+     */
+    __attribute__((target("avx2"))) auto search_avx2(
+      const K* probes,
+      std::size_t* found
+    ) const -> void;
+  #endif
+
+    /**
+     * @brief The comparator used to order the keys.
+     */
+    Compare comp{};
+
+    /**
+     * @brief The keys in breadth first order, starting at position 1 (the
+     * first element is a copy of a key and never compared).
+     */
+    std::vector<K> keys{};
+
+    /**
+     * @brief The values in the same order (position 1 is the first one).
+     */
+    std::vector<V> values{};
+
+    /**
+     * @brief The amount of levels of the tree.
+     */
+    std::size_t levels{0};
+  };
+} // namespace CS280
+
+  #ifndef AVLMAPEYTZINGER_CPP
+    #include "avl-map-eytzinger.cpp"
+  #endif
+
+#endif
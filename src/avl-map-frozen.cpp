@@ -0,0 +1,294 @@
+/**
+ * @file avl-map-frozen.cpp
+ * @author Edgar Jose Donoso Mansilla (e.donosomansilla)
+ * @course CS280
+ * @term Spring 2025
+ *
+ * @brief Implementation for the read only snapshot of a map
+ */
+
+#include <algorithm>
+#include <utility>
+
+#define AVLMAPFROZEN_CPP
+
+#ifndef AVLMAPFROZEN_H
+  #include "avl-map-frozen.h"
+#endif
+
+namespace CS280 {
+
+  /// Entry Methods
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_frozen<K, V, Compare>::Entry::Entry(
+    const AVLmap_frozen* m,
+    std::size_t r,
+    std::size_t p
+  ):
+      map(m),
+      rank(r),
+      position(p) {}
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_frozen<K, V, Compare>::Entry::Key() const -> const K& {
+    return map->keys[position];
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_frozen<K, V, Compare>::Entry::Value() const -> const V& {
+    return map->values[rank];
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_frozen<K, V, Compare>::Entry::seek(std::size_t r) -> void {
+    rank = r;
+    position = r < map->values.size() ? map->position_of(r) : 0;
+  }
+
+  /// Iterator Methods
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_frozen<K, V, Compare>::AVLmap_frozen_iterator::AVLmap_frozen_iterator(
+    const AVLmap_frozen* m,
+    std::size_t r
+  ):
+      entry(m, r, 0) {
+    entry.seek(r);
+  }
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_frozen<K, V, Compare>::AVLmap_frozen_iterator::AVLmap_frozen_iterator(
+    const AVLmap_frozen* m,
+    Found found
+  ):
+      entry(m, found.rank, found.position) {}
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_frozen<K, V, Compare>::AVLmap_frozen_iterator::operator++()
+    -> AVLmap_frozen_iterator& {
+    entry.seek(entry.rank + 1);
+    return *this;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_frozen<K, V, Compare>::AVLmap_frozen_iterator::operator++(int)
+    -> AVLmap_frozen_iterator {
+    AVLmap_frozen_iterator copy(*this);
+    ++(*this);
+    return copy;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_frozen<K, V, Compare>::AVLmap_frozen_iterator::operator--()
+    -> AVLmap_frozen_iterator& {
+    entry.seek(entry.rank - 1);
+    return *this;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_frozen<K, V, Compare>::AVLmap_frozen_iterator::operator--(int)
+    -> AVLmap_frozen_iterator {
+    AVLmap_frozen_iterator copy(*this);
+    --(*this);
+    return copy;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_frozen<K, V, Compare>::AVLmap_frozen_iterator::operator*() const
+    -> const Entry& {
+    return entry;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_frozen<K, V, Compare>::AVLmap_frozen_iterator::operator->() const
+    -> const Entry* {
+    return &entry;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_frozen<K, V, Compare>::AVLmap_frozen_iterator::operator!=(
+    const AVLmap_frozen_iterator& rhs
+  ) const -> bool {
+    return !(*this == rhs);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_frozen<K, V, Compare>::AVLmap_frozen_iterator::operator==(
+    const AVLmap_frozen_iterator& rhs
+  ) const -> bool {
+    return entry.map == rhs.entry.map && entry.rank == rhs.entry.rank;
+  }
+
+  /// AVLmap_frozen Methods
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_frozen<K, V, Compare>::AVLmap_frozen() {}
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_frozen<K, V, Compare>::AVLmap_frozen(
+    const std::vector<K>& sorted_keys,
+    std::vector<V> sorted_values,
+    const Compare& c
+  ):
+      comp(c),
+      values(std::move(sorted_values)) {
+    std::size_t count = values.size();
+    if (count == 0) {
+      return;
+    }
+
+    while ((std::size_t{1} << height) - 1 < count) {
+      height++;
+    }
+
+    levels.assign(height, Level{0, 0, 0});
+    cut(0, height);
+
+    // Which rank goes to every position of the layout
+    std::size_t total = (std::size_t{1} << height) - 1;
+    std::vector<std::size_t> order(total);
+    for (std::size_t rank = 0; rank < total; ++rank) {
+      order[position_of(rank)] = rank;
+    }
+
+    // The padding past the last key repeats it, which keeps the keys sorted
+    // in order so lower_bound never stops at the padding
+    keys.reserve(total);
+    for (std::size_t position = 0; position < total; ++position) {
+      keys.push_back(sorted_keys[std::min(order[position], count - 1)]);
+    }
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_frozen<K, V, Compare>::size() const -> unsigned int {
+    return static_cast<unsigned int>(values.size());
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_frozen<K, V, Compare>::begin() const -> const_iterator {
+    return const_iterator(this, 0);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_frozen<K, V, Compare>::end() const -> const_iterator {
+    return const_iterator(this, Found{values.size(), 0});
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_frozen<K, V, Compare>::find(const K& key) const
+    -> const_iterator {
+    Found found = search(key);
+
+    if (found.rank == values.size() || comp(key, keys[found.position])) {
+      return end();
+    }
+
+    return const_iterator(this, found);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_frozen<K, V, Compare>::lower_bound(const K& key) const
+    -> const_iterator {
+    return const_iterator(this, search(key));
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_frozen<K, V, Compare>::bytes_reserved() const -> std::size_t {
+    return keys.capacity() * sizeof(K) + values.capacity() * sizeof(V)
+         + levels.capacity() * sizeof(Level);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_frozen<K, V, Compare>::cut(std::size_t depth, std::size_t h)
+    -> void {
+    if (h <= 1) {
+      return;
+    }
+
+    std::size_t top_height = h / 2;
+    std::size_t bottom_height = h - top_height;
+    std::size_t boundary = depth + top_height;
+
+    levels[boundary] = Level{
+      (std::size_t{1} << top_height) - 1,
+      (std::size_t{1} << bottom_height) - 1,
+      depth
+    };
+
+    cut(depth, top_height);
+    cut(boundary, bottom_height);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_frozen<K, V, Compare>::position(
+    const std::array<std::size_t, max_height>& path,
+    std::size_t depth,
+    std::size_t index
+  ) const -> std::size_t {
+    if (depth == 0) {
+      return 0;
+    }
+
+    // The low bits of the index tell which bottom tree of the cut it is in
+    const Level& level = levels[depth];
+    std::size_t below = depth - level.top_depth;
+    std::size_t bottom = index & ((std::size_t{1} << below) - 1);
+
+    return path[level.top_depth] + level.top_size + bottom * level.bottom_size;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_frozen<K, V, Compare>::position_of(std::size_t rank) const
+    -> std::size_t {
+    // In order position (2i + 1) * 2^z belongs to the i-th node of the depth
+    // that is z levels above the leaves
+    std::size_t in_order = rank + 1;
+    std::size_t zeros = 0;
+    while ((in_order & 1) == 0) {
+      in_order >>= 1;
+      zeros++;
+    }
+
+    std::size_t depth = height - 1 - zeros;
+    std::size_t index = (std::size_t{1} << depth) + (in_order >> 1);
+
+    // Only the entries above depth are read, so the array is not cleared
+    std::array<std::size_t, max_height> path;
+    for (std::size_t d = 0; d <= depth; ++d) {
+      path[d] = position(path, d, index >> (depth - d));
+    }
+
+    return path[depth];
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_frozen<K, V, Compare>::search(const K& key) const -> Found {
+    Found found{values.size(), 0};
+
+    std::array<std::size_t, max_height> path;
+    std::size_t index = 1;
+    std::size_t found_depth = 0;
+    std::size_t found_index = 0;
+
+    for (std::size_t depth = 0; depth < height; ++depth) {
+      path[depth] = position(path, depth, index);
+
+      if (comp(keys[path[depth]], key)) {
+        index = 2 * index + 1;
+      } else {
+        found_depth = depth;
+        found_index = index;
+        found.position = path[depth];
+        index = 2 * index;
+      }
+    }
+
+    if (found_index != 0) {
+      std::size_t offset = found_index - (std::size_t{1} << found_depth);
+      found.rank = ((2 * offset + 1) << (height - 1 - found_depth)) - 1;
+    }
+
+    return found;
+  }
+} // namespace CS280
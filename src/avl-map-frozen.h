@@ -0,0 +1,344 @@
+/**
+ * @file avl-map-frozen.h
+ * @author Edgar Jose Donoso Mansilla (e.donosomansilla)
+ * @course CS280
+ * @term Spring 2025
+ *
+ * @brief Read only snapshot of a map in van Emde Boas layout
+ */
+
+#ifndef AVLMAPFROZEN_H
+  #define AVLMAPFROZEN_H
+
+  #include <array>
+  #include <cstddef>
+  #include <functional>
+  #include <vector>
+
+namespace CS280 {
+
+  /**
+   * @brief Immutable sorted map searched as an implicit perfect binary tree
+   * stored in van Emde Boas order: the tree is cut at half its height, the
+   * top half is laid out first and then every bottom tree, each one the same
+   * way recursively. Any subtree that fits a cache line (or a page) is then
+   * contiguous, whatever the sizes of the caches.
+   *
+   * There are no links. The position of a node is computed from the
+   * positions of its ancestors with one small table per depth (Brodal,
+   * Fagerberg and Jacob). The keys live in the tree and the values apart, in
+   * key order. The tree is padded to a perfect one with copies of the last
+   * key.
+   *
+   * @param K The type for the key to be used
+   * @param V The type for the values to be used
+   * @param Compare The strict weak ordering of the keys
+   */
+  template<typename K, typename V, typename Compare = std::less<K>>
+  class AVLmap_frozen {
+
+    // Forward declaration for the structs
+    struct AVLmap_frozen_iterator;
+    struct Found;
+
+  public:
+
+    // standard names for iterator types (everything is const)
+    typedef AVLmap_frozen_iterator iterator;
+    typedef AVLmap_frozen_iterator const_iterator;
+
+    /**
+     * @brief A key and its value, as seen through an iterator.
+     */
+    class Entry {
+    public:
+
+      /**
+       * @brief Getter of a reference to the key.
+       * @return Const reference to the key.
+       */
+      auto Key() const -> const K&;
+
+      /**
+       * @brief Getter of a reference to the value.
+       * @return Const reference to the value.
+       */
+      auto Value() const -> const V&;
+
+    private:
+
+      /**
+       * @brief Constructor
+       * @param m The map
+       * @param r The position of the key in key order
+       * @param p The position of the key in the layout
+       */
+      Entry(const AVLmap_frozen* m, std::size_t r, std::size_t p);
+
+      /**
+       * @brief Moves the entry to the key of a rank
+       * @param r The position of the key in key order
+       */
+      auto seek(std::size_t r) -> void;
+
+      /**
+       * @brief The map the entry belongs to.
+       */
+      const AVLmap_frozen* map;
+
+      /**
+       * @brief The position of the key in key order.
+       */
+      std::size_t rank;
+
+      /**
+       * @brief The position of the key in the layout (0 at the end).
+       */
+      std::size_t position;
+
+      // Friending the map class so the internals can be accessed.
+      friend AVLmap_frozen;
+    };
+
+  private:
+
+    /**
+     * @brief Result of a search.
+     */
+    struct Found {
+      /**
+       * @brief The position of the key in key order (size() if none).
+       */
+      std::size_t rank;
+
+      /**
+       * @brief The position of the key in the layout.
+       */
+      std::size_t position;
+    };
+
+    /**
+     * @brief This class is the iterator of the map (walks the keys in order).
+     *
+     * Keys next to each other in order are far apart in the layout, so every
+     * step finds the position of the next key from the root, in O(log n): a
+     * full walk costs O(n log n), against O(n) for the values alone. The
+     * entry keeps the position, so reading the key again costs nothing.
+     */
+    struct AVLmap_frozen_iterator {
+    private:
+
+      /**
+       * @brief The entry the iterator is at (rank size() for end).
+       */
+      Entry entry;
+
+    public:
+
+      /**
+       * @brief Constructor for the iterator
+       * @param m The map
+       * @param r The position of the key in key order
+       */
+      AVLmap_frozen_iterator(const AVLmap_frozen* m, std::size_t r);
+
+      /**
+       * @brief Constructor for the iterator from a known layout position
+       * @param m The map
+       * @param found Where the key is
+       */
+      AVLmap_frozen_iterator(const AVLmap_frozen* m, Found found);
+
+      /**
+       * @brief Pre-increment operator (successor)
+       */
+      auto operator++() -> AVLmap_frozen_iterator&;
+
+      /**
+       * @brief Post-increment operator (successor)
+       */
+      auto operator++(int) -> AVLmap_frozen_iterator;
+
+      /**
+       * @brief Pre-decrement operator (predecessor)
+       */
+      auto operator--() -> AVLmap_frozen_iterator&;
+
+      /**
+       * @brief Post-decrement operator (predecessor)
+       */
+      auto operator--(int) -> AVLmap_frozen_iterator;
+
+      /**
+       * @brief Dereferencing operator.
+       * @return Reference to the entry.
+       */
+      auto operator*() const -> const Entry&;
+
+      /**
+       * @brief Arrow operator.
+       * @return Pointer to the entry.
+       */
+      auto operator->() const -> const Entry*;
+
+      /**
+       * @brief Inequality operator.
+       */
+      auto operator!=(const AVLmap_frozen_iterator& rhs) const -> bool;
+
+      /**
+       * @brief Equality operator.
+       */
+      auto operator==(const AVLmap_frozen_iterator& rhs) const -> bool;
+    };
+
+  public:
+
+    /**
+     * @brief Constructor for an empty map
+     */
+    AVLmap_frozen();
+
+    /**
+     * @brief Constructor from the contents in key order
+     * @param keys The keys, strictly increasing
+     * @param values The value of every key
+     * @param comp The comparator used to order the keys
+     */
+    AVLmap_frozen(
+      const std::vector<K>& keys,
+      std::vector<V> values,
+      const Compare& comp = Compare{}
+    );
+
+    /**
+     * @brief Getter for the size of the map
+     * @return The amount of keys in the map
+     */
+    auto size() const -> unsigned int;
+
+    /**
+     * @brief Returns an iterator to the first key
+     */
+    auto begin() const -> const_iterator;
+
+    /**
+     * @brief Returns an iterator to one past the last key
+     */
+    auto end() const -> const_iterator;
+
+    /**
+     * @brief Searches for a value using the key
+     * @param key The key to search for
+     * @return The iterator to the key (or end if not found)
+     */
+    auto find(const K& key) const -> const_iterator;
+
+    /**
+     * @brief Searches for the first key that is not less than a key
+     * @param key The key to search for
+     * @return The iterator to the key (or end if every key is less)
+     */
+    auto lower_bound(const K& key) const -> const_iterator;
+
+    /**
+     * @brief Getter for the memory held by the keys and values
+     * @return The size in bytes
+     */
+    auto bytes_reserved() const -> std::size_t;
+
+  private:
+
+    /**
+     * @brief Deepest tree the tables can describe.
+     */
+    static constexpr std::size_t max_height{64};
+
+    /**
+     * @brief Where the nodes of a depth sit in the layout. Every depth but
+     * the root's is the top of the bottom trees of exactly one cut.
+     */
+    struct Level {
+      /**
+       * @brief Nodes in the top tree of the cut.
+       */
+      std::size_t top_size;
+
+      /**
+       * @brief Nodes in each bottom tree of the cut.
+       */
+      std::size_t bottom_size;
+
+      /**
+       * @brief Depth of the root of the top tree of the cut.
+       */
+      std::size_t top_depth;
+    };
+
+    /**
+     * @brief Fills the levels of the cuts of a subtree.
+     * @param depth The depth of the root of the subtree.
+     * @param height The height of the subtree.
+     */
+    auto cut(std::size_t depth, std::size_t height) -> void;
+
+    /**
+     * @brief Position in the layout of the node at a depth, given the
+     * positions of its ancestors.
+     * @param path The positions of the nodes above.
+     * @param depth The depth of the node.
+     * @param index The breadth first index of the node (1 for the root).
+     * @return The position.
+     */
+    auto position(
+      const std::array<std::size_t, max_height>& path,
+      std::size_t depth,
+      std::size_t index
+    ) const -> std::size_t;
+
+    /**
+     * @brief Position in the layout of the key of a rank, in O(log n).
+     * @param rank The position of the key in key order.
+     * @return The position in the layout.
+     */
+    auto position_of(std::size_t rank) const -> std::size_t;
+
+    /**
+     * @brief Searches for the first key that is not less than a key
+     * @param key The key to search for
+     * @return Where the key is
+     */
+    auto search(const K& key) const -> Found;
+
+    /**
+     * @brief The comparator used to order the keys.
+     */
+    Compare comp{};
+
+    /**
+     * @brief The levels of the tree, indexed by depth.
+     */
+    std::vector<Level> levels{};
+
+    /**
+     * @brief The keys in van Emde Boas order (padded to a perfect tree).
+     */
+    std::vector<K> keys{};
+
+    /**
+     * @brief The values in key order.
+     */
+    std::vector<V> values{};
+
+    /**
+     * @brief The height of the perfect tree.
+     */
+    std::size_t height{0};
+  };
+} // namespace CS280
+
+  #ifndef AVLMAPFROZEN_CPP
+    #include "avl-map-frozen.cpp"
+  #endif
+
+#endif
@@ -0,0 +1,516 @@
+/**
+ * @file avl-map-lockfree.cpp
+ * @author Edgar Jose Donoso Mansilla (e.donosomansilla)
+ * @course CS280
+ * @term Spring 2025
+ *
+ * @brief Implementation for the AVL map whose readers take no locks
+ */
+
+#include <algorithm>
+#include <thread>
+
+#define AVLMAPLOCKFREE_CPP
+
+#ifndef AVLMAPLOCKFREE_H
+  #include "avl-map-lockfree.h"
+#endif
+
+namespace CS280 {
+
+  /// Pin Methods
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_lockfree<K, V, Compare>::Pin::Pin(const AVLmap_lockfree& map):
+      slot(map.pin()) {}
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_lockfree<K, V, Compare>::Pin::~Pin() {
+    slot->epoch.store(0, std::memory_order_release);
+  }
+
+  /// AVLmap_lockfree Methods
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_lockfree<K, V, Compare>::AVLmap_lockfree(const Compare& c):
+      comp(c) {}
+
+  template<typename K, typename V, typename Compare>
+  template<template<typename> class Pool>
+  AVLmap_lockfree<K, V, Compare>::AVLmap_lockfree(
+    const AVLmap<K, V, Compare, Pool>& map
+  ) {
+    typedef typename AVLmap<K, V, Compare, Pool>::Node Entry;
+
+    std::vector<const Entry*> nodes;
+    for (typename AVLmap<K, V, Compare, Pool>::const_iterator it =
+           map.begin();
+         it != map.end();
+         ++it) {
+      nodes.push_back(&*it);
+    }
+
+    root.store(build(nodes, 0, nodes.size()), std::memory_order_relaxed);
+  }
+
+  template<typename K, typename V, typename Compare>
+  AVLmap_lockfree<K, V, Compare>::~AVLmap_lockfree() {
+    for (const Retired& node: retired) {
+      delete node.node;
+    }
+    destroy(root.load(std::memory_order_relaxed));
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_lockfree<K, V, Compare>::size() const -> unsigned int {
+    Pin pin(*this);
+    return count(root.load());
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_lockfree<K, V, Compare>::find(const K& key) const
+    -> std::optional<V> {
+    Pin pin(*this);
+
+    const Node* node = search(root.load(), key);
+    if (node == nullptr) {
+      return std::nullopt;
+    }
+
+    return node->value;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_lockfree<K, V, Compare>::contains(const K& key) const -> bool {
+    Pin pin(*this);
+    return search(root.load(), key) != nullptr;
+  }
+
+  template<typename K, typename V, typename Compare>
+  template<typename Function>
+  auto AVLmap_lockfree<K, V, Compare>::for_each(Function&& function) const
+    -> void {
+    Pin pin(*this);
+    visit(root.load(), function);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_lockfree<K, V, Compare>::assign(const K& key, const V& value)
+    -> void {
+    std::lock_guard<std::mutex> lock(write_lock);
+
+    std::vector<const Node*> replaced;
+    const Node* tree =
+      assign_into(root.load(std::memory_order_relaxed), key, value, replaced);
+    publish(tree, replaced);
+  }
+
+  template<typename K, typename V, typename Compare>
+  template<typename Function>
+  auto AVLmap_lockfree<K, V, Compare>::update(
+    const K& key,
+    Function&& function
+  ) -> void {
+    std::lock_guard<std::mutex> lock(write_lock);
+
+    // Writers hold the lock, so the tree read here is the one replaced
+    const Node* current = root.load(std::memory_order_relaxed);
+    const Node* node = search(current, key);
+    V value = node == nullptr ? V{} : node->value;
+    function(value);
+
+    std::vector<const Node*> replaced;
+    publish(assign_into(current, key, value, replaced), replaced);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_lockfree<K, V, Compare>::erase(const K& key) -> bool {
+    std::lock_guard<std::mutex> lock(write_lock);
+
+    std::vector<const Node*> replaced;
+    const Node* current = root.load(std::memory_order_relaxed);
+    const Node* tree = erase_from(current, key, replaced);
+    if (tree == current) {
+      return false;
+    }
+
+    publish(tree, replaced);
+    return true;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_lockfree<K, V, Compare>::reclaim() -> void {
+    std::lock_guard<std::mutex> lock(write_lock);
+    collect();
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_lockfree<K, V, Compare>::retired_nodes() -> std::size_t {
+    std::lock_guard<std::mutex> lock(write_lock);
+    return retired.size();
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_lockfree<K, V, Compare>::sanityCheck() const -> bool {
+    Pin pin(*this);
+    const Node* tree = root.load();
+    if (check(tree) < 0) {
+      return false;
+    }
+
+    // The sizes are checked by check, the order is left
+    bool ordered = true;
+    const Node* previous = nullptr;
+    std::function<void(const Node*)> walk = [&](const Node* node) {
+      if (node == nullptr) {
+        return;
+      }
+      walk(node->left);
+      if (previous != nullptr && !comp(previous->key, node->key)) {
+        ordered = false;
+      }
+      previous = node;
+      walk(node->right);
+    };
+    walk(tree);
+
+    return ordered;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_lockfree<K, V, Compare>::height(const Node* node) -> int {
+    return node == nullptr ? 0 : node->height;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_lockfree<K, V, Compare>::count(const Node* node)
+    -> unsigned int {
+    return node == nullptr ? 0 : node->count;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_lockfree<K, V, Compare>::make(
+    const K& key,
+    const V& value,
+    const Node* left,
+    const Node* right
+  ) -> const Node* {
+    return new Node{
+      key,
+      value,
+      left,
+      right,
+      count(left) + count(right) + 1,
+      std::max(height(left), height(right)) + 1
+    };
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_lockfree<K, V, Compare>::balance(
+    const K& key,
+    const V& value,
+    const Node* left,
+    const Node* right,
+    std::vector<const Node*>& replaced
+  ) -> const Node* {
+    if (height(left) > height(right) + 1) {
+      if (height(left->left) >= height(left->right)) {
+        replaced.push_back(left);
+        return make(
+          left->key,
+          left->value,
+          left->left,
+          make(key, value, left->right, right)
+        );
+      }
+
+      const Node* middle = left->right;
+      replaced.push_back(left);
+      replaced.push_back(middle);
+      return make(
+        middle->key,
+        middle->value,
+        make(left->key, left->value, left->left, middle->left),
+        make(key, value, middle->right, right)
+      );
+    }
+
+    if (height(right) > height(left) + 1) {
+      if (height(right->right) >= height(right->left)) {
+        replaced.push_back(right);
+        return make(
+          right->key,
+          right->value,
+          make(key, value, left, right->left),
+          right->right
+        );
+      }
+
+      const Node* middle = right->left;
+      replaced.push_back(right);
+      replaced.push_back(middle);
+      return make(
+        middle->key,
+        middle->value,
+        make(key, value, left, middle->left),
+        make(right->key, right->value, middle->right, right->right)
+      );
+    }
+
+    return make(key, value, left, right);
+  }
+
+  template<typename K, typename V, typename Compare>
+  template<typename Entry>
+  auto AVLmap_lockfree<K, V, Compare>::build(
+    const std::vector<const Entry*>& nodes,
+    std::size_t first,
+    std::size_t last
+  ) -> const Node* {
+    if (first == last) {
+      return nullptr;
+    }
+
+    std::size_t middle = first + (last - first) / 2;
+    return make(
+      nodes[middle]->Key(),
+      nodes[middle]->Value(),
+      build(nodes, first, middle),
+      build(nodes, middle + 1, last)
+    );
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_lockfree<K, V, Compare>::destroy(const Node* node) -> void {
+    if (node == nullptr) {
+      return;
+    }
+
+    destroy(node->left);
+    destroy(node->right);
+    delete node;
+  }
+
+  template<typename K, typename V, typename Compare>
+  template<typename Function>
+  auto AVLmap_lockfree<K, V, Compare>::visit(
+    const Node* node,
+    Function& function
+  ) -> void {
+    if (node == nullptr) {
+      return;
+    }
+
+    visit(node->left, function);
+    function(node->key, node->value);
+    visit(node->right, function);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_lockfree<K, V, Compare>::search(
+    const Node* node,
+    const K& key
+  ) const -> const Node* {
+    while (node != nullptr) {
+      if (comp(key, node->key)) {
+        node = node->left;
+      } else if (comp(node->key, key)) {
+        node = node->right;
+      } else {
+        return node;
+      }
+    }
+
+    return nullptr;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_lockfree<K, V, Compare>::assign_into(
+    const Node* node,
+    const K& key,
+    const V& value,
+    std::vector<const Node*>& replaced
+  ) const -> const Node* {
+    if (node == nullptr) {
+      return make(key, value, nullptr, nullptr);
+    }
+
+    replaced.push_back(node);
+    if (comp(key, node->key)) {
+      return balance(
+        node->key,
+        node->value,
+        assign_into(node->left, key, value, replaced),
+        node->right,
+        replaced
+      );
+    }
+
+    if (comp(node->key, key)) {
+      return balance(
+        node->key,
+        node->value,
+        node->left,
+        assign_into(node->right, key, value, replaced),
+        replaced
+      );
+    }
+
+    return make(node->key, value, node->left, node->right);
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_lockfree<K, V, Compare>::erase_from(
+    const Node* node,
+    const K& key,
+    std::vector<const Node*>& replaced
+  ) const -> const Node* {
+    if (node == nullptr) {
+      return nullptr;
+    }
+
+    if (comp(key, node->key)) {
+      const Node* left = erase_from(node->left, key, replaced);
+      if (left == node->left) {
+        return node;
+      }
+
+      replaced.push_back(node);
+      return balance(node->key, node->value, left, node->right, replaced);
+    }
+
+    if (comp(node->key, key)) {
+      const Node* right = erase_from(node->right, key, replaced);
+      if (right == node->right) {
+        return node;
+      }
+
+      replaced.push_back(node);
+      return balance(node->key, node->value, node->left, right, replaced);
+    }
+
+    replaced.push_back(node);
+    if (node->left == nullptr) {
+      return node->right;
+    }
+    if (node->right == nullptr) {
+      return node->left;
+    }
+
+    // The successor takes the place of the node
+    const Node* successor = node->right;
+    while (successor->left != nullptr) {
+      successor = successor->left;
+    }
+
+    return balance(
+      successor->key,
+      successor->value,
+      node->left,
+      erase_min(node->right, replaced),
+      replaced
+    );
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_lockfree<K, V, Compare>::erase_min(
+    const Node* node,
+    std::vector<const Node*>& replaced
+  ) const -> const Node* {
+    replaced.push_back(node);
+    if (node->left == nullptr) {
+      return node->right;
+    }
+
+    return balance(
+      node->key,
+      node->value,
+      erase_min(node->left, replaced),
+      node->right,
+      replaced
+    );
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_lockfree<K, V, Compare>::check(const Node* node) const -> int {
+    if (node == nullptr) {
+      return 0;
+    }
+
+    int height_l = check(node->left);
+    int height_r = height_l < 0 ? -1 : check(node->right);
+
+    if (height_r < 0 || height_r - height_l < -1 || height_r - height_l > 1
+        || node->height != std::max(height_l, height_r) + 1
+        || node->count != count(node->left) + count(node->right) + 1) {
+      return -1;
+    }
+
+    return node->height;
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_lockfree<K, V, Compare>::publish(
+    const Node* tree,
+    const std::vector<const Node*>& replaced
+  ) -> void {
+    // Every node of the new tree was linked before this store, and readers
+    // load the root before following any link
+    root.store(tree);
+
+    // A read that started before the store may still hold these, so they
+    // wait for the epoch to move past it
+    std::uint64_t epoch = global_epoch.load();
+    for (const Node* node: replaced) {
+      retired.push_back(Retired{epoch, node});
+    }
+
+    collect();
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_lockfree<K, V, Compare>::pin() const -> Slot* {
+    // Each thread starts looking at its own slot, so reads from different
+    // threads rarely touch the same cache line
+    static thread_local const std::size_t home =
+      std::hash<std::thread::id>{}(std::this_thread::get_id()) % reader_slots;
+
+    for (std::size_t i = home;; i = (i + 1) % reader_slots) {
+      Slot& slot = slots[i];
+      std::uint64_t idle = 0;
+      if (slot.epoch.load(std::memory_order_relaxed) == 0
+          && slot.epoch.compare_exchange_strong(idle, global_epoch.load())) {
+        return &slot;
+      }
+
+      if ((i + 1) % reader_slots == home) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  template<typename K, typename V, typename Compare>
+  auto AVLmap_lockfree<K, V, Compare>::collect() -> void {
+    std::uint64_t epoch = global_epoch.load();
+
+    // The epoch only moves once every running read announced it, so a read
+    // is at most one epoch behind
+    bool caught_up = true;
+    for (const Slot& slot: slots) {
+      std::uint64_t announced = slot.epoch.load();
+      if (announced != 0 && announced != epoch) {
+        caught_up = false;
+        break;
+      }
+    }
+
+    if (caught_up) {
+      global_epoch.store(++epoch);
+    }
+
+    while (!retired.empty() && retired.front().epoch + 2 <= epoch) {
+      delete retired.front().node;
+      retired.pop_front();
+    }
+  }
+} // namespace CS280
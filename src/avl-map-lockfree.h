@@ -0,0 +1,421 @@
+/**
+ * @file avl-map-lockfree.h
+ * @author Edgar Jose Donoso Mansilla (e.donosomansilla)
+ * @course CS280
+ * @term Spring 2025
+ *
+ * @brief AVL map whose readers take no locks (epoch based reclamation)
+ */
+
+#ifndef AVLMAPLOCKFREE_H
+  #define AVLMAPLOCKFREE_H
+
+  #include <atomic>
+  #include <cstddef>
+  #include <cstdint>
+  #include <deque>
+  #include <functional>
+  #include <mutex>
+  #include <optional>
+  #include <vector>
+
+  #include "avl-map.h"
+
+namespace CS280 {
+
+  /**
+   * @brief AVL map that any amount of threads can read without locks while
+   * one thread at a time writes.
+   *
+   * Published nodes are never changed. A write copies the path from the root
+   * to the key (and the nodes its rotations move), links the copies before
+   * anything can see them, and publishes the new tree with a single store to
+   * the root. A reader loads the root once and walks a tree that stays whole
+   * for as long as it looks at it, so it can never see half of a rotation.
+   *
+   * The nodes a write replaced are retired instead of deleted: every read
+   * announces the epoch it started in, and a node retired in epoch e is
+   * freed once the epoch reached e + 2, which it can only do after every
+   * read that could still hold the node finished.
+   *
+   * Values are copied along with their nodes, so writes cost O(log n) copies
+   * of V.
+   *
+   * @param K The type for the key to be used
+   * @param V The type for the values to be used
+   * @param Compare The strict weak ordering of the keys
+   */
+  template<typename K, typename V, typename Compare = std::less<K>>
+  class AVLmap_lockfree {
+  public:
+
+    /**
+     * @brief Constructor
+     * @param comp The comparator used to order the keys
+     */
+    explicit AVLmap_lockfree(const Compare& comp = Compare{});
+
+    /**
+     * @brief Constructor from a map (builds a balanced tree in O(n))
+     * @param map The map
+     */
+    template<template<typename> class Pool>
+    explicit AVLmap_lockfree(const AVLmap<K, V, Compare, Pool>& map);
+
+    // Deleted copy constructor
+    AVLmap_lockfree(const AVLmap_lockfree&) = delete;
+
+    // Deleted copy assignment operator
+    auto operator=(const AVLmap_lockfree&) -> AVLmap_lockfree& = delete;
+
+    /**
+     * @brief Destructor (no read may still be running)
+     */
+    ~AVLmap_lockfree();
+
+    /**
+     * @brief Getter for the size of the map
+     * @return The amount of keys in the map
+     */
+    auto size() const -> unsigned int;
+
+    /**
+     * @brief Searches for a value using the key
+     * @param key The key to search for
+     * @return A copy of the value (empty if the key is not in the map)
+     */
+    auto find(const K& key) const -> std::optional<V>;
+
+    /**
+     * @brief Checks whether a key is in the map
+     * @param key The key to search for
+     * @return Whether it is there
+     */
+    auto contains(const K& key) const -> bool;
+
+    /**
+     * @brief Visits the keys in order, all from the same version of the map
+     * @param function Called with the key and the value of every node
+     */
+    template<typename Function>
+    auto for_each(Function&& function) const -> void;
+
+    /**
+     * @brief Sets the value of a key, adding it if it is not there
+     * @param key The key
+     * @param value The value
+     */
+    auto assign(const K& key, const V& value) -> void;
+
+    /**
+     * @brief Runs a function on a copy of the value of a key (default
+     * constructed if the key is not there) and stores the result
+     * @param key The key
+     * @param function Called with a reference to the copy
+     */
+    template<typename Function>
+    auto update(const K& key, Function&& function) -> void;
+
+    /**
+     * @brief Erases a key
+     * @param key The key
+     * @return Whether the key was there
+     */
+    auto erase(const K& key) -> bool;
+
+    /**
+     * @brief Moves the epoch forward if every read caught up, and frees the
+     * nodes no read can hold anymore (writes already do this)
+     */
+    auto reclaim() -> void;
+
+    /**
+     * @brief Getter for the amount of retired nodes not freed yet
+     * @return The amount
+     */
+    auto retired_nodes() -> std::size_t;
+
+    /**
+     * @brief Checks the order, the heights, the balances and the sizes
+     * @return Whether the tree is a valid AVL tree
+     */
+    auto sanityCheck() const -> bool;
+
+  private:
+
+    /**
+     * @brief A node of the map, never changed once it was published.
+     */
+    struct Node {
+      /**
+       * @brief The key of this node.
+       */
+      K key;
+
+      /**
+       * @brief The value of this node.
+       */
+      V value;
+
+      /**
+       * @brief The left child's pointer
+       */
+      const Node* left;
+
+      /**
+       * @brief The right child's pointer
+       */
+      const Node* right;
+
+      /**
+       * @brief The amount of nodes in the sub-tree
+       */
+      unsigned int count;
+
+      /**
+       * @brief The distance of the node relative to the leaves of the sub-tree
+       */
+      int height;
+    };
+
+    /**
+     * @brief A node waiting for the reads that could hold it.
+     */
+    struct Retired {
+      /**
+       * @brief The epoch it was retired in.
+       */
+      std::uint64_t epoch;
+
+      /**
+       * @brief The node.
+       */
+      const Node* node;
+    };
+
+    /**
+     * @brief The epoch a read started in (0 while the slot is free), alone in
+     * its cache line so readers do not invalidate each other.
+     */
+    struct alignas(64) Slot {
+      std::atomic<std::uint64_t> epoch{0};
+    };
+
+    /**
+     * @brief Holds a slot for the length of a read.
+     */
+    class Pin {
+    public:
+
+      /**
+       * @brief Constructor (announces the current epoch)
+       * @param map The map to be read
+       */
+      explicit Pin(const AVLmap_lockfree& map);
+
+      // Deleted copy constructor
+      Pin(const Pin&) = delete;
+
+      // Deleted copy assignment operator
+      auto operator=(const Pin&) -> Pin& = delete;
+
+      /**
+       * @brief Destructor (frees the slot)
+       */
+      ~Pin();
+
+    private:
+
+      /**
+       * @brief The slot held.
+       */
+      Slot* slot;
+    };
+
+    /**
+     * @brief Amount of reads that can run at once (more wait for a slot).
+     */
+    static constexpr std::size_t reader_slots{128};
+
+    /**
+     * @brief Getter for the height of a sub-tree
+     * @param node The root of the sub-tree (can be null)
+     */
+    static auto height(const Node* node) -> int;
+
+    /**
+     * @brief Getter for the size of a sub-tree
+     * @param node The root of the sub-tree (can be null)
+     */
+    static auto count(const Node* node) -> unsigned int;
+
+    /**
+     * @brief Builds a node over two sub-trees
+     * @param key The key
+     * @param value The value
+     * @param left The left sub-tree
+     * @param right The right sub-tree
+     * @return The node
+     */
+    static auto make(
+      const K& key,
+      const V& value,
+      const Node* left,
+      const Node* right
+    ) -> const Node*;
+
+    /**
+     * @brief Builds a node over two sub-trees whose heights differ by up to
+     * 2, rotating copies of them if needed
+     * @param key The key
+     * @param value The value
+     * @param left The left sub-tree
+     * @param right The right sub-tree
+     * @param replaced Gets the nodes the rotations copied
+     * @return The root of the balanced sub-tree
+     */
+    static auto balance(
+      const K& key,
+      const V& value,
+      const Node* left,
+      const Node* right,
+      std::vector<const Node*>& replaced
+    ) -> const Node*;
+
+    /**
+     * @brief Builds a balanced tree from nodes in key order
+     * @param nodes The nodes of a map
+     * @param first The first one to be used
+     * @param last One past the last one to be used
+     * @return The root of the tree
+     */
+    template<typename Entry>
+    static auto build(
+      const std::vector<const Entry*>& nodes,
+      std::size_t first,
+      std::size_t last
+    ) -> const Node*;
+
+    /**
+     * @brief Deletes a sub-tree
+     * @param node The root of the sub-tree
+     */
+    static auto destroy(const Node* node) -> void;
+
+    /**
+     * @brief Visits a sub-tree in order
+     * @param node The root of the sub-tree
+     * @param function Called with the key and the value of every node
+     */
+    template<typename Function>
+    static auto visit(const Node* node, Function& function) -> void;
+
+    /**
+     * @brief Searches a tree for a key
+     * @param node The root of the tree
+     * @param key The key
+     * @return The node (null if the key is not there)
+     */
+    auto search(const Node* node, const K& key) const -> const Node*;
+
+    /**
+     * @brief Copies a sub-tree with the value of a key set
+     * @param node The root of the sub-tree
+     * @param key The key
+     * @param value The value
+     * @param replaced Gets the nodes that were copied
+     * @return The root of the copy
+     */
+    auto assign_into(
+      const Node* node,
+      const K& key,
+      const V& value,
+      std::vector<const Node*>& replaced
+    ) const -> const Node*;
+
+    /**
+     * @brief Copies a sub-tree without a key
+     * @param node The root of the sub-tree
+     * @param key The key
+     * @param replaced Gets the nodes that were copied or removed
+     * @return The root of the copy (node itself if the key is not there)
+     */
+    auto erase_from(
+      const Node* node,
+      const K& key,
+      std::vector<const Node*>& replaced
+    ) const -> const Node*;
+
+    /**
+     * @brief Copies a sub-tree without its smallest key
+     * @param node The root of the sub-tree
+     * @param replaced Gets the nodes that were copied or removed
+     * @return The root of the copy
+     */
+    auto erase_min(const Node* node, std::vector<const Node*>& replaced) const
+      -> const Node*;
+
+    /**
+     * @brief Checks a sub-tree.
+     * @param node The root of the sub-tree.
+     * @return The height of the sub-tree (-1 if it is not valid).
+     */
+    auto check(const Node* node) const -> int;
+
+    /**
+     * @brief Publishes a new tree and retires the nodes of the old one it
+     * does not share (write_lock must be held)
+     * @param tree The new root
+     * @param replaced The nodes to be retired
+     */
+    auto publish(const Node* tree, const std::vector<const Node*>& replaced)
+      -> void;
+
+    /**
+     * @brief Takes a free slot and announces the current epoch in it
+     * @return The slot
+     */
+    auto pin() const -> Slot*;
+
+    /**
+     * @brief reclaim, with write_lock held
+     */
+    auto collect() -> void;
+
+    /**
+     * @brief The comparator used to order the keys.
+     */
+    Compare comp{};
+
+    /**
+     * @brief The root of the current version (only written by writers).
+     */
+    alignas(64) std::atomic<const Node*> root{nullptr};
+
+    /**
+     * @brief The current epoch (only written by writers).
+     */
+    std::atomic<std::uint64_t> global_epoch{1};
+
+    /**
+     * @brief The epochs of the reads running.
+     */
+    mutable Slot slots[reader_slots]{};
+
+    /**
+     * @brief Taken by writes.
+     */
+    std::mutex write_lock{};
+
+    /**
+     * @brief The nodes waiting to be freed, oldest first.
+     */
+    std::deque<Retired> retired{};
+  };
+} // namespace CS280
+
+  #ifndef AVLMAPLOCKFREE_CPP
+    #include "avl-map-lockfree.cpp"
+  #endif
+
+#endif
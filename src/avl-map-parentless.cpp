@@ -0,0 +1,945 @@
+/**
+ * @file avl-map-parentless.cpp
+ * @author Edgar Jose Donoso Mansilla (e.donosomansilla)
+ * @course CS280
+ * @term Spring 2025
+ *
+ * @brief Implementation for the AVL map whose nodes have no parent links
+ */
+
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#define AVLMAPPARENTLESS_CPP
+
+#ifndef AVLMAPPARENTLESS_H
+  #include "avl-map-parentless.h"
+#endif
+
+namespace CS280 {
+
+  /// AVL Methods
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap_parentless<K, V, Compare, Pool>::AVLmap_parentless() {}
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap_parentless<K, V, Compare, Pool>::AVLmap_parentless(
+    const Compare& comp
+  ):
+      comp(comp) {}
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap_parentless<K, V, Compare, Pool>::AVLmap_parentless(
+    const AVLmap_parentless& rhs
+  ):
+      comp(rhs.comp), size_(0) {
+    pool.reserve(rhs.size_);
+    root = clone(rhs.root);
+    size_ = rhs.size_;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::operator=(
+    const AVLmap_parentless& rhs
+  ) -> AVLmap_parentless& {
+    if (this == &rhs) {
+      return *this;
+    }
+
+    clear();
+
+    comp = rhs.comp;
+    pool.reserve(rhs.size_);
+    root = clone(rhs.root);
+    size_ = rhs.size_;
+
+    return *this;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap_parentless<K, V, Compare, Pool>::AVLmap_parentless(
+    AVLmap_parentless&& rhs
+  ):
+      comp(std::move(rhs.comp)),
+      pool(std::move(rhs.pool)),
+      root(std::exchange(rhs.root, nullptr)),
+      size_(std::exchange(rhs.size_, 0)) {}
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::operator=(
+    AVLmap_parentless&& rhs
+  ) -> AVLmap_parentless& {
+    if (this == &rhs) {
+      return *this;
+    }
+
+    clear();
+
+    comp = std::move(rhs.comp);
+    pool = std::move(rhs.pool);
+    root = std::exchange(rhs.root, nullptr);
+    size_ = std::exchange(rhs.size_, 0);
+
+    return *this;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap_parentless<K, V, Compare, Pool>::~AVLmap_parentless() {
+    clear();
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::size() const -> unsigned int {
+    return size_;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::operator[](const K& key) -> V& {
+    Node* path[max_depth];
+    std::size_t depth = 0;
+    Node* candidate = nullptr;
+    bool as_left = false;
+
+    for (Node* current = root; current != nullptr;) {
+      path[depth++] = current;
+      as_left = comp(key, current->key);
+
+      if (as_left) {
+        current = current->left;
+      } else {
+        candidate = current;
+        current = current->right;
+      }
+    }
+
+    if (candidate != nullptr && !comp(candidate->key, key)) {
+      return candidate->value;
+    }
+
+    Node* node = pool.allocate();
+    try {
+      new (node) Node(key);
+    } catch (...) {
+      pool.deallocate(node);
+      throw;
+    }
+
+    if (depth == 0) {
+      root = node;
+    } else if (as_left) {
+      path[depth - 1]->left = node;
+    } else {
+      path[depth - 1]->right = node;
+    }
+
+    size_++;
+    retrace(path, depth);
+
+    return node->value;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::begin() -> iterator {
+    return ++iterator(root);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::end() -> iterator {
+    return iterator(root);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::begin() const
+    -> const_iterator {
+    return ++const_iterator(root);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::end() const -> const_iterator {
+    return const_iterator(root);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::find(const K& key) -> iterator {
+    iterator it(root);
+    it.depth = search(key, it.path.data());
+    return it;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::find(const K& key) const
+    -> const_iterator {
+    const_iterator it(root);
+    it.depth = search(key, it.path.data());
+    return it;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::erase(iterator it) -> void {
+    if (it.depth == 0) {
+      return;
+    }
+
+    Node** path = it.path.data();
+    std::size_t depth = it.depth;
+    std::size_t index = depth - 1;
+    Node* node = path[index];
+
+    if (node->left == nullptr || node->right == nullptr) {
+      relink(path, index, node->left != nullptr ? node->left : node->right);
+      depth--;
+    } else {
+      // The predecessor is spliced into the place of the node and replaces it
+      // in the path, which then ends where the predecessor was taken from
+      Node* predecessor = node->left;
+      path[depth++] = predecessor;
+      while (predecessor->right != nullptr) {
+        predecessor = predecessor->right;
+        path[depth++] = predecessor;
+      }
+
+      if (predecessor != node->left) {
+        path[depth - 2]->right = predecessor->left;
+        predecessor->left = node->left;
+      }
+
+      predecessor->right = node->right;
+      predecessor->height = node->height;
+      relink(path, index, predecessor);
+      path[index] = predecessor;
+      depth--;
+    }
+
+    size_--;
+    retrace(path, depth);
+
+    node->~Node();
+    pool.deallocate(node);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::sanityCheck() const -> bool {
+    unsigned count = 0;
+    if (check(root, count) < 0 || count != size_) {
+      return false;
+    }
+
+    if (root == nullptr) {
+      return true;
+    }
+
+    const_iterator previous = begin();
+    for (const_iterator it = ++begin(); it != end(); ++it, ++previous) {
+      if (!comp(previous->key, it->key)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::pool_stats() const
+    -> const PoolStats& {
+    return pool.stats();
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::step_forward(
+    Node** path,
+    std::size_t& depth
+  ) -> void {
+    Node* node = path[depth - 1];
+
+    if (node->right != nullptr) {
+      node = node->right;
+      path[depth++] = node;
+
+      while (node->left != nullptr) {
+        node = node->left;
+        path[depth++] = node;
+      }
+
+      return;
+    }
+
+    // Climb while coming back from a right child
+    Node* child = nullptr;
+    do {
+      child = path[--depth];
+    } while (depth > 0 && path[depth - 1]->right == child);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::step_back(
+    Node** path,
+    std::size_t& depth,
+    Node* root
+  ) -> void {
+    if (depth == 0) {
+      for (Node* node = root; node != nullptr; node = node->right) {
+        path[depth++] = node;
+      }
+      return;
+    }
+
+    Node* node = path[depth - 1];
+
+    if (node->left != nullptr) {
+      node = node->left;
+      path[depth++] = node;
+
+      while (node->right != nullptr) {
+        node = node->right;
+        path[depth++] = node;
+      }
+
+      return;
+    }
+
+    // Climb while coming back from a left child
+    Node* child = nullptr;
+    do {
+      child = path[--depth];
+    } while (depth > 0 && path[depth - 1]->left == child);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::height_of(const Node* node)
+    -> int {
+    return node != nullptr ? node->height : 0;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::update_height(Node* node)
+    -> void {
+    node->height = static_cast<std::uint8_t>(
+      std::max(height_of(node->left), height_of(node->right)) + 1
+    );
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::rotate_left(Node* node)
+    -> Node* {
+    Node* promoted = node->right;
+    node->right = promoted->left;
+    promoted->left = node;
+
+    update_height(node);
+    update_height(promoted);
+
+    return promoted;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::rotate_right(Node* node)
+    -> Node* {
+    Node* promoted = node->left;
+    node->left = promoted->right;
+    promoted->right = node;
+
+    update_height(node);
+    update_height(promoted);
+
+    return promoted;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::rebalance(Node* node)
+    -> Node* {
+    update_height(node);
+    int balance = height_of(node->right) - height_of(node->left);
+
+    if (balance > 1) {
+      if (height_of(node->right->right) < height_of(node->right->left)) {
+        node->right = rotate_right(node->right);
+      }
+      return rotate_left(node);
+    }
+
+    if (balance < -1) {
+      if (height_of(node->left->left) < height_of(node->left->right)) {
+        node->left = rotate_left(node->left);
+      }
+      return rotate_right(node);
+    }
+
+    return node;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::relink(
+    Node* const* path,
+    std::size_t index,
+    Node* replacement
+  ) -> void {
+    if (index == 0) {
+      root = replacement;
+    } else if (path[index - 1]->left == path[index]) {
+      path[index - 1]->left = replacement;
+    } else {
+      path[index - 1]->right = replacement;
+    }
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::retrace(
+    Node** path,
+    std::size_t depth
+  ) -> void {
+    while (depth > 0) {
+      depth--;
+      Node* node = path[depth];
+      std::uint8_t previous_height = node->height;
+
+      Node* subtree = rebalance(node);
+      if (subtree != node) {
+        relink(path, depth, subtree);
+      }
+
+      // The ancestors only need updating if the subtree height changed
+      if (subtree->height == previous_height) {
+        return;
+      }
+    }
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::search(
+    const K& key,
+    Node** path
+  ) const -> std::size_t {
+    std::size_t depth = 0;
+    std::size_t candidate_depth = 0;
+    Node* candidate = nullptr;
+
+    for (Node* current = root; current != nullptr;) {
+      path[depth++] = current;
+
+      if (comp(key, current->key)) {
+        current = current->left;
+      } else {
+        candidate = current;
+        candidate_depth = depth;
+        current = current->right;
+      }
+    }
+
+    if (candidate == nullptr || comp(candidate->key, key)) {
+      return 0;
+    }
+
+    return candidate_depth;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::clone(const Node* source)
+    -> Node* {
+    if (source == nullptr) {
+      return nullptr;
+    }
+
+    Node* node = pool.allocate();
+    try {
+      new (node) Node(source->key, source->value);
+    } catch (...) {
+      pool.deallocate(node);
+      throw;
+    }
+
+    node->height = source->height;
+
+    // A failed child cleaned up after itself, what was cloned so far hangs
+    // from node
+    try {
+      node->left = clone(source->left);
+      node->right = clone(source->right);
+    } catch (...) {
+      destroy(node);
+      throw;
+    }
+
+    return node;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::check(
+    const Node* node,
+    unsigned& count
+  ) const -> int {
+    if (node == nullptr) {
+      return 0;
+    }
+
+    // The count guards against cycles
+    if (++count > size_) {
+      return -1;
+    }
+
+    int height_l = check(node->left, count);
+    int height_r = height_l < 0 ? -1 : check(node->right, count);
+
+    if (height_r < 0 || height_r - height_l < -1 || height_r - height_l > 1
+        || node->height != std::max(height_l, height_r) + 1) {
+      return -1;
+    }
+
+    return node->height;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::clear() -> void {
+    if (root == nullptr) {
+      pool.release();
+      return;
+    }
+
+    // Nodes that need no destruction can go back with their slabs at once
+    if (node_pool::bulk_release && std::is_trivially_destructible<K>::value
+        && std::is_trivially_destructible<V>::value && pool.unique()) {
+      root = nullptr;
+      size_ = 0;
+      pool.release();
+      return;
+    }
+
+    destroy(root);
+    root = nullptr;
+    size_ = 0;
+    pool.release();
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::destroy(Node* node) -> void {
+    // Rotating every left child up turns the tree into a list leaning right,
+    // so the nodes can be destroyed in order without any extra memory
+    Node* current = node;
+
+    while (current != nullptr) {
+      if (current->left != nullptr) {
+        Node* promoted = current->left;
+        current->left = promoted->right;
+        promoted->right = current;
+        current = promoted;
+        continue;
+      }
+
+      Node* next = current->right;
+      current->~Node();
+      pool.deallocate(current);
+      current = next;
+    }
+  }
+
+  /// Node Methods
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename KeyArg, typename... Args>
+  AVLmap_parentless<K, V, Compare, Pool>::Node::Node(
+    KeyArg&& k,
+    Args&&... args
+  ):
+      key(std::forward<KeyArg>(k)), value(std::forward<Args>(args)...) {}
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::Node::Key() const -> const K& {
+    return key;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::Node::Value() -> V& {
+    return value;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::Node::Value() const
+    -> const V& {
+    return value;
+  }
+
+  /// Iterator Methods
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap_parentless<K, V, Compare, Pool>::AVLmap_parentless_iterator::
+    AVLmap_parentless_iterator(Node* r):
+      root(r), path(), depth(0) {}
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap_parentless<K, V, Compare, Pool>::AVLmap_parentless_iterator::
+  operator AVLmap_parentless_iterator_const() const {
+    AVLmap_parentless_iterator_const it(root);
+    it.path = path;
+    it.depth = depth;
+    return it;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::AVLmap_parentless_iterator::
+  operator++() -> AVLmap_parentless_iterator& {
+    if (depth == 0) {
+      // from end (or a fresh iterator) to the first node
+      for (Node* node = root; node != nullptr; node = node->left) {
+        path[depth++] = node;
+      }
+      return *this;
+    }
+
+    step_forward(path.data(), depth);
+    return *this;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::AVLmap_parentless_iterator::
+  operator++(int) -> AVLmap_parentless_iterator {
+    AVLmap_parentless_iterator previous = *this;
+    ++*this;
+    return previous;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::AVLmap_parentless_iterator::
+  operator--() -> AVLmap_parentless_iterator& {
+    step_back(path.data(), depth, root);
+    return *this;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::AVLmap_parentless_iterator::
+  operator--(int) -> AVLmap_parentless_iterator {
+    AVLmap_parentless_iterator previous = *this;
+    step_back(path.data(), depth, root);
+    return previous;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::AVLmap_parentless_iterator::
+  operator*() const -> Node& {
+    return *path[depth - 1];
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::AVLmap_parentless_iterator::
+  operator->() const -> Node* {
+    return path[depth - 1];
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::AVLmap_parentless_iterator::
+  operator!=(const AVLmap_parentless_iterator& rhs) const -> bool {
+    return !(*this == rhs);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::AVLmap_parentless_iterator::
+  operator==(const AVLmap_parentless_iterator& rhs) const -> bool {
+    if (depth == 0 || rhs.depth == 0) {
+      return depth == rhs.depth;
+    }
+
+    return path[depth - 1] == rhs.path[rhs.depth - 1];
+  }
+
+  /// Const Iterator Methods
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap_parentless<K, V, Compare, Pool>::AVLmap_parentless_iterator_const::
+    AVLmap_parentless_iterator_const(Node* r):
+      root(r), path(), depth(0) {}
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::
+    AVLmap_parentless_iterator_const::operator++()
+      -> AVLmap_parentless_iterator_const& {
+    if (depth == 0) {
+      // from end (or a fresh iterator) to the first node
+      for (Node* node = root; node != nullptr; node = node->left) {
+        path[depth++] = node;
+      }
+      return *this;
+    }
+
+    step_forward(path.data(), depth);
+    return *this;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::
+    AVLmap_parentless_iterator_const::operator++(int)
+      -> AVLmap_parentless_iterator_const {
+    AVLmap_parentless_iterator_const previous = *this;
+    ++*this;
+    return previous;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::
+    AVLmap_parentless_iterator_const::operator--()
+      -> AVLmap_parentless_iterator_const& {
+    step_back(path.data(), depth, root);
+    return *this;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::
+    AVLmap_parentless_iterator_const::operator--(int)
+      -> AVLmap_parentless_iterator_const {
+    AVLmap_parentless_iterator_const previous = *this;
+    step_back(path.data(), depth, root);
+    return previous;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::
+    AVLmap_parentless_iterator_const::operator*() const -> const Node& {
+    return *path[depth - 1];
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::
+    AVLmap_parentless_iterator_const::operator->() const -> const Node* {
+    return path[depth - 1];
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::
+    AVLmap_parentless_iterator_const::operator!=(
+      const AVLmap_parentless_iterator_const& rhs
+    ) const -> bool {
+    return !(*this == rhs);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap_parentless<K, V, Compare, Pool>::
+    AVLmap_parentless_iterator_const::operator==(
+      const AVLmap_parentless_iterator_const& rhs
+    ) const -> bool {
+    if (depth == 0 || rhs.depth == 0) {
+      return depth == rhs.depth;
+    }
+
+    return path[depth - 1] == rhs.path[rhs.depth - 1];
+  }
+} // namespace CS280
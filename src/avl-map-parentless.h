@@ -0,0 +1,529 @@
+/**
+ * @file avl-map-parentless.h
+ * @author Edgar Jose Donoso Mansilla (e.donosomansilla)
+ * @course CS280
+ * @term Spring 2025
+ *
+ * @brief AVL map whose nodes have no parent links
+ */
+
+#ifndef AVLMAPPARENTLESS_H
+  #define AVLMAPPARENTLESS_H
+
+  #include <array>
+  #include <cstdint>
+  #include <functional>
+
+  #include "node-pool.h"
+
+namespace CS280 {
+
+  /**
+   * @brief AVL map whose nodes only link to their children. Insertion and
+   * erasure record the path from the root on a fixed size stack and retrace
+   * along it, and the iterators carry that same stack, so rotations never
+   * have to patch parent links.
+   *
+   * Iterators are invalidated by any insertion or erasure (their stack would
+   * no longer match the tree).
+   *
+   * @param K The type for the key to be used
+   * @param V The type for the values to be used
+   * @param Compare The strict weak ordering of the keys
+   * @param Pool The allocation policy for the nodes
+   */
+  template<
+    typename K,
+    typename V,
+    typename Compare = std::less<K>,
+    template<typename> class Pool = NodePool>
+  class AVLmap_parentless {
+
+    // Forward declarations for the struct
+    struct AVLmap_parentless_iterator;
+    struct AVLmap_parentless_iterator_const;
+
+  public:
+
+    // standard names for iterator types
+    typedef AVLmap_parentless_iterator iterator;
+    typedef AVLmap_parentless_iterator_const const_iterator;
+
+    class Node;
+
+    // the allocation policy instantiated for the nodes of this map
+    typedef Pool<Node> node_pool;
+
+    /**
+     * @brief Deepest path the stacks can hold. An AVL tree of height h has at
+     * least F(h + 2) - 1 nodes, so 2^32 nodes fit in a height of 46.
+     */
+    static constexpr std::size_t max_depth{48};
+
+    /**
+     * @brief This class represents a Node in the map.
+     */
+    class Node {
+    public:
+
+      /**
+       * @brief Constructor for an unlinked leaf that builds the key and the
+       * value in place.
+       *
+       * @param k The argument to construct the key from.
+       * @param args The arguments to construct the value from.
+       */
+      template<typename KeyArg, typename... Args>
+      Node(KeyArg&& k, Args&&... args);
+
+      // Deleted copy constructor
+      Node(const Node&) = delete;
+
+      // Deleted copy assignment operator
+      auto operator=(const Node&) -> Node& = delete;
+
+      /**
+       * @brief Getter of a reference to the key of this node.
+       * @return Const reference to the key.
+       */
+      auto Key() const -> const K&;
+
+      /**
+       * @brief Getter of a reference to the value of this node.
+       * @return Reference to the value.
+       */
+      auto Value() -> V&;
+
+      /**
+       * @brief Getter of a reference to the value of this node.
+       * @return Reference to the value.
+       */
+      auto Value() const -> const V&;
+
+    private:
+
+      /**
+       * @brief The key of this node.
+       */
+      K key;
+
+      /**
+       * @brief The value that is being held by the node.
+       */
+      V value;
+
+      /**
+       * @brief The distance of the node relative to the leaves of the sub-tree
+       */
+      std::uint8_t height{1};
+
+      /**
+       * @brief The left child's pointer
+       */
+      Node* left{nullptr};
+
+      /**
+       * @brief The right child's pointer
+       */
+      Node* right{nullptr};
+
+      // Friending the map class so the internals can be accessed.
+      friend AVLmap_parentless;
+    };
+
+  private:
+
+    /**
+     * @brief This class is the non const iterator of the map. It holds the
+     * path from the root to its node.
+     */
+    struct AVLmap_parentless_iterator {
+    private:
+
+      /**
+       * @brief The root of the map (to step back from end).
+       */
+      Node* root;
+
+      /**
+       * @brief The nodes from the root to the iterator's node.
+       */
+      std::array<Node*, max_depth> path;
+
+      /**
+       * @brief Amount of nodes in the path (0 for end).
+       */
+      std::size_t depth;
+
+    public:
+
+      /**
+       * @brief Constructor for an end iterator
+       * @param r The root of the map
+       */
+      AVLmap_parentless_iterator(Node* r = nullptr);
+
+      /**
+       * @brief Conversion operator into const
+       */
+      operator AVLmap_parentless_iterator_const() const;
+
+      /**
+       * @brief Pre-increment operator (successor)
+       */
+      auto operator++() -> AVLmap_parentless_iterator&;
+
+      /**
+       * @brief Post-increment operator (successor)
+       */
+      auto operator++(int) -> AVLmap_parentless_iterator;
+
+      /**
+       * @brief Pre-decrement operator (predecessor)
+       */
+      auto operator--() -> AVLmap_parentless_iterator&;
+
+      /**
+       * @brief Post-decrement operator (predecessor)
+       */
+      auto operator--(int) -> AVLmap_parentless_iterator;
+
+      /**
+       * @brief Dereferencing operator.
+       * @return Reference to the node.
+       */
+      auto operator*() const -> Node&;
+
+      /**
+       * @brief Arrow operator.
+       * @return Pointer to the node.
+       */
+      auto operator->() const -> Node*;
+
+      /**
+       * @brief Inequality operator.
+       */
+      auto operator!=(const AVLmap_parentless_iterator& rhs) const -> bool;
+
+      /**
+       * @brief Equality operator.
+       */
+      auto operator==(const AVLmap_parentless_iterator& rhs) const -> bool;
+
+      friend AVLmap_parentless;
+    };
+
+    /**
+     * @brief This class is the const iterator of the map. It holds the path
+     * from the root to its node.
+     */
+    struct AVLmap_parentless_iterator_const {
+    private:
+
+      /**
+       * @brief The root of the map (to step back from end).
+       */
+      Node* root;
+
+      /**
+       * @brief The nodes from the root to the iterator's node.
+       */
+      std::array<Node*, max_depth> path;
+
+      /**
+       * @brief Amount of nodes in the path (0 for end).
+       */
+      std::size_t depth;
+
+    public:
+
+      /**
+       * @brief Constructor for an end iterator
+       * @param r The root of the map
+       */
+      AVLmap_parentless_iterator_const(Node* r = nullptr);
+
+      /**
+       * @brief Pre-increment operator (successor)
+       */
+      auto operator++() -> AVLmap_parentless_iterator_const&;
+
+      /**
+       * @brief Post-increment operator (successor)
+       */
+      auto operator++(int) -> AVLmap_parentless_iterator_const;
+
+      /**
+       * @brief Pre-decrement operator (predecessor)
+       */
+      auto operator--() -> AVLmap_parentless_iterator_const&;
+
+      /**
+       * @brief Post-decrement operator (predecessor)
+       */
+      auto operator--(int) -> AVLmap_parentless_iterator_const;
+
+      /**
+       * @brief Dereferencing operator.
+       * @return Reference to the node.
+       */
+      auto operator*() const -> const Node&;
+
+      /**
+       * @brief Arrow operator.
+       * @return Pointer to the node.
+       */
+      auto operator->() const -> const Node*;
+
+      /**
+       * @brief Inequality operator.
+       */
+      auto operator!=(const AVLmap_parentless_iterator_const& rhs) const
+        -> bool;
+
+      /**
+       * @brief Equality operator.
+       */
+      auto operator==(const AVLmap_parentless_iterator_const& rhs) const
+        -> bool;
+
+      friend AVLmap_parentless;
+    };
+
+  public:
+
+    // Rule of 5
+
+    /**
+     * @brief Constructor
+     */
+    AVLmap_parentless();
+
+    /**
+     * @brief Constructor with a comparator
+     * @param comp The comparator used to order the keys
+     */
+    explicit AVLmap_parentless(const Compare& comp);
+
+    /**
+     * @brief Copy Constructor (copies the structure of rhs)
+     */
+    AVLmap_parentless(const AVLmap_parentless& rhs);
+
+    /**
+     * @brief Copy Assignment Operator
+     */
+    auto operator=(const AVLmap_parentless& rhs) -> AVLmap_parentless&;
+
+    /**
+     * @brief Move Constructor
+     */
+    AVLmap_parentless(AVLmap_parentless&& rhs);
+
+    /**
+     * @brief Move Assignment Operator
+     */
+    auto operator=(AVLmap_parentless&& rhs) -> AVLmap_parentless&;
+
+    /**
+     * @brief Destructor
+     */
+    ~AVLmap_parentless();
+
+    /**
+     * @brief Getter for the size of the map
+     * @return The amount of nodes in the map
+     */
+    auto size() const -> unsigned int;
+
+    /**
+     * @brief Indexer for the map
+     * @param key The key to search for (will create a node if there isn't one)
+     * @return Reference to the value
+     */
+    auto operator[](const K& key) -> V&;
+
+    /**
+     * @brief Returns an iterator to the first node of the tree
+     */
+    auto begin() -> iterator;
+
+    /**
+     * @brief Returns an iterator to one past the last node of the tree
+     */
+    auto end() -> iterator;
+
+    /**
+     * @brief Returns a const iterator to the first node of the tree
+     */
+    auto begin() const -> const_iterator;
+
+    /**
+     * @brief Returns a const iterator to one past the last node of the tree
+     */
+    auto end() const -> const_iterator;
+
+    /**
+     * @brief Searches for a value using the key
+     * @param key The key to search for
+     * @return The iterator to the node (or end if not found)
+     */
+    auto find(const K& key) -> iterator;
+
+    /**
+     * @brief Searches for a value using the key
+     * @param key The key to search for
+     * @return The iterator to the node (or end if not found)
+     */
+    auto find(const K& key) const -> const_iterator;
+
+    /**
+     * @brief Erases the node the iterator points to, retracing along the path
+     * the iterator holds
+     */
+    auto erase(iterator it) -> void;
+
+    /**
+     * @brief Checks the order, the heights and the balances
+     * @return Whether the tree is a valid AVL tree
+     */
+    auto sanityCheck() const -> bool;
+
+    /**
+     * @brief Getter for the counters of the node pool
+     * @return The allocation counters and the bytes used per node
+     */
+    auto pool_stats() const -> const PoolStats&;
+
+  private:
+
+    /**
+     * @brief Moves a path to the successor of its last node.
+     * @param path The nodes from the root.
+     * @param depth The amount of nodes in the path (0 for end).
+     */
+    static auto step_forward(Node** path, std::size_t& depth) -> void;
+
+    /**
+     * @brief Moves a path to the predecessor of its last node.
+     * @param path The nodes from the root.
+     * @param depth The amount of nodes in the path (0 for end).
+     * @param root The root of the tree (where end steps back from).
+     */
+    static auto step_back(Node** path, std::size_t& depth, Node* root)
+      -> void;
+
+    /**
+     * @brief Getter for the height of a subtree.
+     * @param node The root of the subtree (can be nullptr).
+     * @return The height.
+     */
+    static auto height_of(const Node* node) -> int;
+
+    /**
+     * @brief Recomputes the height of a node from its children.
+     * @param node The node.
+     */
+    static auto update_height(Node* node) -> void;
+
+    /**
+     * @brief Left rotation about a node.
+     * @param node The node to rotate about.
+     * @return The node that took its place.
+     */
+    static auto rotate_left(Node* node) -> Node*;
+
+    /**
+     * @brief Right rotation about a node.
+     * @param node The node to rotate about.
+     * @return The node that took its place.
+     */
+    static auto rotate_right(Node* node) -> Node*;
+
+    /**
+     * @brief Updates the height of a node and rotates it if it is out of
+     * balance.
+     * @param node The node.
+     * @return The root of the subtree after the rotations.
+     */
+    static auto rebalance(Node* node) -> Node*;
+
+    /**
+     * @brief Points the link to path[index] from its parent (or the root) to
+     * another node.
+     * @param path The nodes from the root.
+     * @param index The position of the node in the path.
+     * @param replacement The node to link instead.
+     */
+    auto relink(Node* const* path, std::size_t index, Node* replacement)
+      -> void;
+
+    /**
+     * @brief Walks up a path updating heights and rotating where needed,
+     * until a subtree keeps the height it had before the update.
+     * @param path The nodes from the root.
+     * @param depth The amount of nodes in the path.
+     */
+    auto retrace(Node** path, std::size_t depth) -> void;
+
+    /**
+     * @brief Records the path to the node holding a key.
+     * @param key The key to search for.
+     * @param path The path to fill.
+     * @return The amount of nodes in the path (0 if the key is not there).
+     */
+    auto search(const K& key, Node** path) const -> std::size_t;
+
+    /**
+     * @brief Copies a subtree.
+     * @param source The subtree to copy.
+     * @return The copy.
+     */
+    auto clone(const Node* source) -> Node*;
+
+    /**
+     * @brief Checks a subtree.
+     * @param node The root of the subtree.
+     * @param count Incremented for every node visited.
+     * @return The height of the subtree (-1 if it is not valid).
+     */
+    auto check(const Node* node, unsigned& count) const -> int;
+
+    /**
+     * @brief Destroys every node.
+     */
+    auto clear() -> void;
+
+    /**
+     * @brief Destroys a subtree.
+     * @param node The root of the subtree.
+     */
+    auto destroy(Node* node) -> void;
+
+    /**
+     * @brief The comparator used to order the keys.
+     */
+    Compare comp{};
+
+    /**
+     * @brief The pool the nodes are allocated from.
+     */
+    node_pool pool{};
+
+    /**
+     * @brief The root of the tree.
+     */
+    Node* root{nullptr};
+
+    /**
+     * @brief The amount of nodes in the map.
+     */
+    unsigned size_{0};
+  };
+} // namespace CS280
+
+  #ifndef AVLMAPPARENTLESS_CPP
+    #include "avl-map-parentless.cpp"
+  #endif
+
+#endif
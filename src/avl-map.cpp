@@ -8,8 +8,10 @@
  */
 
 #include <algorithm>
-#include <list>
+#include <iterator>
 #include <iostream>
+#include <new>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -22,13 +24,23 @@
 namespace CS280 {
 
   // static data members
-  template<typename K, typename V>
-  typename AVLmap<K, V>::iterator AVLmap<K, V>::end_it{
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  typename AVLmap<K, V, Compare, Pool>::iterator
+    AVLmap<K, V, Compare, Pool>::end_it{
     nullptr,
   };
 
-  template<typename K, typename V>
-  typename AVLmap<K, V>::const_iterator AVLmap<K, V>::const_end_it{
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  typename AVLmap<K, V, Compare, Pool>::const_iterator
+    AVLmap<K, V, Compare, Pool>::const_end_it{
     nullptr,
   };
 
@@ -36,421 +48,2831 @@ namespace CS280 {
 
   // Constructors & Destructor
 
-  template<typename K, typename V>
-  AVLmap<K, V>::AVLmap(): root(nullptr), size_(0) {}
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap<K, V, Compare, Pool>::AVLmap():
+      comp(), pool(), root(nullptr), size_(0) {}
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap<K, V, Compare, Pool>::AVLmap(const Compare& comp):
+      comp(comp), pool(), root(nullptr), size_(0) {}
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap<K, V, Compare, Pool>::AVLmap(
+    const node_pool& shared_pool,
+    const Compare& comp
+  ):
+      comp(comp), pool(shared_pool), root(nullptr), size_(0) {}
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename InputIt>
+  AVLmap<K, V, Compare, Pool>::AVLmap(InputIt first, InputIt last):
+      comp(), pool(), root(nullptr), size_(0) {
+    assign(first, last);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap<K, V, Compare, Pool>::AVLmap(const AVLmap& rhs):
+      comp(rhs.comp), pool(), root(nullptr), size_(0) {
+    pool.reserve(rhs.size_);
+    root = clone(rhs.root, nullptr);
+    size_ = rhs.size_;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::operator=(const AVLmap& rhs) -> AVLmap& {
+    if (this == &rhs) {
+      return *this;
+    }
+
+    clear();
+
+    comp = rhs.comp;
+    pool.reserve(rhs.size_);
+    root = clone(rhs.root, nullptr);
+    size_ = rhs.size_;
+
+    return *this;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap<K, V, Compare, Pool>::AVLmap(AVLmap&& rhs):
+      comp(std::move(rhs.comp)),
+      pool(std::move(rhs.pool)),
+      root(std::exchange(rhs.root, nullptr)),
+      size_(std::exchange(rhs.size_, 0)),
+      stats_(std::exchange(rhs.stats_, RebalanceStats{})) {}
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::operator=(AVLmap&& rhs) -> AVLmap& {
+    clear();
+
+    comp = std::move(rhs.comp);
+    pool = std::move(rhs.pool);
+    root = std::exchange(rhs.root, nullptr);
+    size_ = std::exchange(rhs.size_, 0);
+    stats_ = std::exchange(rhs.stats_, RebalanceStats{});
+
+    return *this;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap<K, V, Compare, Pool>::AVLmap::~AVLmap() {
+    clear();
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename InputIt>
+  auto AVLmap<K, V, Compare, Pool>::assign(InputIt first, InputIt last)
+    -> void {
+    clear();
+
+    typedef typename std::iterator_traits<InputIt>::iterator_category category;
+
+    // Already sorted random access input is linked in place
+    if constexpr (std::is_base_of<std::random_access_iterator_tag, category>::
+                    value) {
+      bool sorted = std::adjacent_find(
+                      first,
+                      last,
+                      [this](const auto& lhs, const auto& rhs) {
+                        return !comp(lhs.first, rhs.first);
+                      }
+                    )
+                    == last;
+
+      if (sorted) {
+        std::size_t count = static_cast<std::size_t>(last - first);
+        pool.reserve(count);
+        root = build(first, last, nullptr);
+        size_ = static_cast<unsigned int>(count);
+        return;
+      }
+    }
+
+    std::vector<std::pair<K, V>> items(first, last);
+
+    std::stable_sort(
+      items.begin(),
+      items.end(),
+      [this](const std::pair<K, V>& lhs, const std::pair<K, V>& rhs) {
+        return comp(lhs.first, rhs.first);
+      }
+    );
+
+    // Keeping the last pair of every run of repeated keys
+    typename std::vector<std::pair<K, V>>::iterator unique_end = items.begin();
+    for (typename std::vector<std::pair<K, V>>::iterator it = items.begin();
+         it != items.end();
+         ++it) {
+      typename std::vector<std::pair<K, V>>::iterator next = std::next(it);
+      if (next != items.end() && !comp(it->first, next->first)) {
+        continue;
+      }
+
+      if (unique_end != it) {
+        *unique_end = std::move(*it);
+      }
+      ++unique_end;
+    }
+    items.erase(unique_end, items.end());
+
+    pool.reserve(items.size());
+    root = build(
+      std::make_move_iterator(items.begin()),
+      std::make_move_iterator(items.end()),
+      nullptr
+    );
+    size_ = static_cast<unsigned int>(items.size());
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename InputIt>
+  auto AVLmap<K, V, Compare, Pool>::assign(
+    InputIt first,
+    InputIt last,
+    ForkJoinPool& workers
+  ) -> void {
+    typedef typename std::iterator_traits<InputIt>::iterator_category category;
+
+    typedef decltype(((*first).first)) KeyArg;
+    typedef decltype(((*first).second)) ValueArg;
+
+    // Nodes constructed in tasks cannot be cleaned up after an exception
+    constexpr bool nothrow = std::is_nothrow_constructible<K, KeyArg>::value
+                          && std::is_nothrow_constructible<V, ValueArg>::value;
+
+    if constexpr (std::is_base_of<std::random_access_iterator_tag, category>::
+                    value
+                  && nothrow) {
+      bool sorted = std::adjacent_find(
+                      first,
+                      last,
+                      [this](const auto& lhs, const auto& rhs) {
+                        return !comp(lhs.first, rhs.first);
+                      }
+                    )
+                    == last;
+
+      if (sorted && workers.concurrency() > 1) {
+        clear();
+
+        // The pool is not thread safe, so only the construction runs in tasks
+        std::size_t count = static_cast<std::size_t>(last - first);
+        std::vector<Node*> memory;
+        memory.reserve(count);
+        pool.reserve(count);
+
+        try {
+          for (std::size_t i = 0; i < count; ++i) {
+            memory.push_back(pool.allocate());
+          }
+        } catch (...) {
+          for (Node* node: memory) {
+            pool.deallocate(node);
+          }
+          throw;
+        }
+
+        size_ = static_cast<unsigned int>(count);
+        root = build_parallel(first, memory.data(), count, nullptr, &workers);
+        return;
+      }
+    }
+
+    assign(first, last);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename InputIt>
+  auto AVLmap<K, V, Compare, Pool>::insert_sorted_batch(
+    InputIt first,
+    InputIt last
+  ) -> std::size_t {
+    typedef typename std::iterator_traits<InputIt>::iterator_category category;
+
+    if constexpr (std::is_base_of<std::forward_iterator_tag, category>::value) {
+      std::size_t count = static_cast<std::size_t>(std::distance(first, last));
+
+      bool sorted = std::is_sorted(
+        first,
+        last,
+        [this](const auto& lhs, const auto& rhs) {
+          return comp(lhs.first, rhs.first);
+        }
+      );
+
+      // A batch that touches most of the tree is cheaper to merge in one pass
+      if (sorted && count != 0 && count * batch_relink_ratio >= size_) {
+        return merge_sorted_batch(first, last, count);
+      }
+
+      // A smaller one only rebalances along the splits and joins around its
+      // keys, instead of retracing after every key
+      if constexpr (std::is_base_of<
+                      std::random_access_iterator_tag,
+                      category>::value) {
+        if (sorted) {
+          std::size_t inserted = 0;
+          try {
+            insert_run(root, first, last, inserted);
+          } catch (...) {
+            size_ += static_cast<unsigned int>(inserted);
+            throw;
+          }
+
+          size_ += static_cast<unsigned int>(inserted);
+          return inserted;
+        }
+      }
+    }
+
+    std::size_t inserted = 0;
+    Node* finger = nullptr;
+
+    for (; first != last; ++first) {
+      InsertSearch search = search_insert_from((*first).first, finger);
+
+      if (search.match != nullptr) {
+        search.match->value = (*first).second;
+        finger = search.match;
+        continue;
+      }
+
+      // Dereferencing (instead of ->) lets move iterators move the pair out
+      Node* node = Node::CreateNode(pool, (*first).first, (*first).second);
+      link_node(node, search);
+      finger = node;
+      inserted++;
+    }
+
+    return inserted;
+  }
+
+  // Getters and setters
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::size() -> unsigned int {
+    return size_;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::key_comp() const -> Compare {
+    return comp;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::getdepth(Node*& node) const
+    -> unsigned int {
+    // TODO: optimize this to use the height vars so there is no need to refresh
+
+    std::optional<NodeSearch> search = search_node(node->Key());
+    if (search.has_value()) {
+      return search.value().depth;
+    }
+
+    return 0;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::operator[](const K& key) -> V& {
+    return try_emplace_impl(key).first->Value();
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::operator[](K&& key) -> V& {
+    return try_emplace_impl(std::move(key)).first->Value();
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename KeyArg, typename... Args>
+  auto AVLmap<K, V, Compare, Pool>::emplace(KeyArg&& key, Args&&... args)
+    -> std::pair<iterator, bool> {
+    Node* node = Node::CreateNode(
+      pool,
+      std::forward<KeyArg>(key),
+      std::forward<Args>(args)...
+    );
+
+    InsertSearch search = search_insert(node->key);
+    if (search.match != nullptr) {
+      Node::DestroyNode(pool, node);
+      return {iterator(search.match), false};
+    }
+
+    link_node(node, search);
+    return {iterator(node), true};
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename... Args>
+  auto AVLmap<K, V, Compare, Pool>::try_emplace(const K& key, Args&&... args)
+    -> std::pair<iterator, bool> {
+    return try_emplace_impl(key, std::forward<Args>(args)...);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename... Args>
+  auto AVLmap<K, V, Compare, Pool>::try_emplace(K&& key, Args&&... args)
+    -> std::pair<iterator, bool> {
+    return try_emplace_impl(std::move(key), std::forward<Args>(args)...);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename M>
+  auto AVLmap<K, V, Compare, Pool>::insert_or_assign(const K& key, M&& obj)
+    -> std::pair<iterator, bool> {
+    std::pair<iterator, bool> result =
+      try_emplace_impl(key, std::forward<M>(obj));
+    if (!result.second) {
+      result.first->Value() = std::forward<M>(obj);
+    }
+    return result;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename M>
+  auto AVLmap<K, V, Compare, Pool>::insert_or_assign(K&& key, M&& obj)
+    -> std::pair<iterator, bool> {
+    std::pair<iterator, bool> result =
+      try_emplace_impl(std::move(key), std::forward<M>(obj));
+    if (!result.second) {
+      result.first->Value() = std::forward<M>(obj);
+    }
+    return result;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename KeyLike>
+  auto AVLmap<K, V, Compare, Pool>::search_node(const KeyLike& key) const
+    -> std::optional<NodeSearch> {
+    Node* candidate = nullptr;
+    std::size_t candidate_depth = 0;
+    std::size_t depth = 0;
+
+    // The last node where the search went right is the greatest key not
+    // greater than the searched one, so it is the only one that can match
+    for (Node* current = root; current != nullptr; depth++) {
+      if (comp(key, current->key)) {
+        current = current->left;
+      } else {
+        candidate = current;
+        candidate_depth = depth;
+        current = current->right;
+      }
+    }
+
+    if (candidate == nullptr || comp(candidate->key, key)) {
+      return std::nullopt;
+    }
+
+    return NodeSearch{*candidate, candidate_depth};
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::search_insert(const K& key) const
+    -> InsertSearch {
+    return search_insert_from(key, nullptr);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::search_insert_from(
+    const K& key,
+    Node* finger
+  ) const -> InsertSearch {
+    InsertSearch search{nullptr, nullptr, false};
+    Node* candidate = nullptr;
+    Node* start = root;
+
+    // The first ancestor not less than the key bounds the subtree holding it
+    if (finger != nullptr && comp(finger->key, key)) {
+      start = finger;
+      while (start->parent != nullptr && comp(start->key, key)) {
+        start = start->parent;
+      }
+    }
+
+    for (Node* current = start; current != nullptr;) {
+      search.parent = current;
+      search.as_left = comp(key, current->key);
+
+      if (search.as_left) {
+        current = current->left;
+      } else {
+        candidate = current;
+        current = current->right;
+      }
+    }
+
+    if (candidate != nullptr && !comp(candidate->key, key)) {
+      search.match = candidate;
+    }
+
+    return search;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename RandomIt, typename Visitor>
+  auto AVLmap<K, V, Compare, Pool>::search_batch(
+    RandomIt first,
+    RandomIt last,
+    Visitor found
+  ) const -> void {
+    struct Probe {
+      std::size_t index;
+      Node* current;
+      Node* candidate;
+    };
+
+    std::size_t count = static_cast<std::size_t>(last - first);
+
+    // Interleaving only pays off when the searches miss the cache
+    if (size_ * sizeof(Node) < batch_cache_bytes) {
+      for (std::size_t i = 0; i < count; ++i) {
+        std::optional<NodeSearch> search = search_node(first[i]);
+        found(i, search.has_value() ? &search.value().node : nullptr);
+      }
+      return;
+    }
+
+    std::size_t next = 0;
+    std::size_t active = 0;
+    Probe probes[batch_group];
+
+    while (active < batch_group && next < count) {
+      probes[active++] = Probe{next++, root, nullptr};
+    }
+
+    // Every pass moves each probe down one level. A probe that reaches the
+    // bottom reports its key and is refilled with the next one, so the group
+    // stays full until the keys run out
+    while (active > 0) {
+      for (std::size_t i = 0; i < active;) {
+        Probe& probe = probes[i];
+        const auto& key = first[probe.index];
+
+        if (probe.current != nullptr) {
+          if (comp(key, probe.current->key)) {
+            probe.current = probe.current->left;
+          } else {
+            probe.candidate = probe.current;
+            probe.current = probe.current->right;
+          }
+
+          AVLMAP_PREFETCH(probe.current);
+          ++i;
+          continue;
+        }
+
+        Node* candidate = probe.candidate;
+        bool match = candidate != nullptr && !comp(candidate->key, key);
+        found(probe.index, match ? candidate : nullptr);
+
+        if (next < count) {
+          probe = Probe{next++, root, nullptr};
+          ++i;
+        } else {
+          probe = probes[--active];
+        }
+      }
+    }
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::link_node(
+    Node* node,
+    const InsertSearch& search
+  ) -> void {
+    size_++;
+
+    if (search.parent == nullptr) {
+      root = node;
+      return;
+    }
+
+    search.parent->add_child(*node, search.as_left);
+    adjust_sizes(search.parent, 1);
+    retrace(search.parent);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::unlink_node(Node* node) -> void {
+    Node* parent = node->parent;
+    Node* lowest_changed = parent;
+    Node* replacement = nullptr;
+
+    if (node->left == nullptr || node->right == nullptr) {
+      replacement = node->left != nullptr ? node->left : node->right;
+      if (replacement != nullptr) {
+        replacement->parent = parent;
+      }
+    } else {
+      // The predecessor is unlinked from its place and spliced into the place
+      // of the node, so no key or value is moved and its iterators stay valid
+      replacement = node->left->last();
+      lowest_changed = replacement;
+
+      if (replacement != node->left) {
+        lowest_changed = replacement->parent;
+        lowest_changed->right = replacement->left;
+        if (replacement->left != nullptr) {
+          replacement->left->parent = lowest_changed;
+        }
+
+        replacement->left = node->left;
+        replacement->left->parent = replacement;
+      }
+
+      replacement->right = node->right;
+      replacement->right->parent = replacement;
+      replacement->parent = parent;
+      replacement->height = node->height;
+      replacement->balance = node->balance;
+  #if AVLMAP_ORDER_STATISTICS
+      replacement->subtree_size = node->subtree_size;
+  #endif
+    }
+
+    if (node->is_left_child()) {
+      parent->left = replacement;
+    } else if (node->is_right_child()) {
+      parent->right = replacement;
+    } else {
+      root = replacement;
+    }
+
+    size_--;
+    if (lowest_changed != nullptr) {
+      adjust_sizes(lowest_changed, -1);
+      retrace(lowest_changed);
+    }
+
+    node->parent = nullptr;
+    node->left = nullptr;
+    node->right = nullptr;
+    node->height = 1;
+    node->balance = 0;
+  #if AVLMAP_ORDER_STATISTICS
+    node->subtree_size = 1;
+  #endif
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename KeyArg, typename... Args>
+  auto AVLmap<K, V, Compare, Pool>::try_emplace_impl(
+    KeyArg&& key,
+    Args&&... args
+  ) -> std::pair<iterator, bool> {
+    InsertSearch search = search_insert(key);
+    if (search.match != nullptr) {
+      return {iterator(search.match), false};
+    }
+
+    Node* node = Node::CreateNode(
+      pool,
+      std::forward<KeyArg>(key),
+      std::forward<Args>(args)...
+    );
+    link_node(node, search);
+    return {iterator(node), true};
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename KeyLike>
+  auto AVLmap<K, V, Compare, Pool>::lower_bound_node(const KeyLike& key) const
+    -> Node* {
+    Node* bound = nullptr;
+    Node* current = root;
+
+    // One comparison per level, the last node where the search went left is
+    // the bound
+    while (current != nullptr) {
+      if (comp(current->key, key)) {
+        current = current->right;
+      } else {
+        bound = current;
+        current = current->left;
+      }
+    }
+
+    return bound;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename KeyLike>
+  auto AVLmap<K, V, Compare, Pool>::upper_bound_node(const KeyLike& key) const
+    -> Node* {
+    Node* bound = nullptr;
+    Node* current = root;
+
+    while (current != nullptr) {
+      if (comp(key, current->key)) {
+        bound = current;
+        current = current->left;
+      } else {
+        current = current->right;
+      }
+    }
+
+    return bound;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::adjust_sizes(Node* node, int delta)
+    -> void {
+  #if AVLMAP_ORDER_STATISTICS
+    for (; node != nullptr; node = node->parent) {
+      node->subtree_size += delta;
+    }
+  #else
+    static_cast<void>(node);
+    static_cast<void>(delta);
+  #endif
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::retrace(Node* node) -> void {
+    std::size_t length = 0;
+    std::size_t rotations = 0;
+
+    while (node != nullptr) {
+      std::size_t previous_height = node->height;
+      node->update_height();
+      length++;
+
+      // Trying to fix balance in local subtree
+      Node* subtree = node;
+      switch (node->try_fix_balance(root)) {
+        case Node::Rotation::NONE: break;
+        case Node::Rotation::LEFT:
+        case Node::Rotation::RIGHT:
+          rotations++;
+          subtree = node->parent;
+          break;
+        case Node::Rotation::LEFT_RIGHT:
+        case Node::Rotation::RIGHT_LEFT:
+          rotations += 2;
+          subtree = node->parent;
+          break;
+      }
+
+      // The ancestors only need updating if the subtree height changed
+      if (subtree->height == previous_height) {
+        break;
+      }
+
+      node = subtree->parent;
+    }
+
+    stats_.operations++;
+    stats_.retrace_length += length;
+    stats_.rotations += rotations;
+    stats_.last_retrace_length = length;
+    stats_.last_rotations = rotations;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::clone(const Node* source, Node* parent)
+    -> Node* {
+    if (source == nullptr) {
+      return nullptr;
+    }
+
+    Node* memory = pool.allocate();
+    Node* node = nullptr;
+
+    try {
+      node = new (memory) Node(
+        source->key,
+        source->value,
+        parent,
+        source->height,
+        source->balance,
+        nullptr,
+        nullptr
+      );
+    } catch (...) {
+      pool.deallocate(memory);
+      throw;
+    }
+
+    // A failed child cleaned up after itself, what was cloned so far hangs
+    // from node
+    try {
+      node->left = clone(source->left, node);
+      node->right = clone(source->right, node);
+    } catch (...) {
+      destroy_subtree(node);
+      throw;
+    }
+    node->update_size();
+
+    return node;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename RandomIt>
+  auto AVLmap<K, V, Compare, Pool>::build(
+    RandomIt first,
+    RandomIt last,
+    Node* parent
+  ) -> Node* {
+    if (first == last) {
+      return nullptr;
+    }
+
+    RandomIt middle = first + (last - first) / 2;
+
+    Node* memory = pool.allocate();
+    Node* node = nullptr;
+
+    // Dereferencing (instead of ->) lets move iterators move the pair out
+    try {
+      node = new (memory) Node(
+        (*middle).first,
+        (*middle).second,
+        parent,
+        1,
+        0,
+        nullptr,
+        nullptr
+      );
+    } catch (...) {
+      pool.deallocate(memory);
+      throw;
+    }
+
+    // A failed child cleaned up after itself, what was built so far hangs
+    // from node
+    try {
+      node->left = build(first, middle, node);
+      node->right = build(std::next(middle), last, node);
+    } catch (...) {
+      destroy_subtree(node);
+      throw;
+    }
+    node->update_height();
+    node->update_size();
+
+    return node;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename RandomIt>
+  auto AVLmap<K, V, Compare, Pool>::build_parallel(
+    RandomIt first,
+    Node** memory,
+    std::size_t count,
+    Node* parent,
+    ForkJoinPool* workers
+  ) -> Node* {
+    if (count == 0) {
+      return nullptr;
+    }
+
+    std::size_t middle = count / 2;
+    RandomIt item = first + static_cast<std::ptrdiff_t>(middle);
+
+    Node* node = new (memory[middle])
+      Node(std::piecewise_construct, (*item).first, (*item).second);
+    node->parent = parent;
+
+    auto lower = [&]() {
+      node->left = build_parallel(first, memory, middle, node, workers);
+    };
+    auto upper = [&]() {
+      node->right = build_parallel(
+        std::next(item),
+        memory + middle + 1,
+        count - middle - 1,
+        node,
+        workers
+      );
+    };
+
+    if (workers != nullptr && count >= parallel_grain_size) {
+      workers->invoke(lower, upper);
+    } else {
+      lower();
+      upper();
+    }
+
+    node->update_height();
+    node->update_size();
+
+    return node;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::relink_balanced(
+    Node** first,
+    Node** last,
+    Node* parent
+  ) -> Node* {
+    if (first == last) {
+      return nullptr;
+    }
+
+    Node** middle = first + (last - first) / 2;
+    Node* node = *middle;
+
+    node->parent = parent;
+    node->left = relink_balanced(first, middle, node);
+    node->right = relink_balanced(middle + 1, last, node);
+    node->update_height();
+    node->update_size();
+
+    return node;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename ForwardIt>
+  auto AVLmap<K, V, Compare, Pool>::merge_sorted_batch(
+    ForwardIt first,
+    ForwardIt last,
+    std::size_t count
+  ) -> std::size_t {
+    std::vector<Node*> nodes;
+    nodes.reserve(size_ + count);
+    pool.reserve(count);
+
+    std::size_t inserted = 0;
+    Node* existing = root != nullptr ? root->first() : nullptr;
+
+    try {
+      for (; first != last; ++first) {
+        const K& key = (*first).first;
+
+        while (existing != nullptr && comp(existing->key, key)) {
+          nodes.push_back(existing);
+          existing = existing->increment();
+        }
+
+        if (existing != nullptr && !comp(key, existing->key)) {
+          existing->value = (*first).second;
+        } else if (!nodes.empty() && !comp(nodes.back()->key, key)) {
+          // Repeated key within the batch
+          nodes.back()->value = (*first).second;
+        } else {
+          nodes.push_back(
+            Node::CreateNode(pool, (*first).first, (*first).second)
+          );
+          inserted++;
+        }
+      }
+    } catch (...) {
+      // Nothing was relinked yet, the new nodes are the ones with no parent
+      for (Node* node : nodes) {
+        if (node != root && node->parent == nullptr) {
+          Node::DestroyNode(pool, node);
+        }
+      }
+      throw;
+    }
+
+    for (; existing != nullptr; existing = existing->increment()) {
+      nodes.push_back(existing);
+    }
+
+    size_ = static_cast<unsigned int>(nodes.size());
+    root = relink_balanced(nodes.data(), nodes.data() + nodes.size(), nullptr);
+
+    return inserted;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::clear() -> void {
+    if (root == nullptr) {
+      pool.release();
+      return;
+    }
+
+    // Nodes that need no destruction can go back with their slabs at once
+    // (unless another map shares the slabs)
+    if (node_pool::bulk_release && std::is_trivially_destructible<K>::value
+        && std::is_trivially_destructible<V>::value && pool.unique()) {
+      root = nullptr;
+      size_ = 0;
+      pool.release();
+      return;
+    }
+
+    destroy_subtree(root);
+    root = nullptr;
+    size_ = 0;
+    pool.release();
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::destroy_subtree(Node* node)
+    -> unsigned int {
+    unsigned int count = 0;
+
+    // Rotating every left child up turns the tree into a list leaning right,
+    // so the nodes can be destroyed in order without any extra memory
+    while (node != nullptr) {
+      if (node->left != nullptr) {
+        Node* promoted = node->left;
+        node->left = promoted->right;
+        promoted->right = node;
+        node = promoted;
+        continue;
+      }
+
+      Node* next = node->right;
+      Node::DestroyNode(pool, node);
+      node = next;
+      count++;
+    }
+
+    return count;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::subtree_count(Node* node)
+    -> unsigned int {
+    if (node == nullptr) {
+      return 0;
+    }
+
+  #if AVLMAP_ORDER_STATISTICS
+    return node->subtree_size;
+  #else
+    // The subtree is detached, so the walk stops at its last node
+    unsigned int count = 0;
+    for (Node* current = node->first(); current != nullptr;
+         current = current->increment()) {
+      count++;
+    }
+    return count;
+  #endif
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::height_of(const Node* node) -> int {
+    return node != nullptr ? node->height : 0;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::rebalance_up(Node* node) -> Node* {
+    while (true) {
+      node->update_height();
+      node->update_size();
+
+      // The subtree is detached, so there is no root of the map to update
+      Node* detached_root = nullptr;
+      Node* subtree = node;
+      if (node->try_fix_balance(detached_root) != Node::Rotation::NONE) {
+        subtree = node->parent;
+      }
+
+      if (subtree->parent == nullptr) {
+        return subtree;
+      }
+
+      node = subtree->parent;
+    }
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::join_nodes(
+    Node* lower,
+    Node* middle,
+    Node* upper
+  ) -> Node* {
+    int height_lower = height_of(lower);
+    int height_upper = height_of(upper);
+
+    // Going down the right spine of lower to the height of upper
+    if (height_lower > height_upper + 1) {
+      Node* parent = lower;
+      while (height_of(parent->right) > height_upper + 1) {
+        parent = parent->right;
+      }
+
+      middle->left = parent->right;
+      middle->right = upper;
+      parent->right = middle;
+      middle->parent = parent;
+    } else if (height_upper > height_lower + 1) {
+      Node* parent = upper;
+      while (height_of(parent->left) > height_lower + 1) {
+        parent = parent->left;
+      }
 
-  template<typename K, typename V>
-  AVLmap<K, V>::AVLmap(const AVLmap& rhs): size_(rhs.size_) {
-    if (rhs.root == nullptr) {
+      middle->left = lower;
+      middle->right = parent->left;
+      parent->left = middle;
+      middle->parent = parent;
+    } else {
+      middle->left = lower;
+      middle->right = upper;
+      middle->parent = nullptr;
+    }
+
+    if (middle->left != nullptr) {
+      middle->left->parent = middle;
+    }
+    if (middle->right != nullptr) {
+      middle->right->parent = middle;
+    }
+
+    return rebalance_up(middle);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::join_pair(Node* lower, Node* upper)
+    -> Node* {
+    if (lower == nullptr) {
+      return upper;
+    }
+    if (upper == nullptr) {
+      return lower;
+    }
+
+    // Taking the last node of lower out to be the middle node
+    Node* middle = lower->last();
+    Node* parent = middle->parent;
+    Node* child = middle->left;
+
+    if (child != nullptr) {
+      child->parent = parent;
+    }
+
+    if (parent == nullptr) {
+      lower = child;
+    } else {
+      parent->right = child;
+      lower = rebalance_up(parent);
+    }
+
+    return join_nodes(lower, middle, upper);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::split_node(
+    Node* node,
+    const K& key,
+    Node*& lower,
+    Node*& upper
+  ) const -> Node* {
+    if (node == nullptr) {
+      lower = nullptr;
+      upper = nullptr;
+      return nullptr;
+    }
+
+    Node* left = node->left;
+    Node* right = node->right;
+    if (left != nullptr) {
+      left->parent = nullptr;
+    }
+    if (right != nullptr) {
+      right->parent = nullptr;
+    }
+
+    // The split below returns detached subtrees, which are joined back with
+    // this node on the side it belongs to
+    Node* inner = nullptr;
+    Node* match = nullptr;
+
+    if (comp(key, node->key)) {
+      match = split_node(left, key, lower, inner);
+      upper = join_nodes(inner, node, right);
+    } else if (comp(node->key, key)) {
+      match = split_node(right, key, inner, upper);
+      lower = join_nodes(left, node, inner);
+    } else {
+      lower = left;
+      upper = right;
+      match = node;
+      match->parent = nullptr;
+      match->left = nullptr;
+      match->right = nullptr;
+      match->update_height();
+      match->update_size();
+    }
+
+    return match;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::split_before(
+    Node* node,
+    const K& key,
+    Node*& lower,
+    Node*& upper
+  ) const -> void {
+    Node* match = split_node(node, key, lower, upper);
+
+    if (match != nullptr) {
+      upper = join_nodes(nullptr, match, upper);
+    }
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename RandomIt>
+  auto AVLmap<K, V, Compare, Pool>::insert_run(
+    Node*& tree,
+    RandomIt first,
+    RandomIt last,
+    std::size_t& inserted
+  ) -> void {
+    if (first == last) {
+      return;
+    }
+
+    // The run of pairs with the key of the node (the last one holds the
+    // value). Under an empty place the middle key of the batch makes the node
+    Node* node = tree;
+    const K& key = node != nullptr ? node->key
+                                   : (*(first + (last - first) / 2)).first;
+    RandomIt run_first = std::partition_point(
+      first,
+      last,
+      [this, &key](const auto& item) { return comp(item.first, key); }
+    );
+    RandomIt run_last = std::partition_point(
+      run_first,
+      last,
+      [this, &key](const auto& item) { return !comp(key, item.first); }
+    );
+
+    // Nothing is detached yet, so a throw here leaves the subtree as it was
+    if (node == nullptr) {
+      RandomIt item = std::prev(run_last);
+      node = Node::CreateNode(pool, (*item).first, (*item).second);
+      inserted++;
+    } else if (run_first != run_last) {
+      node->value = (*std::prev(run_last)).second;
+    }
+
+    Node* left = node->left;
+    Node* right = node->right;
+    if (left != nullptr) {
+      left->parent = nullptr;
+    }
+    if (right != nullptr) {
+      right->parent = nullptr;
+    }
+
+    try {
+      insert_run(left, first, run_first, inserted);
+      insert_run(right, run_last, last, inserted);
+    } catch (...) {
+      tree = join_nodes(left, node, right);
+      throw;
+    }
+
+    tree = join_nodes(left, node, right);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::discard(Discarded& list, Node* subtree)
+    -> void {
+    subtree->parent = nullptr;
+
+    if (list.last == nullptr) {
+      list.first = subtree;
+    } else {
+      list.last->parent = subtree;
+    }
+    list.last = subtree;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::discard(
+    Discarded& list,
+    const Discarded& more
+  ) -> void {
+    if (more.first == nullptr) {
+      return;
+    }
+
+    if (list.last == nullptr) {
+      list.first = more.first;
+    } else {
+      list.last->parent = more.first;
+    }
+    list.last = more.last;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::destroy_discarded(const Discarded& list)
+    -> unsigned int {
+    unsigned int count = 0;
+
+    for (Node* subtree = list.first; subtree != nullptr;) {
+      Node* next = subtree->parent;
+      count += destroy_subtree(subtree);
+      subtree = next;
+    }
+
+    return count;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename Lower, typename Upper>
+  auto AVLmap<K, V, Compare, Pool>::both_halves(
+    ForkJoinPool* workers,
+    Discarded& discarded,
+    Lower lower,
+    Upper upper
+  ) -> void {
+    if (workers == nullptr) {
+      lower(discarded);
+      upper(discarded);
+      return;
+    }
+
+    Discarded upper_discarded{};
+    workers->invoke(
+      [&lower, &discarded]() {
+        lower(discarded);
+      },
+      [&upper, &upper_discarded]() {
+        upper(upper_discarded);
+      }
+    );
+    discard(discarded, upper_discarded);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::fork_pool(
+    ForkJoinPool* workers,
+    const Node* mine,
+    const Node* theirs
+  ) -> ForkJoinPool* {
+    if (height_of(mine) < parallel_grain_height
+        || height_of(theirs) < parallel_grain_height) {
+      return nullptr;
+    }
+
+    return workers;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::union_nodes(
+    Node* mine,
+    Node* theirs,
+    Discarded& discarded,
+    ForkJoinPool* workers
+  ) const -> Node* {
+    if (mine == nullptr) {
+      return theirs;
+    }
+    if (theirs == nullptr) {
+      return mine;
+    }
+
+    ForkJoinPool* fork = fork_pool(workers, mine, theirs);
+
+    Node* their_left = theirs->left;
+    Node* their_right = theirs->right;
+    if (their_left != nullptr) {
+      their_left->parent = nullptr;
+    }
+    if (their_right != nullptr) {
+      their_right->parent = nullptr;
+    }
+
+    Node* lower = nullptr;
+    Node* upper = nullptr;
+    Node* match = split_node(mine, theirs->key, lower, upper);
+
+    both_halves(
+      fork,
+      discarded,
+      [&](Discarded& list) {
+        lower = union_nodes(lower, their_left, list, workers);
+      },
+      [&](Discarded& list) {
+        upper = union_nodes(upper, their_right, list, workers);
+      }
+    );
+
+    if (match != nullptr) {
+      theirs->left = nullptr;
+      theirs->right = nullptr;
+      discard(discarded, theirs);
+      return join_nodes(lower, match, upper);
+    }
+
+    return join_nodes(lower, theirs, upper);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::intersect_nodes(
+    Node* mine,
+    const Node* theirs,
+    Discarded& discarded,
+    ForkJoinPool* workers
+  ) const -> Node* {
+    if (mine == nullptr) {
+      return nullptr;
+    }
+    if (theirs == nullptr) {
+      discard(discarded, mine);
+      return nullptr;
+    }
+
+    ForkJoinPool* fork = fork_pool(workers, mine, theirs);
+
+    Node* lower = nullptr;
+    Node* upper = nullptr;
+    Node* match = split_node(mine, theirs->key, lower, upper);
+
+    both_halves(
+      fork,
+      discarded,
+      [&](Discarded& list) {
+        lower = intersect_nodes(lower, theirs->left, list, workers);
+      },
+      [&](Discarded& list) {
+        upper = intersect_nodes(upper, theirs->right, list, workers);
+      }
+    );
+
+    if (match != nullptr) {
+      return join_nodes(lower, match, upper);
+    }
+
+    return join_pair(lower, upper);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::difference_nodes(
+    Node* mine,
+    const Node* theirs,
+    Discarded& discarded,
+    ForkJoinPool* workers
+  ) const -> Node* {
+    if (mine == nullptr || theirs == nullptr) {
+      return mine;
+    }
+
+    ForkJoinPool* fork = fork_pool(workers, mine, theirs);
+
+    Node* lower = nullptr;
+    Node* upper = nullptr;
+    Node* match = split_node(mine, theirs->key, lower, upper);
+
+    both_halves(
+      fork,
+      discarded,
+      [&](Discarded& list) {
+        lower = difference_nodes(lower, theirs->left, list, workers);
+      },
+      [&](Discarded& list) {
+        upper = difference_nodes(upper, theirs->right, list, workers);
+      }
+    );
+
+    if (match != nullptr) {
+      discard(discarded, match);
+    }
+
+    return join_pair(lower, upper);
+  }
+
+  // Iterators
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::begin() -> iterator {
+    if (root) {
+      return iterator(root->first());
+    } else {
+      return end_it;
+    }
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::end() -> iterator {
+    return end_it;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::find(const K& key) -> iterator {
+    std::optional<NodeSearch> search = search_node(key);
+    if (search.has_value()) {
+      return &search.value().node;
+    }
+
+    return end_it;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename KeyLike, typename C, typename>
+  auto AVLmap<K, V, Compare, Pool>::find(const KeyLike& key) -> iterator {
+    std::optional<NodeSearch> search = search_node(key);
+    if (search.has_value()) {
+      return &search.value().node;
+    }
+
+    return end_it;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename RandomIt, typename OutIt>
+  auto AVLmap<K, V, Compare, Pool>::find_batch(
+    RandomIt first,
+    RandomIt last,
+    OutIt out
+  ) -> void {
+    search_batch(first, last, [&out](std::size_t index, Node* node) {
+      out[index] = node != nullptr ? iterator(node) : end_it;
+    });
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::lower_bound(const K& key) -> iterator {
+    return iterator(lower_bound_node(key));
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename KeyLike, typename C, typename>
+  auto AVLmap<K, V, Compare, Pool>::lower_bound(const KeyLike& key)
+    -> iterator {
+    return iterator(lower_bound_node(key));
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::upper_bound(const K& key) -> iterator {
+    return iterator(upper_bound_node(key));
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename KeyLike, typename C, typename>
+  auto AVLmap<K, V, Compare, Pool>::upper_bound(const KeyLike& key)
+    -> iterator {
+    return iterator(upper_bound_node(key));
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::equal_range(const K& key)
+    -> std::pair<iterator, iterator> {
+    return {lower_bound(key), upper_bound(key)};
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::erase(AVLmap_iterator it) -> void {
+    if (it == end_it) {
+      return;
+    }
+
+    Node* node = it.p_node;
+    unlink_node(node);
+    Node::DestroyNode(pool, node);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::erase(iterator first, iterator last)
+    -> iterator {
+    if (first == last) {
+      return last;
+    }
+
+    Node* lower = nullptr;
+    Node* upper = nullptr;
+    split_before(root, first.p_node->key, lower, upper);
+
+    Node* erased = upper;
+    upper = nullptr;
+    if (last != end_it) {
+      split_before(erased, last.p_node->key, erased, upper);
+    }
+
+    root = join_pair(lower, upper);
+    size_ -= destroy_subtree(erased);
+
+    return last;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::erase_range(const K& lo, const K& hi)
+    -> std::size_t {
+    if (!comp(lo, hi)) {
+      return 0;
+    }
+
+    Node* lower = nullptr;
+    Node* erased = nullptr;
+    Node* upper = nullptr;
+    split_before(root, lo, lower, erased);
+    split_before(erased, hi, erased, upper);
+
+    root = join_pair(lower, upper);
+    unsigned int count = destroy_subtree(erased);
+    size_ -= count;
+
+    return count;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::freeze() const
+    -> AVLmap_frozen<K, V, Compare> {
+    return snapshot<AVLmap_frozen<K, V, Compare>>();
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::export_eytzinger() const
+    -> AVLmap_eytzinger<K, V, Compare> {
+    return snapshot<AVLmap_eytzinger<K, V, Compare>>();
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename Snapshot>
+  auto AVLmap<K, V, Compare, Pool>::snapshot() const -> Snapshot {
+    std::vector<K> keys;
+    std::vector<V> values;
+    keys.reserve(size_);
+    values.reserve(size_);
+
+    for (const_iterator it = begin(); it != end(); ++it) {
+      keys.push_back(it->key);
+      values.push_back(it->value);
+    }
+
+    return Snapshot(keys, std::move(values), comp);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::extract(iterator it) -> node_type {
+    if (it == end_it) {
+      return node_type();
+    }
+
+    Node* node = it.p_node;
+    unlink_node(node);
+    return node_type(node, pool);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::extract(const K& key) -> node_type {
+    return extract(find(key));
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::insert(node_type&& node)
+    -> insert_return_type {
+    if (node.empty()) {
+      return {end_it, false, node_type()};
+    }
+
+    InsertSearch search = search_insert(node.node->key);
+    if (search.match != nullptr) {
+      return {iterator(search.match), false, std::move(node)};
+    }
+
+    Node* to_link = nullptr;
+    if (*node.pool == pool) {
+      pool.adopt(*node.pool, 1);
+      to_link = std::exchange(node.node, nullptr);
+      node.pool.reset();
+    } else {
+      to_link = Node::CreateNode(
+        pool,
+        std::move(node.node->key),
+        std::move(node.node->value)
+      );
+      node.reset();
+    }
+
+    link_node(to_link, search);
+    return {iterator(to_link), true, node_type()};
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::merge(AVLmap& source) -> void {
+    if (&source == this) {
+      return;
+    }
+
+    bool shared_pool = source.pool == pool;
+
+    // Iterators survive the unlinking of other nodes, so the next node can be
+    // taken before the current one leaves source
+    for (iterator it = source.begin(); it != end_it;) {
+      Node* node = it.p_node;
+      ++it;
+
+      InsertSearch search = search_insert(node->key);
+      if (search.match != nullptr) {
+        continue;
+      }
+
+      source.unlink_node(node);
+
+      if (shared_pool) {
+        pool.adopt(source.pool, 1);
+        link_node(node, search);
+      } else {
+        link_node(
+          Node::CreateNode(pool, std::move(node->key), std::move(node->value)),
+          search
+        );
+        Node::DestroyNode(source.pool, node);
+      }
+    }
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::merge(AVLmap&& source) -> void {
+    merge(source);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::split(const K& key) -> AVLmap {
+    AVLmap upper(pool, comp);
+
+    Node* lower_root = nullptr;
+    Node* upper_root = nullptr;
+    split_before(root, key, lower_root, upper_root);
+
+    root = lower_root;
+    upper.root = upper_root;
+    upper.size_ = subtree_count(upper_root);
+    size_ -= upper.size_;
+
+    return upper;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::join(AVLmap&& upper) -> void {
+    if (&upper == this || upper.root == nullptr) {
+      return;
+    }
+
+    if (root != nullptr && !comp(root->last()->key, upper.root->first()->key)) {
+      union_with(std::move(upper));
+      return;
+    }
+
+    if (upper.pool != pool) {
+      AVLmap copy(pool, comp);
+      copy.root = copy.clone(upper.root, nullptr);
+      copy.size_ = upper.size_;
+      upper.clear();
+      join(std::move(copy));
+      return;
+    }
+
+    pool.adopt(upper.pool, upper.size_);
+    root = join_pair(root, upper.root);
+    size_ += upper.size_;
+    upper.root = nullptr;
+    upper.size_ = 0;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::union_with(const AVLmap& other) -> void {
+    union_impl(other, nullptr);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::union_with(
+    const AVLmap& other,
+    ForkJoinPool& workers
+  ) -> void {
+    union_impl(other, &workers);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::union_with(AVLmap&& other) -> void {
+    union_impl(std::move(other), nullptr);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::union_with(
+    AVLmap&& other,
+    ForkJoinPool& workers
+  ) -> void {
+    union_impl(std::move(other), &workers);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::intersect_with(const AVLmap& other)
+    -> void {
+    intersect_impl(other, nullptr);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::intersect_with(
+    const AVLmap& other,
+    ForkJoinPool& workers
+  ) -> void {
+    intersect_impl(other, &workers);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::difference_with(const AVLmap& other)
+    -> void {
+    difference_impl(other, nullptr);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::difference_with(
+    const AVLmap& other,
+    ForkJoinPool& workers
+  ) -> void {
+    difference_impl(other, &workers);
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::union_impl(
+    const AVLmap& other,
+    ForkJoinPool* workers
+  ) -> void {
+    if (&other == this || other.root == nullptr) {
+      return;
+    }
+
+    // A few keys are cheaper to insert from the previous insertion place
+    if (other.size_ * set_split_ratio < size_) {
+      Node* finger = nullptr;
+      for (const_iterator it = other.begin(); it != other.end(); ++it) {
+        InsertSearch search = search_insert_from(it->key, finger);
+        if (search.match == nullptr) {
+          search.match = Node::CreateNode(pool, it->key, it->value);
+          link_node(search.match, search);
+        }
+        finger = search.match;
+      }
       return;
     }
 
-    AVLmap& self = *this;
+    // Copying other first leaves the union itself unable to throw
+    AVLmap copy(pool, comp);
+    copy.root = copy.clone(other.root, nullptr);
+    copy.size_ = other.size_;
+    union_impl(std::move(copy), workers);
+  }
 
-    std::list<Node*> insert_list{rhs.root};
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::union_impl(
+    AVLmap&& other,
+    ForkJoinPool* workers
+  ) -> void {
+    if (&other == this) {
+      return;
+    }
 
-    while (!insert_list.empty()) {
-      Node* current = insert_list.front();
+    if (other.pool != pool) {
+      union_impl(static_cast<const AVLmap&>(other), workers);
+      other.clear();
+      return;
+    }
 
-      self[current->Key()] = current->Value();
+    // Every node of other ends up in this map or destroyed by its pool
+    pool.adopt(other.pool, other.size_);
 
-      if (current->left != nullptr) {
-        insert_list.push_back(current->left);
+    if (other.size_ * set_split_ratio < size_) {
+      std::vector<Node*> nodes;
+      nodes.reserve(other.size_);
+      for (iterator it = other.begin(); it != other.end(); ++it) {
+        nodes.push_back(it.p_node);
       }
+      other.root = nullptr;
+      other.size_ = 0;
+
+      Node* finger = nullptr;
+      for (Node* node: nodes) {
+        InsertSearch search = search_insert_from(node->key, finger);
+        if (search.match != nullptr) {
+          Node::DestroyNode(pool, node);
+          finger = search.match;
+          continue;
+        }
 
-      if (current->right != nullptr) {
-        insert_list.push_back(current->right);
+        node->parent = nullptr;
+        node->left = nullptr;
+        node->right = nullptr;
+        node->update_height();
+        node->update_size();
+        link_node(node, search);
+        finger = node;
       }
-
-      insert_list.pop_front();
+      return;
     }
+
+    Discarded discarded{};
+    root = union_nodes(root, other.root, discarded, workers);
+    size_ += other.size_;
+    size_ -= destroy_discarded(discarded);
+    other.root = nullptr;
+    other.size_ = 0;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::operator=(const AVLmap& rhs) -> AVLmap& {
-    if (this == &rhs) {
-      return *this;
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::intersect_impl(
+    const AVLmap& other,
+    ForkJoinPool* workers
+  ) -> void {
+    if (&other == this) {
+      return;
     }
 
-    clear();
+    Discarded discarded{};
+    root = intersect_nodes(root, other.root, discarded, workers);
+    size_ -= destroy_discarded(discarded);
+  }
 
-    if (rhs.root == nullptr) {
-      return *this;
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::difference_impl(
+    const AVLmap& other,
+    ForkJoinPool* workers
+  ) -> void {
+    if (&other == this) {
+      clear();
+      return;
     }
 
-    AVLmap& self = *this;
-
-    std::list<Node*> insert_list{rhs.root};
-
-    while (!insert_list.empty()) {
-      Node* current = insert_list.front();
-
-      self[current->Key()] = current->Value();
-
-      if (current->left != nullptr) {
-        insert_list.push_back(current->left);
+    if (other.size_ * set_split_ratio < size_) {
+      for (const_iterator it = other.begin(); it != other.end(); ++it) {
+        std::optional<NodeSearch> search = search_node(it->key);
+        if (search.has_value()) {
+          Node* node = &search.value().node;
+          unlink_node(node);
+          Node::DestroyNode(pool, node);
+        }
       }
+      return;
+    }
 
-      if (current->right != nullptr) {
-        insert_list.push_back(current->right);
-      }
+    Discarded discarded{};
+    root = difference_nodes(root, other.root, discarded, workers);
+    size_ -= destroy_discarded(discarded);
+  }
 
-      insert_list.pop_front();
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::begin() const -> const_iterator {
+    if (root) {
+      return const_iterator(root->first());
+    } else {
+      return end_it;
     }
+  }
 
-    return *this;
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::end() const -> const_iterator {
+    return end_it;
   }
 
-  template<typename K, typename V>
-  AVLmap<K, V>::AVLmap(AVLmap&& rhs):
-      root(std::exchange(rhs.root, nullptr)),
-      size_(std::exchange(rhs.size_, 0)) {}
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::find(const K& key) const -> const_iterator {
+    std::optional<NodeSearch> search = search_node(key);
+    if (search.has_value()) {
+      return &search.value().node;
+    }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::operator=(AVLmap&& rhs) -> AVLmap& {
-    clear();
+    return end_it;
+  }
 
-    root = std::exchange(rhs.root, nullptr);
-    size_ = std::exchange(rhs.size_, 0);
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename KeyLike, typename C, typename>
+  auto AVLmap<K, V, Compare, Pool>::find(const KeyLike& key) const
+    -> const_iterator {
+    std::optional<NodeSearch> search = search_node(key);
+    if (search.has_value()) {
+      return &search.value().node;
+    }
 
-    return *this;
+    return end_it;
   }
 
-  template<typename K, typename V>
-  AVLmap<K, V>::AVLmap::~AVLmap() {
-    clear();
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename RandomIt, typename OutIt>
+  auto AVLmap<K, V, Compare, Pool>::find_batch(
+    RandomIt first,
+    RandomIt last,
+    OutIt out
+  ) const -> void {
+    search_batch(first, last, [&out](std::size_t index, Node* node) {
+      out[index] = node != nullptr ? const_iterator(node) : const_end_it;
+    });
   }
 
-  // Getters and setters
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::lower_bound(const K& key) const
+    -> const_iterator {
+    return const_iterator(lower_bound_node(key));
+  }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::size() -> unsigned int {
-    return size_;
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename KeyLike, typename C, typename>
+  auto AVLmap<K, V, Compare, Pool>::lower_bound(const KeyLike& key) const
+    -> const_iterator {
+    return const_iterator(lower_bound_node(key));
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::getdepth(Node*& node) const -> unsigned int {
-    // TODO: optimize this to use the height vars so there is no need to refresh
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::upper_bound(const K& key) const
+    -> const_iterator {
+    return const_iterator(upper_bound_node(key));
+  }
 
-    std::optional<NodeSearch> search = search_node(node->Key());
-    if (search.has_value()) {
-      return search.value().depth;
-    }
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename KeyLike, typename C, typename>
+  auto AVLmap<K, V, Compare, Pool>::upper_bound(const KeyLike& key) const
+    -> const_iterator {
+    return const_iterator(upper_bound_node(key));
+  }
 
-    return 0;
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::equal_range(const K& key) const
+    -> std::pair<const_iterator, const_iterator> {
+    return {lower_bound(key), upper_bound(key)};
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::operator[](const K& key) -> V& {
-    if (root == nullptr) {
-      root = Node::CreateNode(key);
-      size_++;
-      return root->Value();
-    }
+  #if AVLMAP_ORDER_STATISTICS
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::select(unsigned int k) -> iterator {
+    const AVLmap& self = *this;
+    return iterator(self.select(k).p_node);
+  }
 
-    Node* current{root};
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::select(unsigned int k) const
+    -> const_iterator {
+    Node* current = root;
 
     while (current != nullptr) {
-      if (key == current->Key()) {
-        return current->Value();
-      }
-
-      if (key < current->Key()) {
-        if (current->left == nullptr) {
-          break;
-        }
+      unsigned int left_size =
+        current->left != nullptr ? current->left->subtree_size : 0;
 
-        current = current->left;
-        continue;
+      if (k == left_size) {
+        return const_iterator(current);
       }
 
-      if (key > current->Key()) {
-        if (current->right == nullptr) {
-          break;
-        }
-
+      if (k < left_size) {
+        current = current->left;
+      } else {
+        k -= left_size + 1;
         current = current->right;
-        continue;
       }
     }
 
-    Node* to_add = Node::CreateNode(key);
-    current->add_child(*to_add);
-
-    to_add->insert_balance(nullptr, root);
-
-    size_++;
-
-    return to_add->Value();
+    return const_end_it;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::search_node(K key) const -> std::optional<NodeSearch> {
-    if (root == nullptr) {
-      return std::nullopt;
-    }
-
-    std::size_t depth = 0;
-    Node* current{root};
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::rank(const K& key) const -> unsigned int {
+    unsigned int position = 0;
+    Node* current = root;
 
     while (current != nullptr) {
-      if (key == current->Key()) {
-        return NodeSearch{*current, depth};
-      }
-
-      depth++;
-
-      if (key < current->Key()) {
-        if (current->left == nullptr) {
-          break;
-        }
-
-        current = current->left;
-        continue;
-      }
-
-      if (key > current->Key()) {
-        if (current->right == nullptr) {
-          break;
+      if (comp(current->key, key)) {
+        position++;
+        if (current->left != nullptr) {
+          position += current->left->subtree_size;
         }
-
         current = current->right;
-        continue;
+      } else {
+        current = current->left;
       }
     }
 
-    return std::nullopt;
+    return position;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::clear() -> void {
-    if (root == nullptr) {
-      return;
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::count_range(const K& lo, const K& hi) const
+    -> unsigned int {
+    if (!comp(lo, hi)) {
+      return 0;
     }
 
-    std::list<Node*> deletion_queue{root};
-    root = nullptr;
-
-    while (!deletion_queue.empty()) {
-      Node* to_delete = deletion_queue.front();
+    return rank(hi) - rank(lo);
+  }
+  #endif
 
-      if (to_delete->left != nullptr) {
-        deletion_queue.push_back(to_delete->left);
-      }
+  // Check Methods
 
-      if (to_delete->right != nullptr) {
-        deletion_queue.push_back(to_delete->right);
-      }
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::sanityCheck() const -> bool {
+    return static_cast<bool>(validate());
+  }
 
-      deletion_queue.pop_front();
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::validate() const -> SanityReport {
+    typedef typename SanityReport::Issue Issue;
 
-      size_--;
-      delete to_delete;
-    }
-  }
+    SanityReport report{};
 
-  // Iterators
+    auto fail = [&report](Issue issue, const Node* node) -> SanityReport {
+      report.issue = issue;
+      report.node = node;
+      return report;
+    };
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::begin() -> iterator {
-    if (root) {
-      return iterator(root->first());
-    } else {
-      return end_it;
+    if (root == nullptr) {
+      return size_ == 0 ? report : fail(Issue::SIZE, nullptr);
     }
-  }
-
-  template<typename K, typename V>
-  auto AVLmap<K, V>::end() -> iterator {
-    return end_it;
-  }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::find(const K& key) -> iterator {
-    std::optional<NodeSearch> search = search_node(key);
-    if (search.has_value()) {
-      return &search.value().node;
+    if (root->parent != nullptr) {
+      return fail(Issue::PARENT_LINK, root);
     }
 
-    return end_it;
-  }
+    // Walking the tree with the parent links, from tells where we came from
+    const Node* previous = nullptr;
+    const Node* from = nullptr;
+    const Node* current = root;
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::erase(AVLmap_iterator it) -> void {
-    if (it == end_it) {
-      return;
-    }
+    while (current != nullptr) {
+      // First visit (coming down from the parent)
+      if (from == current->parent) {
+        report.nodes_visited++;
 
-    Node* node = it.p_node;
-    Node* parent = node->parent;
+        if (report.nodes_visited > size_) {
+          return fail(Issue::SIZE, current);
+        }
 
-    if (!node->has_children()) {
-      if (node->is_left_child()) {
-        parent->left = nullptr;
-      }
+        if (current->left != nullptr && current->left == current->right) {
+          return fail(Issue::CYCLE, current);
+        }
 
-      if (node->is_right_child()) {
-        parent->right = nullptr;
-      }
+        if (current->left != nullptr) {
+          if (current->left->parent != current) {
+            return fail(Issue::PARENT_LINK, current->left);
+          }
 
-      if (root == node) {
-        root = nullptr;
-      }
+          from = current;
+          current = current->left;
+          continue;
+        }
 
-      size_--;
-      if (node->parent != nullptr) {
-        node->parent->insert_balance(nullptr, root);
+        from = nullptr;
       }
 
-      delete node;
-      return;
-    }
+      // Left subtree done, the keys must be strictly increasing in order
+      if (from == current->left) {
+        if (previous != nullptr && !comp(previous->key, current->key)) {
+          return fail(Issue::ORDER, current);
+        }
+        previous = current;
 
-    std::optional<Node*> only_child_opt = node->get_only_child();
-    if (only_child_opt.has_value()) {
-      Node* only_child = only_child_opt.value();
+        if (current->right != nullptr) {
+          if (current->right->parent != current) {
+            return fail(Issue::PARENT_LINK, current->right);
+          }
 
-      if (node->is_left_child()) {
-        parent->left = only_child;
+          from = current;
+          current = current->right;
+          continue;
+        }
       }
 
-      if (node->is_right_child()) {
-        parent->right = only_child;
+      // Both subtrees done, their nodes were already validated
+      std::size_t height_l = current->left ? current->left->height : 0;
+      std::size_t height_r = current->right ? current->right->height : 0;
+
+      if (current->height != std::max(height_l, height_r) + 1) {
+        return fail(Issue::HEIGHT, current);
       }
 
-      if (root == node) {
-        root = only_child;
+      int balance = static_cast<int>(height_r) - static_cast<int>(height_l);
+      if (current->balance != balance || balance < -1 || balance > 1) {
+        return fail(Issue::BALANCE, current);
       }
 
-      only_child->parent = parent;
+  #if AVLMAP_ORDER_STATISTICS
+      unsigned int size = 1;
+      size += current->left ? current->left->subtree_size : 0;
+      size += current->right ? current->right->subtree_size : 0;
 
-      size_--;
-      if (node->parent != nullptr) {
-        node->parent->insert_balance(nullptr, root);
+      if (current->subtree_size != size) {
+        return fail(Issue::SUBTREE_SIZE, current);
       }
+  #endif
 
-      delete node;
-      return;
+      from = current;
+      current = current->parent;
     }
 
-    Node* predecessor = node->left->last();
-    node->key = std::move(predecessor->key);
-    node->value = std::move(predecessor->value);
-
-    erase(iterator(predecessor));
-  }
-
-  template<typename K, typename V>
-  auto AVLmap<K, V>::begin() const -> const_iterator {
-    if (root) {
-      return const_iterator(root->first());
-    } else {
-      return end_it;
+    if (report.nodes_visited != size_) {
+      return fail(Issue::SIZE, nullptr);
     }
+
+    report.height = root->height;
+    return report;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::end() const -> const_iterator {
-    return end_it;
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap<K, V, Compare, Pool>::SanityReport::operator bool() const {
+    return issue == Issue::NONE;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::find(const K& key) const -> const_iterator {
-    std::optional<NodeSearch> search = search_node(key);
-    if (search.has_value()) {
-      return &search.value().node;
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::SanityReport::what() const -> const char* {
+    switch (issue) {
+      case Issue::NONE: return "valid";
+      case Issue::ORDER: return "keys out of order";
+      case Issue::PARENT_LINK: return "parent link does not match child link";
+      case Issue::CYCLE: return "node reachable twice";
+      case Issue::HEIGHT: return "stored height is wrong";
+      case Issue::BALANCE: return "balance is wrong or out of [-1, 1]";
+      case Issue::SUBTREE_SIZE: return "stored subtree size is wrong";
+      case Issue::SIZE: return "node count does not match size()";
     }
 
-    return end_it;
+    return "unknown";
   }
 
-  // Check Methods
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::pool_stats() const -> const PoolStats& {
+    return pool.stats();
+  }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::sanityCheck() -> bool {
-    if (root == nullptr) {
-      return true;
-    }
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::get_pool() const -> const node_pool& {
+    return pool;
+  }
 
-    std::list<Node*> insert_list{root};
-    std::vector<K> seen_keys{};
-    std::size_t measured_size{0};
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::rebalance_stats() const
+    -> const RebalanceStats& {
+    return stats_;
+  }
 
-    while (!insert_list.empty()) {
-      Node* current = insert_list.front();
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::reset_rebalance_stats() -> void {
+    stats_ = RebalanceStats{};
+  }
 
-      if (std::find(seen_keys.begin(), seen_keys.end(), current->key)
-          != seen_keys.cend()) {
-        std::cout << "Found repeat key: " << current->key << std::endl;
-        return false;
-      }
+  /// node_type Methods
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap<K, V, Compare, Pool>::node_type::node_type():
+      node(nullptr), pool() {}
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap<K, V, Compare, Pool>::node_type::node_type(
+    Node* n,
+    const node_pool& p
+  ):
+      node(n), pool(p) {}
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap<K, V, Compare, Pool>::node_type::node_type(node_type&& rhs):
+      node(std::exchange(rhs.node, nullptr)), pool(std::move(rhs.pool)) {
+    rhs.pool.reset();
+  }
 
-      seen_keys.push_back(current->key);
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::node_type::operator=(node_type&& rhs)
+    -> node_type& {
+    if (this == &rhs) {
+      return *this;
+    }
 
-      if (current->left != nullptr) {
-        if (current->Value() <= current->left->Value()) {
-          std::cout << "Ordering issue" << std::endl;
-          return false;
-        }
+    reset();
+    node = std::exchange(rhs.node, nullptr);
+    pool = std::move(rhs.pool);
+    rhs.pool.reset();
 
-        insert_list.push_back(current->left);
-      }
+    return *this;
+  }
 
-      if (current->right != nullptr) {
-        if (current->Value() >= current->right->Value()) {
-          std::cout << "Ordering issue" << std::endl;
-          return false;
-        }
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap<K, V, Compare, Pool>::node_type::~node_type() {
+    reset();
+  }
 
-        insert_list.push_back(current->right);
-      }
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::node_type::empty() const -> bool {
+    return node == nullptr;
+  }
 
-      insert_list.pop_front();
-      measured_size++;
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap<K, V, Compare, Pool>::node_type::operator bool() const {
+    return node != nullptr;
+  }
 
-      if (std::find(insert_list.begin(), insert_list.end(), current)
-          != insert_list.cend()) {
-        std::cout << "Circular reference found: Node of key =  " << current->key
-                  << std::endl;
-        return false;
-      }
-    }
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::node_type::key() const -> K& {
+    return node->key;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::node_type::mapped() const -> V& {
+    return node->value;
+  }
 
-    if (measured_size != size()) {
-      return false;
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::node_type::reset() -> void {
+    if (node != nullptr) {
+      Node::DestroyNode(*pool, node);
+      node = nullptr;
     }
 
-    return true;
+    pool.reset();
   }
 
   /// Node Methods
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::Node::CreateNode(K key) -> Node* {
-    return new Node(key, V(), nullptr, 1, 0, nullptr, nullptr);
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename KeyArg, typename... Args>
+  auto AVLmap<K, V, Compare, Pool>::Node::CreateNode(
+    Pool<Node>& pool,
+    KeyArg&& key,
+    Args&&... args
+  ) -> Node* {
+    Node* memory = pool.allocate();
+
+    try {
+      return new (memory) Node(
+        std::piecewise_construct,
+        std::forward<KeyArg>(key),
+        std::forward<Args>(args)...
+      );
+    } catch (...) {
+      pool.deallocate(memory);
+      throw;
+    }
   }
 
-  template<typename K, typename V>
-  AVLmap<K, V>::Node::Node(K k, V val, Node* p, int h, int b, Node* l, Node* r):
-      key(k), value(val), height(h), balance(b), parent(p), left(l), right(r) {}
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::Node::DestroyNode(
+    Pool<Node>& pool,
+    Node* node
+  ) -> void {
+    node->~Node();
+    pool.deallocate(node);
+  }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::Node::Key() const -> const K& {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap<K, V, Compare, Pool>::Node::Node(
+    K k,
+    V val,
+    Node* p,
+    int h,
+    int b,
+    Node* l,
+    Node* r
+  ):
+      key(std::move(k)),
+      value(std::move(val)),
+      height(static_cast<std::uint8_t>(h)),
+      balance(static_cast<std::int8_t>(b)),
+      parent(p),
+      left(l),
+      right(r) {}
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  template<typename KeyArg, typename... Args>
+  AVLmap<K, V, Compare, Pool>::Node::Node(
+    std::piecewise_construct_t,
+    KeyArg&& k,
+    Args&&... args
+  ):
+      key(std::forward<KeyArg>(k)),
+      value(std::forward<Args>(args)...),
+      height(1),
+      balance(0),
+      parent(nullptr),
+      left(nullptr),
+      right(nullptr) {}
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::Node::Key() const -> const K& {
     return key;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::Node::Value() -> V& {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::Node::Value() -> V& {
     return value;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::Node::Value() const -> const V& {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::Node::Value() const -> const V& {
     return value;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::Node::first() -> Node* {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::Node::first() -> Node* {
     if (left == nullptr) {
       return this;
     }
@@ -458,8 +2880,12 @@ namespace CS280 {
     return left->first();
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::Node::last() -> Node* {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::Node::last() -> Node* {
     if (right == nullptr) {
       return this;
     }
@@ -467,8 +2893,12 @@ namespace CS280 {
     return right->last();
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::Node::increment() -> Node* {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::Node::increment() -> Node* {
     // Searching right subtree
     if (right != nullptr) {
       return right->first();
@@ -488,8 +2918,12 @@ namespace CS280 {
     return nullptr;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::Node::decrement() -> Node* {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::Node::decrement() -> Node* {
     // Searching left subtree
     if (left != nullptr) {
       return left->last();
@@ -509,13 +2943,22 @@ namespace CS280 {
     return nullptr;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::Node::print(std::ostream& os) const -> void {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::Node::print(std::ostream& os) const
+    -> void {
     os << value;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::Node::is_right_child() const -> bool {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::Node::is_right_child() const -> bool {
     if (parent != nullptr) {
       return parent->right == this;
     }
@@ -523,8 +2966,12 @@ namespace CS280 {
     return false;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::Node::is_left_child() const -> bool {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::Node::is_left_child() const -> bool {
     if (parent != nullptr) {
       return parent->left == this;
     }
@@ -532,21 +2979,28 @@ namespace CS280 {
     return false;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::Node::add_child(Node& node) -> void {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::Node::add_child(Node& node, bool as_left)
+    -> void {
     node.parent = this;
 
-    if (node.Key() > key) {
-      right = &node;
-    }
-
-    if (node.Key() < key) {
+    if (as_left) {
       left = &node;
+    } else {
+      right = &node;
     }
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::Node::unlink_child(Node& node) -> void {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::Node::unlink_child(Node& node) -> void {
     if (&node == left) {
       left = nullptr;
       node.parent = nullptr;
@@ -558,9 +3012,15 @@ namespace CS280 {
     }
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::Node::replace_child(Node* to_replace, Node* replacement)
-    -> void {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::Node::replace_child(
+    Node* to_replace,
+    Node* replacement
+  ) -> void {
     if (to_replace == nullptr || replacement == nullptr) {
       return;
     }
@@ -578,13 +3038,22 @@ namespace CS280 {
     }
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::Node::has_children() const -> bool {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::Node::has_children() const -> bool {
     return (left != nullptr) || (right != nullptr);
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::Node::get_only_child() -> std::optional<Node*> {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::Node::get_only_child()
+    -> std::optional<Node*> {
     if (left != nullptr && right == nullptr) {
       return left;
     }
@@ -596,292 +3065,409 @@ namespace CS280 {
     return std::nullopt;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::Node::try_fix_balance(Node* previous, Node*& root)
-    -> Rotation {
-    int balance_l = 0;
-    int balance_r = 0;
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::Node::update_height() -> bool {
+    int height_l = 0;
+    int height_r = 0;
 
     if (left != nullptr) {
-      balance_l = left->height;
+      height_l = left->height;
     }
 
     if (right != nullptr) {
-      balance_r = right->height;
+      height_r = right->height;
     }
 
-    balance = balance_r - balance_l;
+    std::size_t previous_height = height;
 
-    if (balance == 0) {
-      return Rotation::NONE;
+    height = static_cast<std::uint8_t>(std::max(height_l, height_r) + 1);
+    balance = static_cast<std::int8_t>(height_r - height_l);
+
+    return height != previous_height;
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::Node::update_size() -> void {
+  #if AVLMAP_ORDER_STATISTICS
+    subtree_size = 1;
+
+    if (left != nullptr) {
+      subtree_size += left->subtree_size;
+    }
+
+    if (right != nullptr) {
+      subtree_size += right->subtree_size;
     }
+  #endif
+  }
+
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::Node::try_fix_balance(Node*& root)
+    -> Rotation {
+    bool was_root = this == root;
 
     if (balance > 1) {
-      if (previous != nullptr && previous->balance < 0) {
-        previous->rotate_right();
-      }
+      Rotation rotation = Rotation::LEFT;
 
-      if (this == root) {
-        root = right;
-        right->parent = nullptr;
+      if (right->balance < 0) {
+        right->rotate_right();
+        rotation = Rotation::RIGHT_LEFT;
       }
 
       rotate_left();
-      return Rotation::LEFT;
+
+      if (was_root) {
+        root = parent;
+      }
+
+      return rotation;
     }
 
     if (balance < -1) {
-      if (previous != nullptr && previous->balance > 0) {
-        previous->rotate_left();
-      }
+      Rotation rotation = Rotation::RIGHT;
 
-      if (this == root) {
-        root = left;
-        left->parent = nullptr;
+      if (left->balance > 0) {
+        left->rotate_left();
+        rotation = Rotation::LEFT_RIGHT;
       }
+
       rotate_right();
 
-      return Rotation::RIGHT;
+      if (was_root) {
+        root = parent;
+      }
+
+      return rotation;
     }
 
     return Rotation::NONE;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::Node::rotate_right() -> void {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::Node::rotate_right() -> void {
     if (left == nullptr) {
       return;
     }
 
     Node* to_promote = left;
-    this->left = nullptr;
-
-    if (parent != nullptr) {
-      parent->replace_child(this, to_promote);
-    }
-    parent = to_promote;
 
-    if (parent->right != nullptr) {
-      left = parent->right;
+    left = to_promote->right;
+    if (left != nullptr) {
       left->parent = this;
+    }
 
-      parent->right = nullptr;
+    to_promote->parent = parent;
+    if (is_left_child()) {
+      parent->left = to_promote;
+    } else if (is_right_child()) {
+      parent->right = to_promote;
     }
 
-    parent->right = this;
+    to_promote->right = this;
+    parent = to_promote;
+
+    // Only this node and the promoted one changed subtrees
+    update_height();
+    update_size();
+    to_promote->update_height();
+    to_promote->update_size();
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::Node::rotate_left() -> void {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::Node::rotate_left() -> void {
     if (right == nullptr) {
       return;
     }
 
     Node* to_promote = right;
-    this->right = nullptr;
-
-    if (parent != nullptr) {
-      parent->replace_child(this, to_promote);
-    }
-    parent = to_promote;
 
-    if (parent->left != nullptr) {
-      right = parent->left;
+    right = to_promote->left;
+    if (right != nullptr) {
       right->parent = this;
-
-      parent->left = nullptr;
-    }
-
-    parent->left = this;
-  }
-
-  template<typename K, typename V>
-  auto AVLmap<K, V>::Node::insert_balance(Node* previous, Node*& root) -> void {
-
-    // Updating the height
-    if (has_children()) {
-      int height_l = 0;
-      int height_r = 0;
-
-      if (left != nullptr) {
-        height_l = left->height;
-      }
-
-      if (right != nullptr) {
-        height_r = right->height;
-      }
-
-      if (height_l + 1 > height_r + 1) {
-        height = height_l + 1;
-      } else {
-        height = height_r + 1;
-      }
-    }
-
-    // Trying to fix balance in local subtree
-    Rotation rotation_occured = try_fix_balance(previous, root);
-
-    // Updating the height accordingly
-    if (rotation_occured != Rotation::NONE && parent != nullptr) {
-      parent->propagate_height_down();
     }
 
-    if (parent != nullptr) {
-      parent->insert_balance(this, root);
+    to_promote->parent = parent;
+    if (is_left_child()) {
+      parent->left = to_promote;
+    } else if (is_right_child()) {
+      parent->right = to_promote;
     }
-  }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::Node::propagate_height_down() -> void {
-    if (left != nullptr) {
-      left->height = height - 1;
-      left->propagate_height_down();
-    }
+    to_promote->left = this;
+    parent = to_promote;
 
-    if (right != nullptr) {
-      right->height = height - 1;
-      right->propagate_height_down();
-    }
+    // Only this node and the promoted one changed subtrees
+    update_height();
+    update_size();
+    to_promote->update_height();
+    to_promote->update_size();
   }
 
   // Iterator Methods
 
-  template<typename K, typename V>
-  AVLmap<K, V>::AVLmap_iterator::AVLmap_iterator(Node* p): p_node(p) {}
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap<K, V, Compare, Pool>::AVLmap_iterator::AVLmap_iterator(Node* p):
+      p_node(p) {}
 
-  template<typename K, typename V>
-  AVLmap<K, V>::AVLmap_iterator::AVLmap_iterator(AVLmap_iterator& rhs):
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap<K, V, Compare, Pool>::AVLmap_iterator::AVLmap_iterator(
+    const AVLmap_iterator& rhs
+  ):
       p_node(rhs.p_node) {}
 
-  template<typename K, typename V>
-  AVLmap<K, V>::AVLmap_iterator::operator AVLmap_iterator_const() {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap<K, V, Compare, Pool>::AVLmap_iterator::
+  operator AVLmap_iterator_const() {
     return AVLmap_iterator_const(p_node);
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::AVLmap_iterator::operator=(const AVLmap_iterator& rhs)
-    -> AVLmap_iterator& {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::AVLmap_iterator::operator=(
+    const AVLmap_iterator& rhs
+  ) -> AVLmap_iterator& {
     p_node = rhs.p_node;
     return *this;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::AVLmap_iterator::operator++() -> AVLmap_iterator& {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::AVLmap_iterator::operator++()
+    -> AVLmap_iterator& {
     p_node = p_node->increment();
     return *this;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::AVLmap_iterator::operator++(int) -> AVLmap_iterator {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::AVLmap_iterator::operator++(int)
+    -> AVLmap_iterator {
     AVLmap_iterator output = AVLmap_iterator(p_node);
     p_node = p_node->increment();
     return output;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::AVLmap_iterator::operator--() -> AVLmap_iterator& {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::AVLmap_iterator::operator--()
+    -> AVLmap_iterator& {
     p_node = p_node->decrement();
     return *this;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::AVLmap_iterator::operator--(int) -> AVLmap_iterator {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::AVLmap_iterator::operator--(int)
+    -> AVLmap_iterator {
     AVLmap_iterator output = AVLmap_iterator(p_node);
     p_node = p_node->decrement();
     return output;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::AVLmap_iterator::operator*() -> Node& {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::AVLmap_iterator::operator*() -> Node& {
     return *p_node;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::AVLmap_iterator::operator->() -> Node* {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::AVLmap_iterator::operator->() -> Node* {
     return p_node;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::AVLmap_iterator::operator!=(const AVLmap_iterator& rhs)
-    -> bool {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::AVLmap_iterator::operator!=(
+    const AVLmap_iterator& rhs
+  ) -> bool {
     return p_node != rhs.p_node;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::AVLmap_iterator::operator==(const AVLmap_iterator& rhs)
-    -> bool {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::AVLmap_iterator::operator==(
+    const AVLmap_iterator& rhs
+  ) -> bool {
     return p_node == rhs.p_node;
   }
 
   // Const iterator_const Methods
 
-  template<typename K, typename V>
-  AVLmap<K, V>::AVLmap_iterator_const::AVLmap_iterator_const(Node* p):
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap<K, V, Compare, Pool>::AVLmap_iterator_const::AVLmap_iterator_const(
+    Node* p
+  ):
       p_node(p) {}
 
-  template<typename K, typename V>
-  AVLmap<K, V>::AVLmap_iterator_const::AVLmap_iterator_const(
-    AVLmap_iterator_const& rhs
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  AVLmap<K, V, Compare, Pool>::AVLmap_iterator_const::AVLmap_iterator_const(
+    const AVLmap_iterator_const& rhs
   ):
       p_node(rhs.p_node) {}
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::AVLmap_iterator_const::operator=(
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::AVLmap_iterator_const::operator=(
     const AVLmap_iterator_const& rhs
   ) -> AVLmap_iterator_const& {
     p_node = rhs.p_node;
     return *this;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::AVLmap_iterator_const::operator++()
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::AVLmap_iterator_const::operator++()
     -> AVLmap_iterator_const& {
     p_node = p_node->increment();
     return *this;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::AVLmap_iterator_const::operator++(int)
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::AVLmap_iterator_const::operator++(int)
     -> AVLmap_iterator_const {
     AVLmap_iterator_const output = AVLmap_iterator_const(p_node);
     p_node = p_node->increment();
     return output;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::AVLmap_iterator_const::operator--()
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::AVLmap_iterator_const::operator--()
     -> AVLmap_iterator_const& {
     p_node = p_node->decrement();
     return *this;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::AVLmap_iterator_const::operator--(int)
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::AVLmap_iterator_const::operator--(int)
     -> AVLmap_iterator_const {
     AVLmap_iterator_const output = AVLmap_iterator_const(p_node);
     p_node = p_node->decrement();
     return output;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::AVLmap_iterator_const::operator*() -> const Node& {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::AVLmap_iterator_const::operator*()
+    -> const Node& {
     return *p_node;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::AVLmap_iterator_const::operator->() -> const Node* {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::AVLmap_iterator_const::operator->()
+    -> const Node* {
     return p_node;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::AVLmap_iterator_const::operator!=(
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::AVLmap_iterator_const::operator!=(
     const AVLmap_iterator_const& rhs
   ) -> bool {
     return p_node != rhs.p_node;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::AVLmap_iterator_const::operator==(
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::AVLmap_iterator_const::operator==(
     const AVLmap_iterator_const& rhs
   ) -> bool {
     return p_node == rhs.p_node;
@@ -892,8 +3478,13 @@ namespace CS280 {
   /* figure out whether node is left or right child or root
    * used in print_backwards_padded
    */
-  template<typename K, typename V>
-  auto AVLmap<K, V>::get_edge_symbol(const Node* node) const -> char {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::get_edge_symbol(const Node* node) const
+    -> char {
     const Node* parent = node->parent;
     if (parent == nullptr) {
       return '-';
@@ -906,16 +3497,28 @@ namespace CS280 {
    * iterative function.
    * Left branch of the tree is at the bottom
    */
-  template<typename K, typename V>
-  auto operator<<(std::ostream& os, const AVLmap<K, V>& map) -> std::ostream& {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto operator<<(std::ostream& os, const AVLmap<K, V, Compare, Pool>& map)
+    -> std::ostream& {
     map.print(os);
     return os;
   }
 
-  template<typename K, typename V>
-  auto AVLmap<K, V>::print(std::ostream& os, bool print_value) const -> void {
+  template<
+    typename K,
+    typename V,
+    typename Compare,
+    template<typename> class Pool>
+  auto AVLmap<K, V, Compare, Pool>::print(
+    std::ostream& os,
+    bool print_value
+  ) const -> void {
     if (root) {
-      AVLmap<K, V>::Node* b = root->last();
+      AVLmap<K, V, Compare, Pool>::Node* b = root->last();
       while (b) {
         int depth = getdepth(b);
         int i;
@@ -11,8 +11,31 @@
 #ifndef AVLMAP_H
   #define AVLMAP_H
 
+  #include <cstdint>
+  #include <functional>
   #include <iosfwd>
   #include <optional>
+  #include <utility>
+
+  #include "avl-map-eytzinger.h"
+  #include "avl-map-frozen.h"
+  #include "fork-join-pool.h"
+  #include "node-pool.h"
+
+  // Define as 0 before including to drop the subtree sizes from the nodes
+  // (and with them select, rank and count_range)
+  #ifndef AVLMAP_ORDER_STATISTICS
+    #define AVLMAP_ORDER_STATISTICS 1
+  #endif
+
+  // Hint to start loading a node into the cache (no-op where unsupported)
+  #ifndef AVLMAP_PREFETCH
+    #if defined(__GNUC__) || defined(__clang__)
+      #define AVLMAP_PREFETCH(address) __builtin_prefetch(address)
+    #else
+      #define AVLMAP_PREFETCH(address) static_cast<void>(address)
+    #endif
+  #endif
 
 namespace CS280 {
 
@@ -23,11 +46,18 @@ namespace CS280 {
    * - Find
    * - Erase
    *
-   * @param K The type for the key to be used (Needs the < and > operator
-   * overloads)
+   * @param K The type for the key to be used
    * @param V The type for the values to be used (Needs to be copiable)
+   * @param Compare The strict weak ordering of the keys. If it is transparent
+   * (like std::less<>) lookups accept any type it can compare with K
+   * @param Pool The allocation policy for the nodes (NodePool keeps them in
+   * slabs and reuses freed nodes, HeapPool uses new and delete)
    */
-  template<typename K, typename V>
+  template<
+    typename K,
+    typename V,
+    typename Compare = std::less<K>,
+    template<typename> class Pool = NodePool>
   class AVLmap {
 
     // Forward declarations for the struct
@@ -40,6 +70,11 @@ namespace CS280 {
     typedef AVLmap_iterator iterator;
     typedef AVLmap_iterator_const const_iterator;
 
+    class Node;
+
+    // the allocation policy instantiated for the nodes of this map
+    typedef Pool<Node> node_pool;
+
     /**
      * @brief This class represents a Node in the AVL. It mainly features
      * getters, setters and traversal methods.
@@ -48,12 +83,26 @@ namespace CS280 {
     public:
 
       /**
-       * @brief Factory method for an empty unlinked node of key K.
+       * @brief Factory method for an unlinked node. The key and the value are
+       * constructed in place.
        *
-       * @param key The key to use.
+       * @param pool The pool to allocate the node from.
+       * @param key The argument to construct the key from.
+       * @param args The arguments to construct the value from (none to value
+       * initialize it).
        * @return Pointer to allocated node.
        */
-      static auto CreateNode(K key) -> Node*;
+      template<typename KeyArg, typename... Args>
+      static auto CreateNode(Pool<Node>& pool, KeyArg&& key, Args&&... args)
+        -> Node*;
+
+      /**
+       * @brief Destroys a node and gives its memory back to the pool.
+       *
+       * @param pool The pool the node was allocated from.
+       * @param node The node to destroy.
+       */
+      static auto DestroyNode(Pool<Node>& pool, Node* node) -> void;
 
       /**
        * @brief Constructor for a Node.
@@ -67,6 +116,16 @@ namespace CS280 {
        */
       Node(K k, V val, Node* p, int h, int b, Node* l, Node* r);
 
+      /**
+       * @brief Constructor for an unlinked leaf that builds the key and the
+       * value in place.
+       *
+       * @param k The argument to construct the key from.
+       * @param args The arguments to construct the value from.
+       */
+      template<typename KeyArg, typename... Args>
+      Node(std::piecewise_construct_t, KeyArg&& k, Args&&... args);
+
       // Deleted copy constructor
       Node(const Node&) = delete;
 
@@ -125,7 +184,9 @@ namespace CS280 {
       enum class Rotation {
         NONE,
         RIGHT,
-        LEFT
+        LEFT,
+        LEFT_RIGHT,
+        RIGHT_LEFT
       };
 
       /**
@@ -141,10 +202,12 @@ namespace CS280 {
       auto is_left_child() const -> bool;
 
       /**
-       * @brief Will add a child updating the links properly and setting it to
-       * the correct side.
+       * @brief Will add a child updating the links properly.
+       *
+       * @param node The node to add.
+       * @param as_left Whether it goes on the left side.
        */
-      auto add_child(Node& node) -> void;
+      auto add_child(Node& node, bool as_left) -> void;
 
       /**
        * @brief Will remove a child.
@@ -174,33 +237,38 @@ namespace CS280 {
       auto get_only_child() -> std::optional<Node*>;
 
       /**
-       * @brief This will try to fix the balance of the node. Otherwise it will
-       * return false
+       * @brief Recomputes the height and balance of this node from the heights
+       * of its children.
        *
-       * @return Whether a rotation occured
+       * @return Whether the height of this node changed.
        */
-      auto try_fix_balance(Node* previous, Node*& root) -> Rotation;
+      auto update_height() -> bool;
 
       /**
-       * @brief Performs a right rotation about the calling node.
+       * @brief Recomputes the subtree size of this node from the sizes of its
+       * children. Does nothing when order statistics are disabled.
        */
-      auto rotate_right() -> void;
+      auto update_size() -> void;
 
       /**
-       * @brief Performs a left rotation about the calling node.
+       * @brief This will try to fix the balance of the node. Otherwise it will
+       * return false
+       *
+       * @return The rotation that occured
        */
-      auto rotate_left() -> void;
+      auto try_fix_balance(Node*& root) -> Rotation;
 
       /**
-       * @brief Recursive function that will update the balance of the nodes in
-       * the tree.
+       * @brief Performs a right rotation about the calling node. Only the
+       * heights of the two nodes involved are recomputed.
        */
-      auto insert_balance(Node* previous, Node*& root) -> void;
+      auto rotate_right() -> void;
 
       /**
-       * @brief Propagates the height of this node downwards recursively.
+       * @brief Performs a left rotation about the calling node. Only the
+       * heights of the two nodes involved are recomputed.
        */
-      auto propagate_height_down() -> void;
+      auto rotate_left() -> void;
 
       /**
        * @brief The key of this node.
@@ -214,14 +282,22 @@ namespace CS280 {
 
       /**
        * @brief The distance of the node relative to the leaves of the sub-tree
+       * (an AVL tree of height 255 would need more than 2^176 nodes)
        */
-      size_t height;
+      std::uint8_t height;
 
       /**
        * @brief The difference of height between the left and right children's
        * height
        */
-      int balance;
+      std::int8_t balance;
+
+  #if AVLMAP_ORDER_STATISTICS
+      /**
+       * @brief The amount of nodes in the subtree rooted at this node
+       */
+      unsigned int subtree_size{1};
+  #endif
 
       /**
        * @brief The parent of this node
@@ -266,7 +342,7 @@ namespace CS280 {
       /**
        * @brief Copy constructor for the iterator
        */
-      AVLmap_iterator(AVLmap_iterator& rhs);
+      AVLmap_iterator(const AVLmap_iterator& rhs);
 
       /**
        * @brief Conversion operator into const
@@ -345,7 +421,7 @@ namespace CS280 {
       /**
        * @brief Copy constructor for the iterator
        */
-      AVLmap_iterator_const(AVLmap_iterator_const& rhs);
+      AVLmap_iterator_const(const AVLmap_iterator_const& rhs);
 
       /**
        * @brief Copy assignment operator
@@ -406,6 +482,191 @@ namespace CS280 {
 
   public:
 
+    /**
+     * @brief Counters describing the work done by the retrace that runs after
+     * every insertion and erasure.
+     */
+    struct RebalanceStats {
+      /**
+       * @brief Amount of updates that ran a retrace.
+       */
+      std::size_t operations{0};
+
+      /**
+       * @brief Total amount of nodes visited by all the retraces.
+       */
+      std::size_t retrace_length{0};
+
+      /**
+       * @brief Total amount of single rotations (a double rotation counts as
+       * two).
+       */
+      std::size_t rotations{0};
+
+      /**
+       * @brief Amount of nodes visited by the last retrace.
+       */
+      std::size_t last_retrace_length{0};
+
+      /**
+       * @brief Amount of single rotations done by the last retrace.
+       */
+      std::size_t last_rotations{0};
+    };
+
+    /**
+     * @brief Result of validating the whole tree in a single pass.
+     */
+    struct SanityReport {
+      /**
+       * @brief The kinds of problems the validation can find.
+       */
+      enum class Issue {
+        NONE,
+        ORDER,
+        PARENT_LINK,
+        CYCLE,
+        HEIGHT,
+        BALANCE,
+        SUBTREE_SIZE,
+        SIZE
+      };
+
+      /**
+       * @brief The first problem found (NONE if the tree is valid).
+       */
+      Issue issue{Issue::NONE};
+
+      /**
+       * @brief The node where the problem was found (nullptr if none).
+       */
+      const Node* node{nullptr};
+
+      /**
+       * @brief Amount of nodes visited before stopping.
+       */
+      std::size_t nodes_visited{0};
+
+      /**
+       * @brief Height of the tree (only meaningful if it is valid).
+       */
+      std::size_t height{0};
+
+      /**
+       * @brief Whether the tree is valid.
+       */
+      explicit operator bool() const;
+
+      /**
+       * @brief Short description of the issue.
+       */
+      auto what() const -> const char*;
+    };
+
+    /**
+     * @brief Owning handle to a node extracted from a map. Its key can be
+     * changed before inserting it into a map, which links the node itself
+     * (no allocation or copy) if that map shares the pool it came from.
+     */
+    class node_type {
+    public:
+
+      /**
+       * @brief Constructor for an empty handle
+       */
+      node_type();
+
+      // Deleted copy constructor
+      node_type(const node_type&) = delete;
+
+      // Deleted copy assignment operator
+      auto operator=(const node_type&) -> node_type& = delete;
+
+      /**
+       * @brief Move Constructor (rhs is left empty)
+       */
+      node_type(node_type&& rhs);
+
+      /**
+       * @brief Move Assignment Operator (rhs is left empty)
+       */
+      auto operator=(node_type&& rhs) -> node_type&;
+
+      /**
+       * @brief Destructor (destroys the node if there is one)
+       */
+      ~node_type();
+
+      /**
+       * @brief Returns whether the handle holds no node.
+       * @return Whether the handle is empty.
+       */
+      auto empty() const -> bool;
+
+      /**
+       * @brief Whether the handle holds a node.
+       */
+      explicit operator bool() const;
+
+      /**
+       * @brief Getter of a reference to the key of the node.
+       * @return Reference to the key (it can be changed).
+       */
+      auto key() const -> K&;
+
+      /**
+       * @brief Getter of a reference to the value of the node.
+       * @return Reference to the value.
+       */
+      auto mapped() const -> V&;
+
+    private:
+
+      /**
+       * @brief Constructor for a handle owning an unlinked node.
+       * @param n The node.
+       * @param p The pool the node was allocated from.
+       */
+      node_type(Node* n, const node_pool& p);
+
+      /**
+       * @brief Destroys the node if there is one, leaving the handle empty.
+       */
+      auto reset() -> void;
+
+      /**
+       * @brief The owned node (nullptr if empty).
+       */
+      Node* node;
+
+      /**
+       * @brief The pool the node goes back to (empty if there is no node).
+       */
+      std::optional<node_pool> pool;
+
+      friend AVLmap;
+    };
+
+    /**
+     * @brief Result of inserting a node handle.
+     */
+    struct insert_return_type {
+      /**
+       * @brief The node with the key of the handle.
+       */
+      iterator position;
+
+      /**
+       * @brief Whether the node of the handle was inserted.
+       */
+      bool inserted;
+
+      /**
+       * @brief The handle if its key was already in the map (empty otherwise).
+       */
+      node_type node;
+    };
+
     // Rule of 5
 
     /**
@@ -413,6 +674,30 @@ namespace CS280 {
      */
     AVLmap();
 
+    /**
+     * @brief Constructor from a range of key/value pairs. Sorted input is
+     * built into a balanced tree in linear time, any other input is sorted
+     * first (for repeated keys the last pair wins, like with operator[]).
+     * @param first The start of the range
+     * @param last The end of the range
+     */
+    template<typename InputIt>
+    AVLmap(InputIt first, InputIt last);
+
+    /**
+     * @brief Constructor with a comparator
+     * @param comp The comparator used to order the keys
+     */
+    explicit AVLmap(const Compare& comp);
+
+    /**
+     * @brief Constructor for a map that allocates its nodes from the same
+     * pool as another map, so node handles can move between them for free
+     * @param shared_pool The pool to share (see get_pool)
+     * @param comp The comparator used to order the keys
+     */
+    explicit AVLmap(const node_pool& shared_pool, const Compare& comp = {});
+
     /**
      * @brief Copy Constructor
      */
@@ -438,12 +723,58 @@ namespace CS280 {
      */
     virtual ~AVLmap();
 
+    /**
+     * @brief Replaces the contents of the map with a range of key/value pairs.
+     * Sorted input is built into a balanced tree in linear time, any other
+     * input is sorted first (for repeated keys the last pair wins).
+     * @param first The start of the range
+     * @param last The end of the range
+     */
+    template<typename InputIt>
+    auto assign(InputIt first, InputIt last) -> void;
+
+    /**
+     * @brief Parallel assign. Sorted random access input whose keys and
+     * values can be constructed without throwing has its nodes allocated up
+     * front, then constructed and linked as tasks of the pool down to
+     * parallel_grain_size nodes. Any other input is assigned sequentially.
+     * @param first The start of the range
+     * @param last The end of the range
+     * @param workers The pool to run the tasks on
+     */
+    template<typename InputIt>
+    auto assign(InputIt first, InputIt last, ForkJoinPool& workers) -> void;
+
+    /**
+     * @brief Inserts a range of key/value pairs sorted by key. A batch big
+     * enough to touch most of the tree is merged with it and relinked in one
+     * pass. A smaller sorted random access batch is divided at every node it
+     * passes and the node is joined back with its children once they took
+     * their part, so each node on the paths to the keys is rebalanced once
+     * (O(k log(n/k)) for k keys) instead of after every key. Any other input
+     * searches from the node inserted before it (climbing only as far as the
+     * next key needs). Keys already in the map get the new value (for
+     * repeated keys the last pair wins). Unsorted input is still inserted
+     * correctly, just without the shortcuts.
+     * @param first The start of the range
+     * @param last The end of the range
+     * @return The amount of keys that were not in the map
+     */
+    template<typename InputIt>
+    auto insert_sorted_batch(InputIt first, InputIt last) -> std::size_t;
+
     /**
      * @brief Getter for the size
      * @return The size of the tree
      */
     auto size() -> unsigned int;
 
+    /**
+     * @brief Getter for the comparator
+     * @return Copy of the comparator used to order the keys
+     */
+    auto key_comp() const -> Compare;
+
     /**
      * @brief Getter for the depth of a node in the tree
      * @param node The node to get the depth of
@@ -458,6 +789,62 @@ namespace CS280 {
      */
     auto operator[](const K& key) -> V&;
 
+    /**
+     * @brief Indexer for the map that moves the key into the node when it has
+     * to create one
+     * @param key The key to search for (will create a node if there isn't one)
+     * @return Reference to the value
+     */
+    auto operator[](K&& key) -> V&;
+
+    /**
+     * @brief Constructs a node in place and links it if its key is not in the
+     * map yet (the node is destroyed otherwise)
+     * @param key The argument to construct the key from
+     * @param args The arguments to construct the value from
+     * @return Iterator to the node with the key and whether it was inserted
+     */
+    template<typename KeyArg, typename... Args>
+    auto emplace(KeyArg&& key, Args&&... args) -> std::pair<iterator, bool>;
+
+    /**
+     * @brief Inserts a node with the key and a value constructed in place if
+     * the key is not in the map. Nothing is constructed or moved otherwise.
+     * @param key The key to insert
+     * @param args The arguments to construct the value from
+     * @return Iterator to the node with the key and whether it was inserted
+     */
+    template<typename... Args>
+    auto try_emplace(const K& key, Args&&... args) -> std::pair<iterator, bool>;
+
+    /**
+     * @brief Same as try_emplace, moving the key into the node.
+     * @param key The key to insert
+     * @param args The arguments to construct the value from
+     * @return Iterator to the node with the key and whether it was inserted
+     */
+    template<typename... Args>
+    auto try_emplace(K&& key, Args&&... args) -> std::pair<iterator, bool>;
+
+    /**
+     * @brief Assigns to the value of the key if it is in the map, otherwise
+     * inserts a node with the value constructed from obj.
+     * @param key The key to insert
+     * @param obj The value to assign or insert
+     * @return Iterator to the node with the key and whether it was inserted
+     */
+    template<typename M>
+    auto insert_or_assign(const K& key, M&& obj) -> std::pair<iterator, bool>;
+
+    /**
+     * @brief Same as insert_or_assign, moving the key into the node.
+     * @param key The key to insert
+     * @param obj The value to assign or insert
+     * @return Iterator to the node with the key and whether it was inserted
+     */
+    template<typename M>
+    auto insert_or_assign(K&& key, M&& obj) -> std::pair<iterator, bool>;
+
     // next method doesn't make sense
     // because operator[] inserts a non-existing element
     // which is not allowed on const maps
@@ -479,10 +866,222 @@ namespace CS280 {
     auto find(const K& key) -> iterator;
 
     /**
-     * @brief Searches for a value using the key and erases it
+     * @brief Searches for a value using anything the transparent comparator
+     * can compare with the keys, without building a K
+     */
+    template<
+      typename KeyLike,
+      typename C = Compare,
+      typename = typename C::is_transparent>
+    auto find(const KeyLike& key) -> iterator;
+
+    /**
+     * @brief Searches for many keys at once. Several searches are in flight
+     * at a time, each one prefetching its next node while the others advance,
+     * so the cache misses of different keys overlap
+     * @param first The start of the keys (random access)
+     * @param last The end of the keys
+     * @param out Where the iterators go (random access, out[i] gets the
+     * result for first[i], end if the key is not in the map)
+     */
+    template<typename RandomIt, typename OutIt>
+    auto find_batch(RandomIt first, RandomIt last, OutIt out) -> void;
+
+    /**
+     * @brief Searches for the first node whose key is not less than a key
+     */
+    auto lower_bound(const K& key) -> iterator;
+
+    /**
+     * @brief Transparent version of lower_bound
+     */
+    template<
+      typename KeyLike,
+      typename C = Compare,
+      typename = typename C::is_transparent>
+    auto lower_bound(const KeyLike& key) -> iterator;
+
+    /**
+     * @brief Searches for the first node whose key is greater than a key
+     */
+    auto upper_bound(const K& key) -> iterator;
+
+    /**
+     * @brief Transparent version of upper_bound
+     */
+    template<
+      typename KeyLike,
+      typename C = Compare,
+      typename = typename C::is_transparent>
+    auto upper_bound(const KeyLike& key) -> iterator;
+
+    /**
+     * @brief Searches for the range of nodes whose key is equal to a key
+     * @return The lower and upper bounds of the key
+     */
+    auto equal_range(const K& key) -> std::pair<iterator, iterator>;
+
+    /**
+     * @brief Erases the node the iterator points to. Nodes are relinked, never
+     * moved, so every other iterator stays valid
      */
     auto erase(iterator it) -> void;
 
+    /**
+     * @brief Erases the nodes from first up to (not including) last. The
+     * range is cut out with two splits and a join and its nodes are freed in
+     * bulk, so it costs O(log n + k) with no rebalancing per key
+     * @param first The first node to erase
+     * @param last The node after the last one to erase (can be end)
+     * @return last (still valid, like every iterator outside the range)
+     */
+    auto erase(iterator first, iterator last) -> iterator;
+
+    /**
+     * @brief Erases the keys in [lo, hi) (see the range erase)
+     * @param lo The lowest key to erase
+     * @param hi The key erasing stops at
+     * @return The amount of nodes erased
+     */
+    auto erase_range(const K& lo, const K& hi) -> std::size_t;
+
+    /**
+     * @brief Copies the map into a read only snapshot laid out for lookups
+     * (see AVLmap_frozen). The map stays writable, later changes are not seen
+     * by the snapshot. Lookups get faster, but walking the snapshot in order
+     * costs O(log n) per step
+     * @return The snapshot
+     */
+    auto freeze() const -> AVLmap_frozen<K, V, Compare>;
+
+    /**
+     * @brief Copies the map into a read only snapshot in breadth first order
+     * (see AVLmap_eytzinger), the same way as freeze
+     * @return The snapshot
+     */
+    auto export_eytzinger() const -> AVLmap_eytzinger<K, V, Compare>;
+
+    /**
+     * @brief Unlinks the node the iterator points to and hands it over. Every
+     * other iterator stays valid
+     * @param it Iterator to the node (must not be end)
+     * @return Handle owning the node
+     */
+    auto extract(iterator it) -> node_type;
+
+    /**
+     * @brief Unlinks the node holding a key and hands it over
+     * @param key The key to search for
+     * @return Handle owning the node (empty if the key is not in the map)
+     */
+    auto extract(const K& key) -> node_type;
+
+    /**
+     * @brief Links the node of a handle if its key is not in the map yet. If
+     * the maps share their pool nothing is allocated, otherwise the key and
+     * the value are moved into a new node
+     * @param node The handle to insert
+     * @return Where the key is, whether it was inserted and the handle back
+     * if it was not
+     */
+    auto insert(node_type&& node) -> insert_return_type;
+
+    /**
+     * @brief Moves every node whose key is not in this map out of source.
+     * Nodes are relinked as they are if both maps share their pool
+     * @param source The map to take the nodes from
+     */
+    auto merge(AVLmap& source) -> void;
+
+    /**
+     * @brief Moves every node whose key is not in this map out of source.
+     * @param source The map to take the nodes from
+     */
+    auto merge(AVLmap&& source) -> void;
+
+    /**
+     * @brief Moves every key not less than a given one into a new map, in
+     * O(log n) (plus a recount of the nodes when order statistics are
+     * disabled). The new map shares the pool of this one, which then locks
+     * its allocations: each half can be used from its own thread, and
+     * clearing either one destroys its nodes one by one until the other is
+     * gone
+     * @param key Where to split
+     * @return The map with the upper part
+     */
+    auto split(const K& key) -> AVLmap;
+
+    /**
+     * @brief Appends a map whose keys are all greater than the ones of this
+     * map, in O(log n). The nodes are relinked as they are if both maps share
+     * their pool, and overlapping key ranges fall back to union_with. Both
+     * maps are changed, so no other thread may be using upper meanwhile
+     * @param upper The map to append (left empty)
+     */
+    auto join(AVLmap&& upper) -> void;
+
+    /**
+     * @brief Adds the keys of another map that are not in this one (keys in
+     * both keep the value of this map). Built on split and join, so it runs
+     * in O(m log(n/m + 1)) for maps of sizes m <= n (a much smaller other map
+     * is inserted key by key instead, see set_split_ratio)
+     * @param other The map to take the keys from
+     */
+    auto union_with(const AVLmap& other) -> void;
+
+    /**
+     * @brief Same as the copying union_with, but the nodes of other are
+     * relinked as they are if both maps share their pool. Both maps are
+     * changed, so no other thread may be using other meanwhile
+     * @param other The map to take the keys from (left empty)
+     */
+    auto union_with(AVLmap&& other) -> void;
+
+    /**
+     * @brief Erases the keys that are not in another map, in
+     * O(m log(n/m + 1))
+     * @param other The map with the keys to keep
+     */
+    auto intersect_with(const AVLmap& other) -> void;
+
+    /**
+     * @brief Erases the keys that are in another map, in O(m log(n/m + 1))
+     * @param other The map with the keys to erase
+     */
+    auto difference_with(const AVLmap& other) -> void;
+
+    /**
+     * @brief Parallel union_with: the two halves left by every split are
+     * merged as separate tasks of the pool, down to subtrees of
+     * parallel_grain_height. Nodes are only destroyed once the tasks are done
+     * (the node pool is not thread safe)
+     * @param other The map to take the keys from
+     * @param workers The pool to run the tasks on
+     */
+    auto union_with(const AVLmap& other, ForkJoinPool& workers) -> void;
+
+    /**
+     * @brief Parallel union_with relinking the nodes of other as they are if
+     * both maps share their pool
+     * @param other The map to take the keys from (left empty)
+     * @param workers The pool to run the tasks on
+     */
+    auto union_with(AVLmap&& other, ForkJoinPool& workers) -> void;
+
+    /**
+     * @brief Parallel intersect_with (see the parallel union_with)
+     * @param other The map with the keys to keep
+     * @param workers The pool to run the tasks on
+     */
+    auto intersect_with(const AVLmap& other, ForkJoinPool& workers) -> void;
+
+    /**
+     * @brief Parallel difference_with (see the parallel union_with)
+     * @param other The map with the keys to erase
+     * @param workers The pool to run the tasks on
+     */
+    auto difference_with(const AVLmap& other, ForkJoinPool& workers) -> void;
+
     /**
      * @brief Returns an iterator to the first node of the tree
      */
@@ -498,6 +1097,81 @@ namespace CS280 {
      */
     auto find(const K& key) const -> const_iterator;
 
+    /**
+     * @brief Transparent version of find
+     */
+    template<
+      typename KeyLike,
+      typename C = Compare,
+      typename = typename C::is_transparent>
+    auto find(const KeyLike& key) const -> const_iterator;
+
+    /**
+     * @brief Const version of find_batch
+     */
+    template<typename RandomIt, typename OutIt>
+    auto find_batch(RandomIt first, RandomIt last, OutIt out) const -> void;
+
+    /**
+     * @brief Searches for the first node whose key is not less than a key
+     */
+    auto lower_bound(const K& key) const -> const_iterator;
+
+    /**
+     * @brief Transparent version of lower_bound
+     */
+    template<
+      typename KeyLike,
+      typename C = Compare,
+      typename = typename C::is_transparent>
+    auto lower_bound(const KeyLike& key) const -> const_iterator;
+
+    /**
+     * @brief Searches for the first node whose key is greater than a key
+     */
+    auto upper_bound(const K& key) const -> const_iterator;
+
+    /**
+     * @brief Transparent version of upper_bound
+     */
+    template<
+      typename KeyLike,
+      typename C = Compare,
+      typename = typename C::is_transparent>
+    auto upper_bound(const KeyLike& key) const -> const_iterator;
+
+    /**
+     * @brief Searches for the range of nodes whose key is equal to a key
+     * @return The lower and upper bounds of the key
+     */
+    auto equal_range(const K& key) const
+      -> std::pair<const_iterator, const_iterator>;
+
+  #if AVLMAP_ORDER_STATISTICS
+    /**
+     * @brief Searches for the k-th smallest key (starting at 0)
+     * @return Iterator to the node, end() if k is not less than the size
+     */
+    auto select(unsigned int k) -> iterator;
+
+    /**
+     * @brief Searches for the k-th smallest key (starting at 0)
+     * @return Iterator to the node, end() if k is not less than the size
+     */
+    auto select(unsigned int k) const -> const_iterator;
+
+    /**
+     * @brief Counts the keys that are less than a key
+     * @return The position the key has (or would have) in the map
+     */
+    auto rank(const K& key) const -> unsigned int;
+
+    /**
+     * @brief Counts the keys in the range [lo, hi)
+     */
+    auto count_range(const K& lo, const K& hi) const -> unsigned int;
+  #endif
+
     // do not need this one (why) (because const functions should not be able to
     // edit the tree) AVLmap_iterator_const erase(AVLmap_iterator& it) const;
 
@@ -505,7 +1179,38 @@ namespace CS280 {
      * @brief Integrity for the check of the tree
      * @return Whether the tree is valid
      */
-    auto sanityCheck() -> bool;
+    auto sanityCheck() const -> bool;
+
+    /**
+     * @brief Validates the whole tree in a single O(n) pass without extra
+     * memory: key ordering, parent links, stored heights, balances, subtree
+     * sizes and the size of the map.
+     * @return The report of the validation
+     */
+    auto validate() const -> SanityReport;
+
+    /**
+     * @brief Getter for the counters of the node pool
+     * @return The allocation counters and the bytes used per node
+     */
+    auto pool_stats() const -> const PoolStats&;
+
+    /**
+     * @brief Getter for the node pool (to build maps that share it)
+     * @return The node pool
+     */
+    auto get_pool() const -> const node_pool&;
+
+    /**
+     * @brief Getter for the retrace counters
+     * @return The counters accumulated since construction or the last reset
+     */
+    auto rebalance_stats() const -> const RebalanceStats&;
+
+    /**
+     * @brief Resets the retrace counters to zero
+     */
+    auto reset_rebalance_stats() -> void;
 
     /**
      * @brief Get the edge to display the tree for a given node
@@ -537,17 +1242,471 @@ namespace CS280 {
     };
 
     /**
-     * @brief Search for a given node with a key
+     * @brief Result of looking for the place of a key
+     */
+    struct InsertSearch {
+      /**
+       * @brief The node holding the key (nullptr if there is none)
+       */
+      Node* match;
+
+      /**
+       * @brief The node the key would be a child of
+       */
+      Node* parent;
+
+      /**
+       * @brief Whether the key would be the left child of parent
+       */
+      bool as_left;
+    };
+
+    /**
+     * @brief Search for a given node with a key. Does a single comparison per
+     * level.
      * @param key The key to search for
      * @return Optional to the found node
      */
-    auto search_node(K key) const -> std::optional<NodeSearch>;
+    template<typename KeyLike>
+    auto search_node(const KeyLike& key) const -> std::optional<NodeSearch>;
+
+    /**
+     * @brief Search for the node holding a key or the place where it would be
+     * inserted. Does a single comparison per level.
+     * @param key The key to search for
+     * @return The match or the insertion place
+     */
+    auto search_insert(const K& key) const -> InsertSearch;
+
+    /**
+     * @brief Same as search_insert, but starting from a node close to the
+     * place of the key. It climbs from the finger to the first ancestor not
+     * less than the key (whose subtree then holds the place of the key) and
+     * descends from there.
+     * @param key The key to search for
+     * @param finger A node with a key less than the given one (or nullptr to
+     * start from the root)
+     * @return The match or the insertion place
+     */
+    auto search_insert_from(const K& key, Node* finger) const -> InsertSearch;
+
+    /**
+     * @brief Batches at least this fraction of the size of the map are merged
+     * with it and relinked (see insert_sorted_batch)
+     */
+    static constexpr std::size_t batch_relink_ratio{4};
+
+    /**
+     * @brief Maps over this many times bigger than the other map of a set
+     * operation search the keys of the other map one by one instead, as a
+     * few searches touch fewer nodes than splitting and joining around them
+     */
+    static constexpr std::size_t set_split_ratio{16};
+
+    /**
+     * @brief Subtrees lower than this are not split into parallel tasks by
+     * the set operations (an AVL tree of height 12 has 376 to 4095 nodes)
+     */
+    static constexpr int parallel_grain_height{12};
 
     /**
-     * @brief Delete the whole tree
+     * @brief Ranges shorter than this are not split into parallel tasks by
+     * the parallel assign
+     */
+    static constexpr std::size_t parallel_grain_size{1 << 14};
+
+    /**
+     * @brief Subtrees taken out by the set operations, chained through the
+     * parent links of their roots. They are destroyed once the recursion is
+     * done, since the node pool is not thread safe
+     */
+    struct Discarded {
+      Node* first{nullptr};
+      Node* last{nullptr};
+    };
+
+    /**
+     * @brief Amount of searches find_batch keeps in flight
+     */
+    static constexpr std::size_t batch_group{16};
+
+    /**
+     * @brief Size in bytes under which the nodes are assumed to stay in the
+     * cache, where find_batch just runs one search after the other
+     */
+    static constexpr std::size_t batch_cache_bytes{1 << 20};
+
+    /**
+     * @brief Interleaved search of many keys (see find_batch)
+     * @param first The start of the keys
+     * @param last The end of the keys
+     * @param found Called with the position of every key and its node
+     * (nullptr if it is not in the map), in no particular order
+     */
+    template<typename RandomIt, typename Visitor>
+    auto search_batch(RandomIt first, RandomIt last, Visitor found) const
+      -> void;
+
+    /**
+     * @brief Links a new node at the place found by search_insert and
+     * rebalances the tree
+     * @param node The node to link
+     * @param search The place for the node
+     */
+    auto link_node(Node* node, const InsertSearch& search) -> void;
+
+    /**
+     * @brief Unlinks a node from the tree and rebalances it. The node is left
+     * as a leaf with no parent, ready to be destroyed or linked again
+     * @param node The node to unlink
+     */
+    auto unlink_node(Node* node) -> void;
+
+    /**
+     * @brief Shared implementation of both try_emplace overloads
+     * @param key The key to insert
+     * @param args The arguments to construct the value from
+     * @return Iterator to the node with the key and whether it was inserted
+     */
+    template<typename KeyArg, typename... Args>
+    auto try_emplace_impl(KeyArg&& key, Args&&... args)
+      -> std::pair<iterator, bool>;
+
+    /**
+     * @brief Walks up from a node whose subtree changed, updating heights and
+     * rotating where needed. It stops as soon as a subtree keeps the height it
+     * had before the update.
+     * @param node The lowest node whose children changed
+     */
+    auto retrace(Node* node) -> void;
+
+    /**
+     * @brief Copies a subtree node by node, keeping its shape, heights and
+     * balances. No key is compared and no rotation is done.
+     * @param source The root of the subtree to copy
+     * @param parent The parent of the copy
+     * @return The root of the copy
+     */
+    auto clone(const Node* source, Node* parent) -> Node*;
+
+    /**
+     * @brief Links the pairs of a sorted range of unique keys into a perfectly
+     * balanced subtree, setting the heights and balances directly.
+     * @param first The start of the range
+     * @param last The end of the range
+     * @param parent The parent of the subtree
+     * @return The root of the subtree
+     */
+    template<typename RandomIt>
+    auto build(RandomIt first, RandomIt last, Node* parent) -> Node*;
+
+    /**
+     * @brief Relinks a sorted run of existing nodes into a perfectly balanced
+     * subtree (build without creating the nodes).
+     * @param first The start of the nodes
+     * @param last The end of the nodes
+     * @param parent The parent of the subtree
+     * @return The root of the subtree
+     */
+    auto relink_balanced(Node** first, Node** last, Node* parent) -> Node*;
+
+    /**
+     * @brief Merges a sorted forward range into the tree and relinks every
+     * node at once (see insert_sorted_batch)
+     * @param first The start of the range
+     * @param last The end of the range
+     * @param count The length of the range
+     * @return The amount of keys that were not in the map
+     */
+    template<typename ForwardIt>
+    auto merge_sorted_batch(ForwardIt first, ForwardIt last, std::size_t count)
+      -> std::size_t;
+
+    /**
+     * @brief Search for the first node whose key is not less than a key
+     * @param key The key to search for
+     * @return The node (nullptr if every key is less than the given one)
+     */
+    template<typename KeyLike>
+    auto lower_bound_node(const KeyLike& key) const -> Node*;
+
+    /**
+     * @brief Search for the first node whose key is greater than a key
+     * @param key The key to search for
+     * @return The node (nullptr if no key is greater than the given one)
+     */
+    template<typename KeyLike>
+    auto upper_bound_node(const KeyLike& key) const -> Node*;
+
+    /**
+     * @brief Adds to the subtree sizes of a node and all of its ancestors.
+     * Does nothing when order statistics are disabled.
+     * @param node The lowest node whose subtree changed
+     * @param delta The amount of nodes added (negative for removed)
+     */
+    auto adjust_sizes(Node* node, int delta) -> void;
+
+    /**
+     * @brief Delete the whole tree without allocating, giving the slabs of the
+     * pool back at once
      */
     auto clear() -> void;
 
+    /**
+     * @brief Copies the contents in key order into a read only snapshot
+     * @param Snapshot The snapshot type (built from the keys and values)
+     * @return The snapshot
+     */
+    template<typename Snapshot>
+    auto snapshot() const -> Snapshot;
+
+    /**
+     * @brief Destroys every node of a detached subtree
+     * @param node The root of the subtree (can be nullptr)
+     * @return The amount of nodes destroyed
+     */
+    auto destroy_subtree(Node* node) -> unsigned int;
+
+    /**
+     * @brief Counts the nodes of a subtree (reads the subtree size when order
+     * statistics are enabled)
+     * @param node The root of the subtree (can be nullptr)
+     * @return The amount of nodes
+     */
+    static auto subtree_count(Node* node) -> unsigned int;
+
+    /**
+     * @brief Getter for the height of a subtree
+     * @param node The root of the subtree (can be nullptr)
+     * @return The height
+     */
+    static auto height_of(const Node* node) -> int;
+
+    /**
+     * @brief Walks up from a node of a detached subtree to its root updating
+     * heights and sizes and rotating where needed
+     * @param node The lowest node whose subtree changed
+     * @return The root of the subtree after the rotations
+     */
+    static auto rebalance_up(Node* node) -> Node*;
+
+    /**
+     * @brief Links two detached subtrees under a middle node. The middle node
+     * goes down the spine of the taller subtree to the height of the other
+     * one, so the cost is the difference of their heights
+     * @param lower The subtree with the smaller keys (can be nullptr)
+     * @param middle The node with a key between the two subtrees
+     * @param upper The subtree with the greater keys (can be nullptr)
+     * @return The root of the joined subtree
+     */
+    static auto join_nodes(Node* lower, Node* middle, Node* upper) -> Node*;
+
+    /**
+     * @brief Links two detached subtrees, taking the last node of lower as the
+     * middle node of join_nodes
+     * @param lower The subtree with the smaller keys (can be nullptr)
+     * @param upper The subtree with the greater keys (can be nullptr)
+     * @return The root of the joined subtree
+     */
+    static auto join_pair(Node* lower, Node* upper) -> Node*;
+
+    /**
+     * @brief Splits a detached subtree around a key
+     * @param node The root of the subtree (can be nullptr)
+     * @param key Where to split
+     * @param lower Gets the subtree with the keys less than key
+     * @param upper Gets the subtree with the keys greater than key
+     * @return The node with the key, unlinked (nullptr if there is none)
+     */
+    auto split_node(Node* node, const K& key, Node*& lower, Node*& upper) const
+      -> Node*;
+
+    /**
+     * @brief Splits a detached subtree into the keys less than a key and the
+     * keys not less than it
+     * @param node The root of the subtree (can be nullptr)
+     * @param key Where to split
+     * @param lower Gets the subtree with the keys less than key
+     * @param upper Gets the subtree with the rest
+     */
+    auto split_before(Node* node, const K& key, Node*& lower, Node*& upper)
+      const -> void;
+
+    /**
+     * @brief Inserts a sorted run of pairs into a detached subtree. The run
+     * is divided around the key of the root, each child takes the part on its
+     * side, and the root is joined back with them (so only the nodes on the
+     * paths to the keys are rebalanced, once each). Under an empty place the
+     * middle key of the run makes the new root
+     * @param tree The root of the subtree (can be nullptr), gets the new root.
+     * It holds a valid subtree even if a key or value throws
+     * @param first The start of the run
+     * @param last The end of the run
+     * @param inserted Incremented for every key that was not in the subtree
+     */
+    template<typename RandomIt>
+    auto insert_run(
+      Node*& tree,
+      RandomIt first,
+      RandomIt last,
+      std::size_t& inserted
+    ) -> void;
+
+    /**
+     * @brief Shared implementation of the copying union_with overloads
+     * @param other The map to take the keys from
+     * @param workers The pool to run the tasks on (nullptr for sequential)
+     */
+    auto union_impl(const AVLmap& other, ForkJoinPool* workers) -> void;
+
+    /**
+     * @brief Shared implementation of the moving union_with overloads
+     * @param other The map to take the keys from (left empty)
+     * @param workers The pool to run the tasks on (nullptr for sequential)
+     */
+    auto union_impl(AVLmap&& other, ForkJoinPool* workers) -> void;
+
+    /**
+     * @brief Shared implementation of both intersect_with overloads
+     * @param other The map with the keys to keep
+     * @param workers The pool to run the tasks on (nullptr for sequential)
+     */
+    auto intersect_impl(const AVLmap& other, ForkJoinPool* workers) -> void;
+
+    /**
+     * @brief Shared implementation of both difference_with overloads
+     * @param other The map with the keys to erase
+     * @param workers The pool to run the tasks on (nullptr for sequential)
+     */
+    auto difference_impl(const AVLmap& other, ForkJoinPool* workers) -> void;
+
+    /**
+     * @brief Adds a detached subtree to a list of discarded ones
+     * @param list The list
+     * @param subtree The root of the subtree
+     */
+    static auto discard(Discarded& list, Node* subtree) -> void;
+
+    /**
+     * @brief Moves the subtrees of a list to the end of another one
+     * @param list The list to add to
+     * @param more The list to take the subtrees from
+     */
+    static auto discard(Discarded& list, const Discarded& more) -> void;
+
+    /**
+     * @brief Destroys every subtree of a list of discarded ones
+     * @param list The list
+     * @return The amount of nodes destroyed
+     */
+    auto destroy_discarded(const Discarded& list) -> unsigned int;
+
+    /**
+     * @brief Runs the recursion of a set operation into both halves, as two
+     * tasks if there is a pool. The upper half discards into its own list
+     * which is appended afterwards, so the order of the lists does not matter
+     * @param workers The pool to run the tasks on (nullptr for sequential)
+     * @param discarded The list the lower half discards into
+     * @param lower Recursion into the lower half (takes its list)
+     * @param upper Recursion into the upper half (takes its list)
+     */
+    template<typename Lower, typename Upper>
+    static auto both_halves(
+      ForkJoinPool* workers,
+      Discarded& discarded,
+      Lower lower,
+      Upper upper
+    ) -> void;
+
+    /**
+     * @brief Whether a step of a set operation is worth splitting in tasks
+     * @param workers The pool to run the tasks on (can be nullptr)
+     * @param mine The subtree of this map
+     * @param theirs The subtree of the other map
+     * @return The pool if both subtrees are tall enough, nullptr otherwise
+     */
+    static auto fork_pool(
+      ForkJoinPool* workers,
+      const Node* mine,
+      const Node* theirs
+    ) -> ForkJoinPool*;
+
+    /**
+     * @brief Union of two detached subtrees of this pool (see union_with)
+     * @param mine The subtree whose values win
+     * @param theirs The subtree whose repeated keys are discarded
+     * @param discarded Where the nodes to destroy go
+     * @param workers The pool to run the tasks on (nullptr for sequential)
+     * @return The root of the union
+     */
+    auto union_nodes(
+      Node* mine,
+      Node* theirs,
+      Discarded& discarded,
+      ForkJoinPool* workers
+    ) const -> Node*;
+
+    /**
+     * @brief Intersection of a detached subtree with a subtree of any map
+     * (see intersect_with)
+     * @param mine The subtree to erase from
+     * @param theirs The subtree with the keys to keep
+     * @param discarded Where the nodes to destroy go
+     * @param workers The pool to run the tasks on (nullptr for sequential)
+     * @return The root of the intersection
+     */
+    auto intersect_nodes(
+      Node* mine,
+      const Node* theirs,
+      Discarded& discarded,
+      ForkJoinPool* workers
+    ) const -> Node*;
+
+    /**
+     * @brief Difference of a detached subtree with a subtree of any map (see
+     * difference_with)
+     * @param mine The subtree to erase from
+     * @param theirs The subtree with the keys to erase
+     * @param discarded Where the nodes to destroy go
+     * @param workers The pool to run the tasks on (nullptr for sequential)
+     * @return The root of the difference
+     */
+    auto difference_nodes(
+      Node* mine,
+      const Node* theirs,
+      Discarded& discarded,
+      ForkJoinPool* workers
+    ) const -> Node*;
+
+    /**
+     * @brief build over nodes that were allocated up front, constructing and
+     * linking the two halves as tasks of the pool
+     * @param first The start of the range
+     * @param memory The memory for the nodes, one per element of the range
+     * @param count The length of the range
+     * @param parent The parent of the subtree
+     * @param workers The pool to run the tasks on (nullptr for sequential)
+     * @return The root of the subtree
+     */
+    template<typename RandomIt>
+    auto build_parallel(
+      RandomIt first,
+      Node** memory,
+      std::size_t count,
+      Node* parent,
+      ForkJoinPool* workers
+    ) -> Node*;
+
+    /**
+     * @brief The comparator used to order the keys
+     */
+    Compare comp{};
+
+    /**
+     * @brief The pool the nodes are allocated from
+     */
+    node_pool pool{};
+
     /**
      * @brief The root of the AVL
      */
@@ -557,6 +1716,11 @@ namespace CS280 {
      * @brief The amount of elements in the AVL
      */
     unsigned int size_{0};
+
+    /**
+     * @brief The counters of the retraces done on this tree
+     */
+    RebalanceStats stats_{};
   };
 
   /**
@@ -565,9 +1729,15 @@ namespace CS280 {
    * @param map The map to print
    * @return The stream that was used to print
    */
-  template<typename KEY_TYPE, typename VALUE_TYPE>
-  auto operator<<(std::ostream& os, const AVLmap<KEY_TYPE, VALUE_TYPE>& map)
-    -> std::ostream&;
+  template<
+    typename KEY_TYPE,
+    typename VALUE_TYPE,
+    typename COMPARE_TYPE,
+    template<typename> class POOL_TYPE>
+  auto operator<<(
+    std::ostream& os,
+    const AVLmap<KEY_TYPE, VALUE_TYPE, COMPARE_TYPE, POOL_TYPE>& map
+  ) -> std::ostream&;
 } // namespace CS280
 
   #ifndef AVL_CPP
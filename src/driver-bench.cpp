@@ -0,0 +1,1282 @@
+#include <random>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <numeric> // iota
+
+#include "avl-map.h"
+#include "avl-map-block.h"
+#include "avl-map-compact.h"
+#include "avl-map-concurrent.h"
+#include "avl-map-lockfree.h"
+#include "avl-map-parentless.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+// sizes used by the scaling benchmarks, capped by the optional second argument
+std::vector<std::size_t> bench_sizes{
+  1'000,
+  10'000,
+  100'000,
+  1'000'000,
+  10'000'000
+};
+
+std::vector<int> shuffled_keys(std::size_t n) {
+  std::vector<int> data(n);
+  std::iota(data.begin(), data.end(), 1);
+  std::shuffle(data.begin(), data.end(), std::mt19937{280});
+  return data;
+}
+
+double elapsed_ns(bench_clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(bench_clock::now() - start)
+    .count();
+}
+
+// resident set size of the process (0 where /proc is not available)
+double resident_mb() {
+  std::ifstream statm("/proc/self/statm");
+  std::size_t pages = 0;
+  std::size_t resident = 0;
+  if (!(statm >> pages >> resident)) {
+    return 0;
+  }
+  return resident * 4096.0 / (1024 * 1024);
+}
+
+// random inserts - cost per insert should grow with log n, not with n
+void bench0() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  std::printf("%12s %14s %18s\n", "keys", "ns/insert", "ns/insert/log2(n)");
+
+  for (std::size_t n: bench_sizes) {
+    std::vector<int> data = shuffled_keys(n);
+    CS280::AVLmap<int, int> map;
+
+    bench_clock::time_point start = bench_clock::now();
+    for (const int& key: data) {
+      map[key] = key;
+    }
+    double per_insert = elapsed_ns(start) / n;
+
+    std::printf(
+      "%12zu %14.1f %18.2f\n",
+      n,
+      per_insert,
+      per_insert / std::log2(static_cast<double>(n))
+    );
+  }
+}
+
+// retrace work per update - should stay constant as the tree grows
+void bench1() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  std::printf(
+    "%12s %10s %16s %16s\n",
+    "keys",
+    "update",
+    "retrace/update",
+    "rotations/update"
+  );
+
+  for (std::size_t n: bench_sizes) {
+    std::vector<int> data = shuffled_keys(n);
+    CS280::AVLmap<int, int> map;
+
+    for (const int& key: data) {
+      map[key] = key;
+    }
+
+    CS280::AVLmap<int, int>::RebalanceStats stats = map.rebalance_stats();
+    std::printf(
+      "%12zu %10s %16.2f %16.2f\n",
+      n,
+      "insert",
+      static_cast<double>(stats.retrace_length) / stats.operations,
+      static_cast<double>(stats.rotations) / stats.operations
+    );
+
+    map.reset_rebalance_stats();
+    std::shuffle(data.begin(), data.end(), std::mt19937{281});
+    for (const int& key: data) {
+      map.erase(map.find(key));
+    }
+
+    stats = map.rebalance_stats();
+    std::printf(
+      "%12zu %10s %16.2f %16.2f\n",
+      n,
+      "erase",
+      static_cast<double>(stats.retrace_length) / stats.operations,
+      static_cast<double>(stats.rotations) / stats.operations
+    );
+  }
+}
+
+// insert/erase churn on a map of n keys, then a full clear
+template<template<typename> class Pool>
+void churn(const char* name, std::size_t n) {
+  std::vector<int> data = shuffled_keys(2 * n);
+  CS280::AVLmap<int, int, std::less<int>, Pool> map;
+
+  bench_clock::time_point start = bench_clock::now();
+  for (std::size_t i = 0; i < n; ++i) {
+    map[data[i]] = data[i];
+  }
+  for (std::size_t i = n; i < 2 * n; ++i) {
+    map.erase(map.find(data[i - n]));
+    map[data[i]] = data[i];
+  }
+  double per_update = elapsed_ns(start) / (3 * n);
+
+  CS280::PoolStats stats = map.pool_stats();
+
+  start = bench_clock::now();
+  map = CS280::AVLmap<int, int, std::less<int>, Pool>();
+  double clear_ms = elapsed_ns(start) / 1e6;
+
+  std::printf(
+    "%12zu %10s %12.1f %10.2f %12zu %10zu %8zu\n",
+    n,
+    name,
+    per_update,
+    clear_ms,
+    stats.allocations,
+    stats.reused,
+    stats.bytes_per_node
+  );
+}
+
+// node allocation policies under churn
+void bench2() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  std::printf(
+    "%12s %10s %12s %10s %12s %10s %8s\n",
+    "keys",
+    "pool",
+    "ns/update",
+    "clear ms",
+    "allocations",
+    "reused",
+    "bytes"
+  );
+
+  for (std::size_t n: bench_sizes) {
+    churn<CS280::HeapPool>("heap", n);
+    churn<CS280::NodePool>("slab", n);
+  }
+}
+
+// the copy as it was done before the structural clone: a BFS over the source
+// feeding every pair through operator[]
+CS280::AVLmap<int, int> copy_by_insertion(const CS280::AVLmap<int, int>& map) {
+  CS280::AVLmap<int, int> copy;
+  std::vector<int> keys;
+  std::list<std::pair<int, int>> insert_list;
+
+  // the public interface has no child access, so the BFS order is recovered
+  // by bisecting the sorted keys the same way a balanced tree would
+  for (CS280::AVLmap<int, int>::const_iterator it = map.begin();
+       it != map.end();
+       ++it) {
+    keys.push_back(it->Key());
+  }
+
+  insert_list.push_back({0, static_cast<int>(keys.size())});
+  while (!insert_list.empty()) {
+    std::pair<int, int> range = insert_list.front();
+    insert_list.pop_front();
+
+    if (range.first >= range.second) {
+      continue;
+    }
+
+    int middle = range.first + (range.second - range.first) / 2;
+    copy[keys[middle]] = keys[middle];
+    insert_list.push_back({range.first, middle});
+    insert_list.push_back({middle + 1, range.second});
+  }
+
+  return copy;
+}
+
+// copy constructor against copying by insertion
+void bench3() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  std::printf(
+    "%12s %16s %16s %10s\n",
+    "keys",
+    "insert ms",
+    "clone ms",
+    "speedup"
+  );
+
+  for (std::size_t n: bench_sizes) {
+    std::vector<int> data = shuffled_keys(n);
+    CS280::AVLmap<int, int> map;
+    for (const int& key: data) {
+      map[key] = key;
+    }
+
+    bench_clock::time_point start = bench_clock::now();
+    CS280::AVLmap<int, int> inserted = copy_by_insertion(map);
+    double insert_ms = elapsed_ns(start) / 1e6;
+
+    start = bench_clock::now();
+    CS280::AVLmap<int, int> cloned(map);
+    double clone_ms = elapsed_ns(start) / 1e6;
+
+    std::printf(
+      "%12zu %16.2f %16.2f %9.1fx\n",
+      n,
+      insert_ms,
+      clone_ms,
+      insert_ms / clone_ms
+    );
+  }
+}
+
+// loading sorted pairs through operator[] against the bulk constructor
+void bench4() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  std::printf(
+    "%12s %16s %16s %10s\n",
+    "keys",
+    "operator[] ms",
+    "bulk ms",
+    "speedup"
+  );
+
+  for (std::size_t n: bench_sizes) {
+    std::vector<std::pair<int, int>> data(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      data[i] = {static_cast<int>(i), static_cast<int>(i)};
+    }
+
+    bench_clock::time_point start = bench_clock::now();
+    {
+      CS280::AVLmap<int, int> map;
+      for (const std::pair<int, int>& pair: data) {
+        map[pair.first] = pair.second;
+      }
+    }
+    double insert_ms = elapsed_ns(start) / 1e6;
+
+    start = bench_clock::now();
+    { CS280::AVLmap<int, int> map(data.begin(), data.end()); }
+    double bulk_ms = elapsed_ns(start) / 1e6;
+
+    std::printf(
+      "%12zu %16.2f %16.2f %9.1fx\n",
+      n,
+      insert_ms,
+      bulk_ms,
+      insert_ms / bulk_ms
+    );
+  }
+}
+
+// time to destroy a map of n random keys
+template<typename V, template<typename> class Pool>
+void destroy(const char* name, std::size_t n) {
+  std::vector<int> data = shuffled_keys(n);
+  typedef CS280::AVLmap<int, V, std::less<int>, Pool> map_type;
+  map_type* map = new map_type;
+  for (const int& key: data) {
+    (*map)[key] = V();
+  }
+
+  bench_clock::time_point start = bench_clock::now();
+  delete map;
+  double destroy_ms = elapsed_ns(start) / 1e6;
+
+  std::printf("%12zu %16s %12.2f\n", n, name, destroy_ms);
+}
+
+// destruction of large maps
+void bench5() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  std::printf("%12s %16s %12s\n", "keys", "map", "destroy ms");
+
+  for (std::size_t n: bench_sizes) {
+    if (n < 1'000'000) {
+      continue;
+    }
+
+    destroy<int, CS280::HeapPool>("<int,int> heap", n);
+    destroy<int, CS280::NodePool>("<int,int> slab", n);
+    destroy<std::string, CS280::HeapPool>("<int,str> heap", n);
+    destroy<std::string, CS280::NodePool>("<int,str> slab", n);
+  }
+}
+
+// moving entries to a new key: erase and insert against extract and insert
+void bench6() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  std::printf(
+    "%12s %16s %16s %10s\n",
+    "keys",
+    "erase ns/move",
+    "extract ns/move",
+    "speedup"
+  );
+
+  for (std::size_t n: bench_sizes) {
+    std::vector<int> data = shuffled_keys(n);
+    typedef CS280::AVLmap<int, std::string> map_type;
+    map_type erased;
+    map_type extracted;
+    for (const int& key: data) {
+      erased.try_emplace(key, 32, 'v');
+      extracted.try_emplace(key, 32, 'v');
+    }
+
+    int offset = static_cast<int>(n);
+
+    bench_clock::time_point start = bench_clock::now();
+    for (const int& key: data) {
+      map_type::iterator it = erased.find(key);
+      std::string value = it->Value();
+      erased.erase(it);
+      erased[key + offset] = value;
+    }
+    double erase_ns = elapsed_ns(start) / n;
+
+    start = bench_clock::now();
+    for (const int& key: data) {
+      map_type::node_type node = extracted.extract(key);
+      node.key() += offset;
+      extracted.insert(std::move(node));
+    }
+    double extract_ns = elapsed_ns(start) / n;
+
+    std::printf(
+      "%12zu %16.1f %16.1f %9.1fx\n",
+      n,
+      erase_ns,
+      extract_ns,
+      erase_ns / extract_ns
+    );
+  }
+}
+
+// builds a map of n random keys and times n random lookups on it
+template<typename Map>
+void lookups(const char* name, std::size_t n, std::size_t bytes_per_node) {
+  std::vector<int> data = shuffled_keys(n);
+  double resident = resident_mb();
+
+  Map map;
+  for (const int& key: data) {
+    map[key] = key;
+  }
+  double map_mb = resident_mb() - resident;
+
+  std::shuffle(data.begin(), data.end(), std::mt19937{282});
+  long long sum = 0;
+
+  bench_clock::time_point start = bench_clock::now();
+  for (const int& key: data) {
+    sum += map.find(key)->Value();
+  }
+  double per_find = elapsed_ns(start) / n;
+
+  std::printf(
+    "%12zu %10s %8zu %12.1f %12.1f %10lld\n",
+    n,
+    name,
+    bytes_per_node,
+    per_find,
+    map_mb,
+    sum % 1000
+  );
+}
+
+// node layouts: lookup throughput and memory
+void bench7() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  std::printf(
+    "%12s %10s %8s %12s %12s %10s\n",
+    "keys",
+    "layout",
+    "bytes",
+    "ns/find",
+    "RSS MB",
+    "checksum"
+  );
+
+  for (std::size_t n: bench_sizes) {
+    lookups<CS280::AVLmap<int, int>>(
+      "pointer",
+      n,
+      CS280::AVLmap<int, int>().pool_stats().bytes_per_node
+    );
+    lookups<CS280::AVLmap_compact<int, int>>(
+      "compact",
+      n,
+      sizeof(CS280::AVLmap_compact<int, int>::Node)
+    );
+  }
+}
+
+// random inserts, finds and erases of n keys
+template<typename Map>
+void updates(const char* name, std::size_t n) {
+  std::vector<int> data = shuffled_keys(n);
+  Map map;
+
+  bench_clock::time_point start = bench_clock::now();
+  for (const int& key: data) {
+    map[key] = key;
+  }
+  double per_insert = elapsed_ns(start) / n;
+
+  std::shuffle(data.begin(), data.end(), std::mt19937{283});
+  long long sum = 0;
+  start = bench_clock::now();
+  for (const int& key: data) {
+    sum += map.find(key)->Value();
+  }
+  double per_find = elapsed_ns(start) / n;
+
+  std::size_t bytes = map.pool_stats().bytes_per_node;
+
+  std::shuffle(data.begin(), data.end(), std::mt19937{284});
+  start = bench_clock::now();
+  for (const int& key: data) {
+    map.erase(map.find(key));
+  }
+  double per_erase = elapsed_ns(start) / n;
+
+  std::printf(
+    "%12zu %12s %8zu %10.1f %10.1f %10.1f %6lld\n",
+    n,
+    name,
+    bytes,
+    per_insert,
+    per_find,
+    per_erase,
+    sum % 10
+  );
+}
+
+// parent links against path stacks
+void bench8() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  std::printf(
+    "%12s %12s %8s %10s %10s %10s %6s\n",
+    "keys",
+    "layout",
+    "bytes",
+    "ns/insert",
+    "ns/find",
+    "ns/erase",
+    "check"
+  );
+
+  for (std::size_t n: bench_sizes) {
+    updates<CS280::AVLmap<int, int>>("parent", n);
+    updates<CS280::AVLmap_parentless<int, int>>("parentless", n);
+  }
+}
+
+// scalar find loop against find_batch
+void bench9() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  std::printf(
+    "%12s %14s %14s %10s\n",
+    "keys",
+    "find ns/key",
+    "batch ns/key",
+    "speedup"
+  );
+
+  for (std::size_t n: bench_sizes) {
+    std::vector<int> data = shuffled_keys(n);
+    CS280::AVLmap<int, int> map;
+    for (const int& key: data) {
+      map[key] = key;
+    }
+
+    // a million probes (half of them misses) whatever the size of the map
+    std::vector<int> probes(1'000'000);
+    std::mt19937 generator{285};
+    std::uniform_int_distribution<int> distribution(1, static_cast<int>(2 * n));
+    for (int& probe: probes) {
+      probe = distribution(generator);
+    }
+
+    std::vector<CS280::AVLmap<int, int>::iterator> found(probes.size());
+
+    bench_clock::time_point start = bench_clock::now();
+    for (std::size_t i = 0; i < probes.size(); ++i) {
+      found[i] = map.find(probes[i]);
+    }
+    double find_ns = elapsed_ns(start) / probes.size();
+
+    long long hits = 0;
+    for (CS280::AVLmap<int, int>::iterator& it: found) {
+      hits += it != map.end();
+    }
+
+    start = bench_clock::now();
+    map.find_batch(probes.begin(), probes.end(), found.begin());
+    double batch_ns = elapsed_ns(start) / probes.size();
+
+    for (CS280::AVLmap<int, int>::iterator& it: found) {
+      hits -= it != map.end();
+    }
+
+    std::printf(
+      "%12zu %14.1f %14.1f %9.2fx%s\n",
+      n,
+      find_ns,
+      batch_ns,
+      find_ns / batch_ns,
+      hits == 0 ? "" : " (mismatch)"
+    );
+  }
+}
+
+// sorted batches into an existing map - operator[] per key against
+// insert_sorted_batch (the batch keys are spread over the whole map)
+void bench10() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  std::printf(
+    "%12s %10s %14s %14s %10s\n",
+    "keys",
+    "batch",
+    "[] ns/key",
+    "batch ns/key",
+    "speedup"
+  );
+
+  for (std::size_t n: bench_sizes) {
+    // even keys in the map, odd keys in the batches
+    std::vector<int> data = shuffled_keys(n);
+    CS280::AVLmap<int, int> base;
+    for (const int& key: data) {
+      base[2 * key] = key;
+    }
+
+    for (std::size_t k: {1'000, 10'000, 100'000}) {
+      if (k > n) {
+        break;
+      }
+
+      std::vector<std::pair<int, int>> batch;
+      for (std::size_t i = 0; i < k; ++i) {
+        batch.emplace_back(2 * data[i] + 1, data[i]);
+      }
+      std::sort(batch.begin(), batch.end());
+
+      double index_ns = 0;
+      {
+        CS280::AVLmap<int, int> map(base);
+        bench_clock::time_point start = bench_clock::now();
+        for (const std::pair<int, int>& item: batch) {
+          map[item.first] = item.second;
+        }
+        index_ns = elapsed_ns(start) / k;
+      }
+
+      CS280::AVLmap<int, int> map(base);
+      bench_clock::time_point start = bench_clock::now();
+      map.insert_sorted_batch(batch.begin(), batch.end());
+      double batch_ns = elapsed_ns(start) / k;
+
+      std::printf(
+        "%12zu %10zu %14.1f %14.1f %9.2fx%s\n",
+        n,
+        k,
+        index_ns,
+        batch_ns,
+        index_ns / batch_ns,
+        map.size() == n + k ? "" : " (mismatch)"
+      );
+    }
+  }
+}
+
+// set operations with a smaller map - a loop of try_emplace / erase against
+// union_with / difference_with (half of the small map's keys are shared)
+void bench11() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  std::printf(
+    "%12s %10s %12s %12s %12s %12s\n",
+    "keys",
+    "other",
+    "loop union",
+    "union_with",
+    "loop diff",
+    "diff_with"
+  );
+
+  for (std::size_t n: bench_sizes) {
+    std::vector<int> data = shuffled_keys(n);
+    CS280::AVLmap<int, int> base;
+    for (const int& key: data) {
+      base[2 * key] = key;
+    }
+
+    for (std::size_t m: {1'000, 10'000, 100'000}) {
+      if (m > n) {
+        break;
+      }
+
+      // even keys are in base, odd ones are not
+      CS280::AVLmap<int, int> other;
+      for (std::size_t i = 0; i < m; ++i) {
+        other[2 * data[i] + static_cast<int>(i % 2)] = 0;
+      }
+
+      double times_ms[4] = {};
+      std::size_t sizes[4] = {};
+
+      {
+        CS280::AVLmap<int, int> map(base);
+        bench_clock::time_point start = bench_clock::now();
+        for (CS280::AVLmap<int, int>::iterator it = other.begin();
+             it != other.end();
+             ++it) {
+          map.try_emplace(it->Key(), it->Value());
+        }
+        times_ms[0] = elapsed_ns(start) / 1e6;
+        sizes[0] = map.size();
+      }
+      {
+        CS280::AVLmap<int, int> map(base);
+        bench_clock::time_point start = bench_clock::now();
+        map.union_with(other);
+        times_ms[1] = elapsed_ns(start) / 1e6;
+        sizes[1] = map.size();
+      }
+      {
+        CS280::AVLmap<int, int> map(base);
+        bench_clock::time_point start = bench_clock::now();
+        for (CS280::AVLmap<int, int>::iterator it = other.begin();
+             it != other.end();
+             ++it) {
+          CS280::AVLmap<int, int>::iterator found = map.find(it->Key());
+          if (found != map.end()) {
+            map.erase(found);
+          }
+        }
+        times_ms[2] = elapsed_ns(start) / 1e6;
+        sizes[2] = map.size();
+      }
+      {
+        CS280::AVLmap<int, int> map(base);
+        bench_clock::time_point start = bench_clock::now();
+        map.difference_with(other);
+        times_ms[3] = elapsed_ns(start) / 1e6;
+        sizes[3] = map.size();
+      }
+
+      std::printf(
+        "%12zu %10zu %10.2fms %10.2fms %10.2fms %10.2fms%s\n",
+        n,
+        m,
+        times_ms[0],
+        times_ms[1],
+        times_ms[2],
+        times_ms[3],
+        sizes[0] == sizes[1] && sizes[2] == sizes[3] ? "" : " (mismatch)"
+      );
+    }
+  }
+}
+
+// set operations and bulk build, sequential against the fork-join pool (two
+// maps of the same size sharing a third of their keys)
+void bench12() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  CS280::ForkJoinPool workers;
+  std::printf("%u worker threads\n", workers.concurrency());
+  std::printf(
+    "%12s %10s %10s %10s %10s %10s %10s\n",
+    "keys",
+    "union",
+    "par",
+    "diff",
+    "par",
+    "assign",
+    "par"
+  );
+
+  for (std::size_t n: bench_sizes) {
+    std::vector<std::pair<int, int>> items(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      items[i] = {static_cast<int>(3 * i), static_cast<int>(i)};
+    }
+
+    CS280::AVLmap<int, int> evens;
+    CS280::AVLmap<int, int> odds;
+    {
+      std::vector<std::pair<int, int>> other(n);
+      for (std::size_t i = 0; i < n; ++i) {
+        other[i] = {static_cast<int>(2 * i), 0};
+      }
+      evens.assign(items.begin(), items.end());
+      odds.assign(other.begin(), other.end());
+    }
+
+    double times_ms[6] = {};
+    std::size_t sizes[6] = {};
+
+    for (int parallel = 0; parallel < 2; ++parallel) {
+      {
+        CS280::AVLmap<int, int> map(evens);
+        bench_clock::time_point start = bench_clock::now();
+        if (parallel) {
+          map.union_with(odds, workers);
+        } else {
+          map.union_with(odds);
+        }
+        times_ms[parallel] = elapsed_ns(start) / 1e6;
+        sizes[parallel] = map.size();
+      }
+      {
+        CS280::AVLmap<int, int> map(evens);
+        bench_clock::time_point start = bench_clock::now();
+        if (parallel) {
+          map.difference_with(odds, workers);
+        } else {
+          map.difference_with(odds);
+        }
+        times_ms[2 + parallel] = elapsed_ns(start) / 1e6;
+        sizes[2 + parallel] = map.size();
+      }
+      {
+        CS280::AVLmap<int, int> map;
+        bench_clock::time_point start = bench_clock::now();
+        if (parallel) {
+          map.assign(items.begin(), items.end(), workers);
+        } else {
+          map.assign(items.begin(), items.end());
+        }
+        times_ms[4 + parallel] = elapsed_ns(start) / 1e6;
+        sizes[4 + parallel] = map.size();
+      }
+    }
+
+    std::printf(
+      "%12zu %8.1fms %8.1fms %8.1fms %8.1fms %8.1fms %8.1fms%s\n",
+      n,
+      times_ms[0],
+      times_ms[1],
+      times_ms[2],
+      times_ms[3],
+      times_ms[4],
+      times_ms[5],
+      sizes[0] == sizes[1] && sizes[2] == sizes[3] && sizes[4] == sizes[5]
+        ? ""
+        : " (mismatch)"
+    );
+  }
+}
+
+// expiring the oldest keys - find and erase per key against erase_range
+void bench13() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  std::printf(
+    "%12s %10s %14s %14s %10s\n",
+    "keys",
+    "window",
+    "erase ns/key",
+    "range ns/key",
+    "speedup"
+  );
+
+  for (std::size_t n: bench_sizes) {
+    std::vector<int> data = shuffled_keys(n);
+    CS280::AVLmap<int, int> base;
+    for (const int& key: data) {
+      base[key] = key;
+    }
+
+    for (std::size_t k: {1'000, 10'000, 100'000}) {
+      if (k > n) {
+        break;
+      }
+
+      // the keys of the window, in the middle of the map
+      int lo = static_cast<int>(n / 2);
+      int hi = lo + static_cast<int>(k);
+
+      double erase_ns = 0;
+      std::size_t erase_size = 0;
+      {
+        CS280::AVLmap<int, int> map(base);
+        bench_clock::time_point start = bench_clock::now();
+        for (int key = lo; key < hi; ++key) {
+          CS280::AVLmap<int, int>::iterator found = map.find(key);
+          if (found != map.end()) {
+            map.erase(found);
+          }
+        }
+        erase_ns = elapsed_ns(start) / k;
+        erase_size = map.size();
+      }
+
+      CS280::AVLmap<int, int> map(base);
+      bench_clock::time_point start = bench_clock::now();
+      map.erase_range(lo, hi);
+      double range_ns = elapsed_ns(start) / k;
+
+      std::printf(
+        "%12zu %10zu %14.1f %14.1f %9.2fx%s\n",
+        n,
+        k,
+        erase_ns,
+        range_ns,
+        erase_ns / range_ns,
+        map.size() == erase_size ? "" : " (mismatch)"
+      );
+    }
+  }
+}
+
+// find on the live tree against find on its frozen (van Emde Boas) snapshot
+void bench14() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  std::printf(
+    "%12s %14s %14s %10s %10s\n",
+    "keys",
+    "tree ns/key",
+    "frozen ns/key",
+    "speedup",
+    "freeze"
+  );
+
+  for (std::size_t n: bench_sizes) {
+    std::vector<int> data = shuffled_keys(n);
+    CS280::AVLmap<int, int> map;
+    for (const int& key: data) {
+      map[key] = key;
+    }
+
+    bench_clock::time_point start = bench_clock::now();
+    CS280::AVLmap_frozen<int, int> frozen = map.freeze();
+    double freeze_ms = elapsed_ns(start) / 1e6;
+
+    // a million probes (half of them misses) whatever the size of the map
+    std::vector<int> probes(1'000'000);
+    std::mt19937 generator{285};
+    std::uniform_int_distribution<int> distribution(1, static_cast<int>(2 * n));
+    for (int& probe: probes) {
+      probe = distribution(generator);
+    }
+
+    long long tree_sum = 0;
+    start = bench_clock::now();
+    for (const int& probe: probes) {
+      CS280::AVLmap<int, int>::iterator found = map.find(probe);
+      if (found != map.end()) {
+        tree_sum += found->Value();
+      }
+    }
+    double tree_ns = elapsed_ns(start) / probes.size();
+
+    long long frozen_sum = 0;
+    start = bench_clock::now();
+    for (const int& probe: probes) {
+      CS280::AVLmap_frozen<int, int>::const_iterator found =
+        frozen.find(probe);
+      if (found != frozen.end()) {
+        frozen_sum += found->Value();
+      }
+    }
+    double frozen_ns = elapsed_ns(start) / probes.size();
+
+    std::printf(
+      "%12zu %14.1f %14.1f %9.2fx %8.1fms%s\n",
+      n,
+      tree_ns,
+      frozen_ns,
+      tree_ns / frozen_ns,
+      freeze_ms,
+      tree_sum == frozen_sum ? "" : " (mismatch)"
+    );
+  }
+}
+
+// a million random probes (half of them misses) on the live tree, on its
+// Eytzinger snapshot one key at a time and on the snapshot in batches
+template<typename K, typename V>
+void eytzinger_lookups(const char* name, std::size_t n) {
+  std::mt19937_64 generator{281};
+  std::vector<K> data(n);
+  for (K& key: data) {
+    key = static_cast<K>(generator() & ~K{1});
+  }
+
+  CS280::AVLmap<K, V> map;
+  for (const K& key: data) {
+    map[key] = static_cast<V>(key);
+  }
+  CS280::AVLmap_eytzinger<K, V> snapshot = map.export_eytzinger();
+
+  std::vector<K> probes(1'000'000);
+  std::uniform_int_distribution<std::size_t> pick(0, n - 1);
+  for (K& probe: probes) {
+    probe = data[pick(generator)] | static_cast<K>(generator() & 1);
+  }
+
+  std::size_t tree_hits = 0;
+  bench_clock::time_point start = bench_clock::now();
+  for (const K& probe: probes) {
+    tree_hits += map.find(probe) != map.end();
+  }
+  double tree_ns = elapsed_ns(start) / probes.size();
+
+  std::size_t find_hits = 0;
+  start = bench_clock::now();
+  for (const K& probe: probes) {
+    find_hits += snapshot.find(probe) != snapshot.end();
+  }
+  double find_ns = elapsed_ns(start) / probes.size();
+
+  std::vector<typename CS280::AVLmap_eytzinger<K, V>::const_iterator> found(
+    probes.size(),
+    snapshot.end()
+  );
+  start = bench_clock::now();
+  snapshot.find_batch(probes.begin(), probes.end(), found.begin());
+  double batch_ns = elapsed_ns(start) / probes.size();
+
+  std::size_t batch_hits = 0;
+  for (const auto& it: found) {
+    batch_hits += it != snapshot.end();
+  }
+
+  std::printf(
+    "%-10s %12zu %12.1f %12.1f %12.1f %8.2fx %8.2fx%s\n",
+    name,
+    n,
+    tree_ns,
+    find_ns,
+    batch_ns,
+    tree_ns / find_ns,
+    tree_ns / batch_ns,
+    tree_hits == find_hits && tree_hits == batch_hits ? "" : " (mismatch)"
+  );
+}
+
+// find on the live tree against the Eytzinger snapshot
+void bench15() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  std::printf(
+    "%-10s %12s %12s %12s %12s %9s %9s\n",
+    "keys",
+    "size",
+    "tree ns",
+    "find ns",
+    "batch ns",
+    "find",
+    "batch"
+  );
+  std::printf(
+    "(batch with AVX2: %s)\n",
+    CS280::AVLmap_eytzinger<int, int>::uses_avx2() ? "yes" : "no"
+  );
+
+  for (std::size_t n: bench_sizes) {
+    eytzinger_lookups<int, int>("int", n);
+    eytzinger_lookups<std::uint64_t, std::uint64_t>("uint64", n);
+  }
+}
+
+// random inserts, finds and erases on plain nodes against blocks of keys
+template<typename Map>
+void block_updates(const char* name, std::size_t n) {
+  std::vector<int> data = shuffled_keys(n);
+  double resident = resident_mb();
+  Map map;
+
+  bench_clock::time_point start = bench_clock::now();
+  for (const int& key: data) {
+    map[key] = key;
+  }
+  double per_insert = elapsed_ns(start) / n;
+  double map_mb = resident_mb() - resident;
+
+  std::shuffle(data.begin(), data.end(), std::mt19937{283});
+  long long sum = 0;
+  start = bench_clock::now();
+  for (const int& key: data) {
+    sum += map.find(key)->Value();
+  }
+  double per_find = elapsed_ns(start) / n;
+
+  std::shuffle(data.begin(), data.end(), std::mt19937{284});
+  start = bench_clock::now();
+  for (const int& key: data) {
+    map.erase(map.find(key));
+  }
+  double per_erase = elapsed_ns(start) / n;
+
+  std::printf(
+    "%12zu %10s %10.1f %10.1f %10.1f %10.1f %6lld\n",
+    n,
+    name,
+    per_insert,
+    per_find,
+    per_erase,
+    map_mb,
+    sum % 10
+  );
+}
+
+// one key per node against blocks of 16 keys per node
+void bench16() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  std::printf(
+    "%12s %10s %10s %10s %10s %10s %6s\n",
+    "keys",
+    "layout",
+    "ns/insert",
+    "ns/find",
+    "ns/erase",
+    "RSS MB",
+    "check"
+  );
+
+  for (std::size_t n: bench_sizes) {
+    block_updates<CS280::AVLmap<int, int>>("pointer", n);
+    block_updates<CS280::AVLmap_block<int, int>>("block", n);
+  }
+}
+
+// the usual setup: the whole map behind one mutex, reads included
+struct MutexMap {
+  std::mutex lock{};
+  CS280::AVLmap<int, int> map{};
+
+  bool contains(int key) {
+    std::lock_guard<std::mutex> guard(lock);
+    return map.find(key) != map.end();
+  }
+
+  void update(int key) {
+    std::lock_guard<std::mutex> guard(lock);
+    ++map[key];
+  }
+};
+
+struct SharedMap {
+  CS280::AVLmap_concurrent<int, int> map{};
+
+  bool contains(int key) { return map.contains(key); }
+
+  void update(int key) {
+    map.update(key, [](int& value) { ++value; });
+  }
+};
+
+struct LockFreeMap {
+  CS280::AVLmap_lockfree<int, int> map;
+
+  explicit LockFreeMap(const CS280::AVLmap<int, int>& source): map(source) {}
+
+  bool contains(int key) { return map.contains(key); }
+
+  void update(int key) {
+    map.update(key, [](int& value) { ++value; });
+  }
+};
+
+// readers and writers hammering one map for a fixed time
+template<typename Front>
+void contended(
+  const char* name,
+  Front& front,
+  std::size_t n,
+  unsigned readers,
+  unsigned writers
+) {
+  std::atomic<bool> stop{false};
+  std::atomic<unsigned long long> reads{0};
+  std::atomic<unsigned long long> writes{0};
+  std::atomic<unsigned long long> found{0};
+  std::vector<std::thread> threads;
+
+  for (unsigned t = 0; t < readers + writers; ++t) {
+    threads.emplace_back([&, t]() {
+      std::mt19937 gen{t};
+      std::uniform_int_distribution<int> pick(1, static_cast<int>(n));
+      unsigned long long done = 0;
+      unsigned long long hits = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        if (t < readers) {
+          hits += front.contains(pick(gen));
+        } else {
+          front.update(pick(gen));
+        }
+        ++done;
+      }
+      (t < readers ? reads : writes) += done;
+      found += hits;
+    });
+  }
+
+  bench_clock::time_point start = bench_clock::now();
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  stop = true;
+  for (std::thread& thread: threads) {
+    thread.join();
+  }
+  double seconds = elapsed_ns(start) / 1e9;
+
+  // every key is there, so every read has to find its key
+  std::printf(
+    "%10zu %8u %8s %12.0f %12.0f %6s",
+    n,
+    readers,
+    name,
+    reads / seconds,
+    writes / seconds,
+    found == reads ? "ok" : "lost"
+  );
+}
+
+// one mutex for everything against shared reads with batched writes
+void bench17() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  std::size_t n = std::min<std::size_t>(bench_sizes.back(), 1'000'000);
+  unsigned writers = 4;
+  std::cout << "hardware threads " << std::thread::hardware_concurrency()
+            << ", writers " << writers << "\n";
+  std::printf(
+    "%10s %8s %8s %12s %12s %6s %10s %10s %10s %10s\n",
+    "keys",
+    "readers",
+    "lock",
+    "reads/s",
+    "writes/s",
+    "check",
+    "avg batch",
+    "contended",
+    "us/r wait",
+    "us/w wait"
+  );
+
+  for (unsigned readers: {1u, 4u, 16u, 64u}) {
+    MutexMap single;
+    SharedMap shared;
+    for (const int& key: shuffled_keys(n)) {
+      single.map[key] = 0;
+      shared.map.assign(key, 0);
+    }
+
+    contended("mutex", single, n, readers, writers);
+    std::printf("\n");
+
+    contended("shared", shared, n, readers, writers);
+    CS280::LockStats stats = shared.map.stats();
+    double batches = stats.batches ? static_cast<double>(stats.batches) : 1;
+    double waiting = stats.contended_reads
+                     ? static_cast<double>(stats.contended_reads)
+                     : 1;
+    std::printf(
+      " %10.2f %10llu %10.2f %10.2f\n",
+      static_cast<double>(stats.writes) / batches,
+      static_cast<unsigned long long>(stats.contended_reads),
+      stats.read_wait_ns / waiting / 1e3,
+      stats.writes ? stats.write_wait_ns / 1e3 / stats.writes : 0.0
+    );
+  }
+}
+
+// shared locks against lock free reads, with a single writer
+void bench18() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  std::size_t n = std::min<std::size_t>(bench_sizes.back(), 1'000'000);
+  std::cout << "hardware threads " << std::thread::hardware_concurrency()
+            << ", writers 1\n";
+  std::printf(
+    "%10s %8s %8s %12s %12s %6s\n",
+    "keys",
+    "readers",
+    "lock",
+    "reads/s",
+    "writes/s",
+    "check"
+  );
+
+  CS280::AVLmap<int, int> source;
+  for (const int& key: shuffled_keys(n)) {
+    source[key] = 0;
+  }
+
+  for (unsigned readers: {1u, 4u, 16u, 64u}) {
+    SharedMap shared;
+    for (const int& key: shuffled_keys(n)) {
+      shared.map.assign(key, 0);
+    }
+    contended("shared", shared, n, readers, 1);
+    std::printf("\n");
+
+    LockFreeMap lock_free(source);
+    contended("none", lock_free, n, readers, 1);
+    std::printf("\n");
+  }
+}
+
+void (*pBenches[])(void) = {
+  bench0,
+  bench1,
+  bench2,
+  bench3,
+  bench4,
+  bench5,
+  bench6,
+  bench7,
+  bench8,
+  bench9,
+  bench10,
+  bench11,
+  bench12,
+  bench13,
+  bench14,
+  bench15,
+  bench16,
+  bench17,
+  bench18
+};
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    return 1;
+  }
+
+  int bench = 0;
+  std::sscanf(argv[1], "%i", &bench);
+
+  if (argc > 2) {
+    std::size_t max_size = 0;
+    std::sscanf(argv[2], "%zu", &max_size);
+    bench_sizes.erase(
+      std::remove_if(
+        bench_sizes.begin(),
+        bench_sizes.end(),
+        [max_size](std::size_t n) { return n > max_size; }
+      ),
+      bench_sizes.end()
+    );
+  }
+
+  pBenches[bench]();
+  return 0;
+}
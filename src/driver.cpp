@@ -1,10 +1,21 @@
 #include <random>
 #include <algorithm>
+#include <atomic>
 #include <iterator> // stream iterator
 #include <numeric>  // iota
 
 #include "avl-map.h"
+#include "avl-map-block.h"
+#include "avl-map-compact.h"
+#include "avl-map-concurrent.h"
+#include "avl-map-lockfree.h"
+#include "avl-map-parentless.h"
 #include <iostream>
+#include <list>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 #include <cstdlib>
 
@@ -643,6 +654,1128 @@ void test17() {
   inserts_delete_random(20000, 100, 20, 200, 0.5, false);
 }
 
+// bulk construction from sorted and unsorted ranges
+// the sorted build should be perfectly balanced
+void test18() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  std::vector<std::pair<int, int>> data;
+  for (int i = 1; i <= 12; ++i) {
+    data.push_back({i, i * 10});
+  }
+
+  CS280::AVLmap<int, int> map(data.begin(), data.end());
+  std::cout << map << std::endl;
+
+  // unsorted with repeated keys, last value wins
+  std::vector<std::pair<int, int>> data2{
+    {7, 1},
+    {3, 2},
+    {9, 3},
+    {3, 4},
+    {1, 5},
+    {7, 6}
+  };
+  map.assign(data2.begin(), data2.end());
+  map.print(std::cout, true);
+  std::cout << "size " << map.size() << std::endl;
+}
+
+// bounds and ranges
+void test19() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  CS280::AVLmap<int, int> map;
+  for (int i = 0; i < 20; i += 2) {
+    map[i] = i * i;
+  }
+
+  for (int key: {-1, 0, 5, 10, 18, 19}) {
+    CS280::AVLmap<int, int>::iterator lower = map.lower_bound(key);
+    CS280::AVLmap<int, int>::iterator upper = map.upper_bound(key);
+    std::cout << key << ": lower ";
+    if (lower == map.end()) {
+      std::cout << "end";
+    } else {
+      std::cout << lower->Key();
+    }
+    std::cout << " upper ";
+    if (upper == map.end()) {
+      std::cout << "end";
+    } else {
+      std::cout << upper->Key();
+    }
+    std::cout << std::endl;
+  }
+
+  // window [5, 13) through a const map
+  const CS280::AVLmap<int, int>& cmap = map;
+  CS280::AVLmap<int, int>::const_iterator it = cmap.lower_bound(5);
+  CS280::AVLmap<int, int>::const_iterator it_e = cmap.lower_bound(13);
+  for (; it != it_e; ++it) {
+    std::cout << it->Key() << " -> " << it->Value() << std::endl;
+  }
+
+  std::pair<
+    CS280::AVLmap<int, int>::const_iterator,
+    CS280::AVLmap<int, int>::const_iterator>
+    range = cmap.equal_range(8);
+  int count = 0;
+  for (; range.first != range.second; ++range.first) {
+    ++count;
+  }
+  std::cout << "equal_range(8) holds " << count << std::endl;
+
+  range = cmap.equal_range(9);
+  std::cout << "equal_range(9) is empty "
+            << (range.first == range.second ? "yes" : "no") << std::endl;
+}
+
+// order statistics: select, rank and count_range
+void test20() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  CS280::AVLmap<int, int> map;
+  std::vector<int> data(100);
+  std::iota(data.begin(), data.end(), 1);
+  std::shuffle(data.begin(), data.end(), std::mt19937{280});
+  for (const int& key: data) {
+    map[key * 3] = key;
+  }
+
+  // erase every key that is a multiple of 5
+  for (int key = 5; key <= 100; key += 5) {
+    map.erase(map.find(key * 3));
+  }
+  std::cout << "size " << map.size() << std::endl;
+
+  for (unsigned int percentile: {0, 25, 50, 75, 99}) {
+    unsigned int k = map.size() * percentile / 100;
+    std::cout << "p" << percentile << " -> " << map.select(k)->Key()
+              << std::endl;
+  }
+  std::cout << "select(size) is end "
+            << (map.select(map.size()) == map.end() ? "yes" : "no")
+            << std::endl;
+
+  for (int key: {0, 3, 30, 31, 150, 301}) {
+    std::cout << "rank(" << key << ") = " << map.rank(key) << std::endl;
+  }
+
+  std::cout << "count_range(30, 90) = " << map.count_range(30, 90)
+            << std::endl;
+  std::cout << "count_range(90, 30) = " << map.count_range(90, 30)
+            << std::endl;
+}
+
+template<typename Map>
+void print_report(const Map& map) {
+  typename Map::SanityReport report = map.validate();
+  std::cout << report.what() << ", visited " << report.nodes_visited
+            << ", height " << report.height;
+  if (report.node != nullptr) {
+    std::cout << ", at " << report.node->Key();
+  }
+  std::cout << std::endl;
+}
+
+// orders the keys backwards while the flag it points to is set
+struct Flippable {
+  const bool* flipped;
+
+  auto operator()(int lhs, int rhs) const -> bool {
+    return *flipped ? rhs < lhs : lhs < rhs;
+  }
+};
+
+// single pass validation report
+void test21() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  CS280::AVLmap<int, int> map;
+  print_report(map);
+
+  for (int i = 1; i <= 1000; ++i) {
+    map[i] = i;
+  }
+  print_report(map);
+
+  for (int i = 1; i <= 1000; i += 2) {
+    map.erase(map.find(i));
+  }
+  print_report(map);
+
+  CS280::AVLmap<int, int> copy(map);
+  print_report(copy);
+
+  // the comparator flipped after the inserts finds the order broken
+  bool flipped = false;
+  CS280::AVLmap<int, int, Flippable> broken(Flippable{&flipped});
+  for (int i = 1; i <= 10; ++i) {
+    broken[i] = i;
+  }
+  print_report(broken);
+  flipped = true;
+  print_report(broken);
+
+  // keys inserted while it was flipped land on the wrong side
+  for (int i = 11; i <= 15; ++i) {
+    broken[i] = i;
+  }
+  flipped = false;
+  print_report(broken);
+}
+
+// custom and transparent comparators
+void test22() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  CS280::AVLmap<int, int, std::greater<int>> reversed;
+  for (int i = 1; i <= 7; ++i) {
+    reversed[i] = i;
+  }
+  std::cout << reversed << std::endl;
+  std::cout << "lower_bound(4) " << reversed.lower_bound(4)->Key()
+            << std::endl;
+
+  CS280::AVLmap<std::string, int, std::less<>> words;
+  words["delta"] = 4;
+  words["alpha"] = 1;
+  words["charlie"] = 3;
+  words["bravo"] = 2;
+
+  // no std::string is built for these lookups
+  std::cout << "find(\"charlie\") " << words.find("charlie")->Value()
+            << std::endl;
+  std::string_view view{"bravo!", 5};
+  std::cout << "find(string_view) " << words.find(view)->Value()
+            << std::endl;
+  std::cout << "find(\"echo\") is end "
+            << (words.find("echo") == words.end() ? "yes" : "no") << std::endl;
+  std::cout << "lower_bound(\"b\") " << words.lower_bound("b")->Key()
+            << std::endl;
+}
+
+// value type that counts how it was built (and has no default constructor)
+struct Tracked {
+  static int copies;
+  static int moves;
+  int id;
+
+  explicit Tracked(int i): id(i) {}
+
+  Tracked(const Tracked& rhs): id(rhs.id) {
+    copies++;
+  }
+
+  Tracked(Tracked&& rhs): id(rhs.id) {
+    moves++;
+  }
+
+  auto operator=(const Tracked& rhs) -> Tracked& {
+    id = rhs.id;
+    copies++;
+    return *this;
+  }
+
+  auto operator=(Tracked&& rhs) -> Tracked& {
+    id = rhs.id;
+    moves++;
+    return *this;
+  }
+};
+
+int Tracked::copies = 0;
+int Tracked::moves = 0;
+
+// emplace, try_emplace and insert_or_assign
+void test23() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  CS280::AVLmap<std::string, Tracked> map;
+
+  std::pair<CS280::AVLmap<std::string, Tracked>::iterator, bool> result =
+    map.try_emplace("one", 1);
+  std::cout << "try_emplace(one) " << result.first->Value().id << " "
+            << result.second << std::endl;
+  result = map.try_emplace("one", 10);
+  std::cout << "try_emplace(one) " << result.first->Value().id << " "
+            << result.second << std::endl;
+
+  result = map.emplace("two", 2);
+  std::cout << "emplace(two) " << result.first->Value().id << " "
+            << result.second << std::endl;
+  result = map.emplace("two", 20);
+  std::cout << "emplace(two) " << result.first->Value().id << " "
+            << result.second << std::endl;
+
+  result = map.insert_or_assign("three", Tracked(3));
+  std::cout << "insert_or_assign(three) " << result.first->Value().id << " "
+            << result.second << std::endl;
+  result = map.insert_or_assign("three", Tracked(30));
+  std::cout << "insert_or_assign(three) " << result.first->Value().id << " "
+            << result.second << std::endl;
+
+  std::cout << "copies " << Tracked::copies << " moves " << Tracked::moves
+            << std::endl;
+
+  for (CS280::AVLmap<std::string, Tracked>::const_iterator it = map.begin();
+       it != map.end();
+       ++it) {
+    std::cout << it->Key() << " " << it->Value().id << std::endl;
+  }
+  std::cout << "sanity " << map.sanityCheck() << std::endl;
+
+  // the key is moved into the node
+  CS280::AVLmap<std::string, std::vector<int>> lists;
+  std::string key(32, 'k');
+  lists.try_emplace(std::move(key), 3, 7);
+  std::cout << "moved key " << (key.empty() ? "yes" : "no") << ", value size "
+            << lists[std::string(32, 'k')].size() << std::endl;
+}
+
+// erasing a node with two children keeps the iterators to other nodes valid
+void test24() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  CS280::AVLmap<int, std::string> map;
+  std::vector<CS280::AVLmap<int, std::string>::iterator> its;
+  for (int i = 1; i <= 15; ++i) {
+    its.push_back(map.try_emplace(i, std::to_string(i * 10)).first);
+  }
+  std::cout << map << std::endl;
+
+  // 8 is the root and 4 and 12 have two children
+  map.erase(its[7]);
+  map.erase(its[3]);
+  map.erase(its[11]);
+  std::cout << map << std::endl;
+
+  for (std::size_t i = 0; i < its.size(); ++i) {
+    if (i == 3 || i == 7 || i == 11) {
+      continue;
+    }
+    std::cout << its[i]->Key() << ":" << its[i]->Value() << " ";
+  }
+  std::cout << std::endl << "sanity " << map.sanityCheck() << std::endl;
+}
+
+// moving nodes between maps with node handles
+void test25() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  CS280::AVLmap<int, std::string> first;
+  CS280::AVLmap<int, std::string> second(first.get_pool());
+  for (int i = 1; i <= 6; ++i) {
+    first.try_emplace(i, std::to_string(i * 10));
+  }
+  second.try_emplace(3, "thirty");
+  second.try_emplace(7, "seventy");
+
+  // re-key a node without allocating
+  std::size_t allocations = first.pool_stats().allocations;
+  CS280::AVLmap<int, std::string>::node_type node = first.extract(2);
+  node.key() = 20;
+  CS280::AVLmap<int, std::string>::insert_return_type result =
+    first.insert(std::move(node));
+  std::cout << "re-keyed " << result.position->Key() << ":"
+            << result.position->Value() << " " << result.inserted
+            << std::endl;
+
+  // a key that is already there gives the handle back
+  result = second.insert(first.extract(3));
+  std::cout << "insert 3 " << result.inserted << " " << result.node.mapped()
+            << std::endl;
+  first.insert(std::move(result.node));
+
+  second.merge(first);
+  std::cout << "allocations " << first.pool_stats().allocations - allocations
+            << std::endl;
+  std::cout << first << std::endl;
+  std::cout << second << std::endl;
+
+  // maps with their own pools move the payloads instead
+  CS280::AVLmap<int, std::string> other;
+  other.insert(second.extract(7));
+  other.merge(second);
+  std::cout << "second " << second.size() << " other " << other.size()
+            << " sanity " << other.sanityCheck() << std::endl;
+  std::cout << other << std::endl;
+}
+
+// compact layout with 32-bit links
+void test26() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  CS280::AVLmap_compact<int, int> map;
+  for (int i = 1; i <= 20; ++i) {
+    map[(i * 7) % 20] = i;
+  }
+  std::cout << "size " << map.size() << " sanity " << map.sanityCheck()
+            << std::endl;
+
+  for (int key: {0, 5, 10, 15, 19}) {
+    map.erase(map.find(key));
+  }
+  std::cout << "size " << map.size() << " sanity " << map.sanityCheck()
+            << std::endl;
+
+  for (CS280::AVLmap_compact<int, int>::const_iterator it = map.begin();
+       it != map.end();
+       ++it) {
+    std::cout << it->Key() << ":" << it->Value() << " ";
+  }
+  std::cout << std::endl;
+
+  CS280::AVLmap_compact<int, int> copy(map);
+  copy[100] = 100;
+  std::cout << "copy " << copy.size() << " original " << map.size()
+            << " sanity " << copy.sanityCheck() << std::endl;
+  std::cout << "find(7) " << map.find(7)->Value() << ", find(5) is end "
+            << (map.find(5) == map.end() ? "yes" : "no") << std::endl;
+}
+
+// map without parent links, iterators carry the path from the root
+void test27() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  CS280::AVLmap_parentless<int, int> map;
+  for (int i = 1; i <= 20; ++i) {
+    map[(i * 7) % 20] = i;
+  }
+  std::cout << "size " << map.size() << " sanity " << map.sanityCheck()
+            << std::endl;
+
+  for (int key: {0, 5, 10, 15, 19}) {
+    map.erase(map.find(key));
+  }
+  std::cout << "size " << map.size() << " sanity " << map.sanityCheck()
+            << std::endl;
+
+  for (CS280::AVLmap_parentless<int, int>::const_iterator it = map.begin();
+       it != map.end();
+       ++it) {
+    std::cout << it->Key() << ":" << it->Value() << " ";
+  }
+  std::cout << std::endl;
+
+  // walking back from end and from a found node
+  CS280::AVLmap_parentless<int, int>::iterator it = map.end();
+  std::cout << "last " << (--it)->Key();
+  it = map.find(11);
+  std::cout << ", before 11 " << (--it)->Key();
+  std::cout << ", after 11 " << (++++it)->Key() << std::endl;
+}
+
+// many lookups at once
+void test28() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  CS280::AVLmap<int, int> map;
+  for (int i = 0; i < 100; i += 3) {
+    map[i] = i * 10;
+  }
+
+  std::vector<int> keys;
+  for (int i = 0; i < 40; i += 2) {
+    keys.push_back(i);
+  }
+
+  std::vector<CS280::AVLmap<int, int>::iterator> found(keys.size());
+  map.find_batch(keys.begin(), keys.end(), found.begin());
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    std::cout << keys[i] << ":";
+    if (found[i] == map.end()) {
+      std::cout << "- ";
+    } else {
+      std::cout << found[i]->Value() << " ";
+    }
+  }
+  std::cout << std::endl;
+
+  const CS280::AVLmap<int, int>& view = map;
+  int probes[] = {99, 3, 100, -1};
+  CS280::AVLmap<int, int>::const_iterator results[4];
+  view.find_batch(probes, probes + 4, results);
+  for (CS280::AVLmap<int, int>::const_iterator& it: results) {
+    std::cout << (it == view.end() ? -1 : it->Value()) << " ";
+  }
+  std::cout << std::endl;
+}
+
+void test29() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  CS280::AVLmap<int, int> map;
+  for (int i = 0; i < 200; i += 2) {
+    map[i] = i;
+  }
+
+  // Small batch: divided along the tree, each node joined back once
+  std::vector<std::pair<int, int>> small;
+  for (int i = 51; i <= 61; i += 2) {
+    small.emplace_back(i, -i);
+  }
+  small.emplace_back(62, -62);
+  std::cout << map.insert_sorted_batch(small.begin(), small.end()) << " "
+            << map.size() << " " << map.sanityCheck() << std::endl;
+
+  // Large batch: merged with the tree and relinked
+  CS280::AVLmap<int, int>::iterator kept = map.find(100);
+  std::vector<std::pair<int, int>> large;
+  for (int i = 0; i < 300; i += 5) {
+    large.emplace_back(i, i * 10);
+  }
+  large.emplace_back(295, 1);
+  std::cout << map.insert_sorted_batch(large.begin(), large.end()) << " "
+            << map.size() << " " << map.sanityCheck() << std::endl;
+
+  std::cout << kept->Key() << ":" << kept->Value() << " ";
+  for (int key: {51, 62, 95, 96, 295}) {
+    std::cout << key << ":" << map[key] << " ";
+  }
+  std::cout << std::endl;
+
+  // Unsorted input still ends up in the map
+  std::pair<int, int> unsorted[] = {{-1, 1}, {-5, 5}, {-3, 3}};
+  std::cout << map.insert_sorted_batch(unsorted, unsorted + 3) << " "
+            << map.begin()->Key() << " " << map.sanityCheck() << std::endl;
+
+  // Repeated keys in a small batch (the last one wins), the nodes stay put
+  std::vector<std::pair<int, int>> repeated{{97, 1}, {97, 2}, {100, 3}};
+  std::cout << map.insert_sorted_batch(repeated.begin(), repeated.end())
+            << " " << map[97] << " " << kept->Key() << ":" << kept->Value()
+            << " " << map.sanityCheck() << std::endl;
+
+  // Not random access: each search starts from the previous insertion
+  std::list<std::pair<int, int>> listed{{301, 1}, {303, 3}, {303, 4}};
+  std::cout << map.insert_sorted_batch(listed.begin(), listed.end()) << " "
+            << map[303] << " " << map.size() << " " << map.sanityCheck()
+            << std::endl;
+}
+
+// split and join, and the set operations built on them
+void test30() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  auto print = [](const char* name, const CS280::AVLmap<int, int>& map) {
+    std::cout << name << ":";
+    for (CS280::AVLmap<int, int>::const_iterator it = map.begin();
+         it != map.end();
+         ++it) {
+      std::cout << " " << it->Key() << "=" << it->Value();
+    }
+    std::cout << " (sanity " << map.sanityCheck() << ")" << std::endl;
+  };
+
+  CS280::AVLmap<int, int> map;
+  for (int i = 0; i < 12; ++i) {
+    map[i] = i;
+  }
+
+  CS280::AVLmap<int, int> upper = map.split(7);
+  print("lower", map);
+  print("upper", upper);
+
+  map.join(std::move(upper));
+  print("joined", map);
+
+  CS280::AVLmap<int, int> other;
+  for (int i = 8; i < 16; i += 2) {
+    other[i] = -i;
+  }
+
+  CS280::AVLmap<int, int> with_union(map);
+  with_union.union_with(other);
+  print("union", with_union);
+
+  CS280::AVLmap<int, int> with_intersection(map);
+  with_intersection.intersect_with(other);
+  print("intersection", with_intersection);
+
+  map.difference_with(other);
+  print("difference", map);
+}
+
+// set operations and bulk build on a fork-join pool
+void test31() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  CS280::ForkJoinPool workers(4);
+
+  std::vector<std::pair<int, int>> items;
+  for (int i = 0; i < 60000; ++i) {
+    items.emplace_back(2 * i, i);
+  }
+
+  CS280::AVLmap<int, int> evens;
+  evens.assign(items.begin(), items.end(), workers);
+  std::cout << "assign " << evens.size() << " " << evens.sanityCheck()
+            << std::endl;
+
+  CS280::AVLmap<int, int> threes;
+  for (int i = 0; i < 40000; ++i) {
+    threes[3 * i] = -i;
+  }
+
+  auto summary = [](const char* name, CS280::AVLmap<int, int>& map) {
+    long long sum = 0;
+    for (CS280::AVLmap<int, int>::const_iterator it = map.begin();
+         it != map.end();
+         ++it) {
+      sum += it->Key() + it->Value();
+    }
+    std::cout << name << " " << map.size() << " " << sum << " "
+              << map.sanityCheck() << std::endl;
+  };
+
+  CS280::AVLmap<int, int> with_union(evens);
+  with_union.union_with(threes, workers);
+  summary("union", with_union);
+
+  CS280::AVLmap<int, int> with_intersection(evens);
+  with_intersection.intersect_with(threes, workers);
+  summary("intersection", with_intersection);
+
+  CS280::AVLmap<int, int> with_difference(evens);
+  with_difference.difference_with(threes, workers);
+  summary("difference", with_difference);
+
+  // the sequential versions agree
+  evens.union_with(threes);
+  summary("sequential union", evens);
+
+  // exceptions of a task come back to the caller
+  try {
+    workers.invoke(
+      []() {},
+      []() {
+        throw std::runtime_error("task failed");
+      }
+    );
+  } catch (const std::runtime_error& error) {
+    std::cout << "caught " << error.what() << std::endl;
+  }
+}
+
+// erasing whole ranges with split and join
+void test32() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  CS280::AVLmap<int, int> map;
+  for (int i = 0; i < 30; ++i) {
+    map[i] = i * i;
+  }
+
+  CS280::AVLmap<int, int>::iterator kept = map.find(25);
+  std::cout << "erased " << map.erase_range(5, 12) << std::endl;
+
+  CS280::AVLmap<int, int>::iterator next =
+    map.erase(map.find(20), map.find(24));
+  std::cout << "next " << next->Key() << ", kept " << kept->Value()
+            << std::endl;
+
+  map.erase(map.find(27), map.end());
+  std::cout << "erased " << map.erase_range(12, 5) << std::endl;
+
+  for (CS280::AVLmap<int, int>::iterator it = map.begin(); it != map.end();
+       ++it) {
+    std::cout << it->Key() << " ";
+  }
+  std::cout << "(size " << map.size() << ", sanity " << map.sanityCheck()
+            << ")" << std::endl;
+}
+
+void test33() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  CS280::AVLmap<int, int> map;
+  for (int i = 0; i < 20; ++i) {
+    map[i * 3] = i;
+  }
+
+  // The snapshot keeps the contents at the time of the freeze
+  CS280::AVLmap_frozen<int, int> frozen = map.freeze();
+  map[1] = 100;
+  map.erase_range(0, 30);
+
+  std::cout << "find 27: " << frozen.find(27)->Value()
+            << ", find 28 at end: " << (frozen.find(28) == frozen.end())
+            << ", find 1 at end: " << (frozen.find(1) == frozen.end())
+            << std::endl;
+  std::cout << "lower_bound 28: " << frozen.lower_bound(28)->Key()
+            << ", lower_bound -5: " << frozen.lower_bound(-5)->Key()
+            << ", lower_bound 58 at end: "
+            << (frozen.lower_bound(58) == frozen.end()) << std::endl;
+
+  for (CS280::AVLmap_frozen<int, int>::const_iterator it = frozen.begin();
+       it != frozen.end();
+       ++it) {
+    std::cout << it->Key() << " ";
+  }
+  std::cout << "(size " << frozen.size() << ")" << std::endl;
+
+  std::cout << "live map size " << map.size() << ", sanity "
+            << map.sanityCheck() << std::endl;
+}
+
+void test34() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  CS280::AVLmap<int, int> map;
+  for (int i = 0; i < 20; ++i) {
+    map[i * 3] = i;
+  }
+
+  CS280::AVLmap_eytzinger<int, int> snapshot = map.export_eytzinger();
+  map.erase(map.begin(), map.end());
+
+  std::cout << "find 27: " << snapshot.find(27)->Value()
+            << ", find 28 at end: " << (snapshot.find(28) == snapshot.end())
+            << ", lower_bound 28: " << snapshot.lower_bound(28)->Key()
+            << ", lower_bound 58 at end: "
+            << (snapshot.lower_bound(58) == snapshot.end()) << std::endl;
+
+  // More keys than one block of the batch search, with some left over
+  std::vector<int> keys;
+  for (int key = -2; key < 60; key += 5) {
+    keys.push_back(key);
+  }
+  std::vector<CS280::AVLmap_eytzinger<int, int>::const_iterator> found(
+    keys.size(),
+    snapshot.end()
+  );
+  snapshot.find_batch(keys.begin(), keys.end(), found.begin());
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    std::cout << keys[i] << ":";
+    if (found[i] == snapshot.end()) {
+      std::cout << "- ";
+    } else {
+      std::cout << found[i]->Value() << " ";
+    }
+  }
+  std::cout << std::endl;
+
+  for (CS280::AVLmap_eytzinger<int, int>::const_iterator it = snapshot.end();
+       it != snapshot.begin();) {
+    --it;
+    std::cout << it->Key() << " ";
+  }
+  std::cout << "(size " << snapshot.size() << ")" << std::endl;
+}
+
+// blocks of keys in the nodes (enough keys to split and merge blocks)
+void test35() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  CS280::AVLmap_block<int, int> map;
+  for (int i = 1; i <= 100; ++i) {
+    map[(i * 37) % 100] = i;
+  }
+  std::cout << "size " << map.size() << " sanity " << map.sanityCheck()
+            << std::endl;
+
+  for (int key = 0; key < 100; ++key) {
+    if (key % 10 != 3) {
+      map.erase(map.find(key));
+    }
+  }
+  std::cout << "size " << map.size() << " sanity " << map.sanityCheck()
+            << std::endl;
+
+  map.find(43)->Value() = -1;
+  for (CS280::AVLmap_block<int, int>::const_iterator it = map.begin();
+       it != map.end();
+       ++it) {
+    std::cout << it->Key() << ":" << it->Value() << " ";
+  }
+  std::cout << std::endl;
+
+  CS280::AVLmap_block<int, int> copy(map);
+  copy[-5] = 5;
+  std::cout << "copy " << copy.size() << " original " << map.size()
+            << " sanity " << copy.sanityCheck() << std::endl;
+  std::cout << "find(73) " << map.find(73)->Value() << ", find(5) is end "
+            << (map.find(5) == map.end() ? "yes" : "no") << ", last "
+            << (--copy.end())->Key() << std::endl;
+}
+
+// concurrent front end: counters bumped from many threads add up exactly
+void test36() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  CS280::AVLmap_concurrent<int, int> map;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&map, t]() {
+      for (int i = 0; i < 1000; ++i) {
+        map.update(i % 10, [](int& value) { ++value; });
+        map.find(i % 10);
+      }
+      map.assign(100 + t, t);
+      map.erase(100 + t);
+    });
+  }
+  for (std::thread& thread: threads) {
+    thread.join();
+  }
+
+  map.read([](const CS280::AVLmap_concurrent<int, int>::map_type& m) {
+    for (CS280::AVLmap<int, int>::const_iterator it = m.begin(); it != m.end();
+         ++it) {
+      std::cout << it->Key() << ":" << it->Value() << " ";
+    }
+    std::cout << std::endl;
+  });
+
+  // An exception from a write reaches the thread that asked for it
+  try {
+    map.write([](CS280::AVLmap<int, int>&) {
+      throw std::runtime_error("write failed");
+    });
+  } catch (const std::runtime_error& error) {
+    std::cout << error.what() << std::endl;
+  }
+
+  CS280::LockStats stats = map.stats();
+  std::cout << "size " << map.size() << ", writes " << stats.writes
+            << ", erase missing " << map.erase(100) << std::endl;
+}
+
+// lock free reads: readers walk whole versions while a writer rotates
+void test37() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  CS280::AVLmap<int, int> source;
+  for (int i = 0; i < 64; ++i) {
+    source[i * 2] = i;
+  }
+  CS280::AVLmap_lockfree<int, int> map(source);
+
+  std::atomic<bool> stop{false};
+  std::atomic<int> torn{0};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 3; ++t) {
+    readers.emplace_back([&map, &stop, &torn]() {
+      while (!stop.load()) {
+        int previous = -1;
+        map.for_each([&previous, &torn](const int& key, const int&) {
+          if (key <= previous) {
+            ++torn;
+          }
+          previous = key;
+        });
+        if (!map.contains(0)) {
+          ++torn;
+        }
+      }
+    });
+  }
+
+  for (int round = 0; round < 200; ++round) {
+    for (int key = 1; key < 128; key += 2) {
+      map.assign(key, round);
+    }
+    for (int key = 1; key < 128; key += 2) {
+      map.erase(key);
+    }
+  }
+  stop = true;
+  for (std::thread& reader: readers) {
+    reader.join();
+  }
+  std::cout << "torn reads " << torn << ", size " << map.size()
+            << ", sanity " << map.sanityCheck() << std::endl;
+
+  // Retired nodes are freed two epochs later, once no read can hold them
+  map.update(10, [](int& value) { value *= 100; });
+  std::cout << "find 10: " << *map.find(10) << ", erase 11: " << map.erase(11)
+            << ", retired " << (map.retired_nodes() > 0);
+  map.reclaim();
+  map.reclaim();
+  std::cout << ", after reclaim " << map.retired_nodes() << std::endl;
+}
+
+// key whose copies can be told to fail, counting the ones alive
+struct Fragile {
+  static int alive;
+  static int copies_left;
+  int id;
+
+  Fragile(): id(0) {
+    alive++;
+  }
+
+  explicit Fragile(int i): id(i) {
+    alive++;
+  }
+
+  Fragile(const Fragile& rhs): id(rhs.id) {
+    count_copy();
+    alive++;
+  }
+
+  Fragile(Fragile&& rhs) noexcept: id(rhs.id) {
+    alive++;
+  }
+
+  ~Fragile() {
+    alive--;
+  }
+
+  auto operator=(const Fragile& rhs) -> Fragile& {
+    count_copy();
+    id = rhs.id;
+    return *this;
+  }
+
+  auto operator=(Fragile&& rhs) -> Fragile& = default;
+
+  auto operator<(const Fragile& rhs) const -> bool {
+    return id < rhs.id;
+  }
+
+  // throws once copies_left reaches 0 (never while it is negative)
+  static void count_copy() {
+    if (copies_left == 0) {
+      throw std::runtime_error("copy failed");
+    }
+    if (copies_left > 0) {
+      copies_left--;
+    }
+  }
+};
+
+int Fragile::alive = 0;
+int Fragile::copies_left = -1;
+
+// copies a map of Fragile keys with the copies failing partway
+template<typename Map>
+void copy_fragile() {
+  {
+    Map source;
+    for (int i = 0; i < 100; ++i) {
+      source[Fragile(i)] = i;
+    }
+
+    Fragile::copies_left = 40;
+    try {
+      Map copy(source);
+    } catch (const std::runtime_error& error) {
+      std::cout << "copy constructor: " << error.what() << ", alive "
+                << Fragile::alive << std::endl;
+    }
+
+    Fragile::copies_left = -1;
+    Map target;
+    for (int i = 0; i < 6; ++i) {
+      target[Fragile(i * 7)] = i;
+    }
+
+    Fragile::copies_left = 40;
+    try {
+      target = source;
+    } catch (const std::runtime_error& error) {
+      std::cout << "copy assignment: " << error.what() << ", size "
+                << target.size() << ", sanity " << target.sanityCheck()
+                << ", alive " << Fragile::alive << std::endl;
+    }
+
+    Fragile::copies_left = -1;
+    target = source;
+    std::cout << "retried: size " << target.size() << ", sanity "
+              << target.sanityCheck() << ", alive " << Fragile::alive
+              << std::endl;
+  }
+  std::cout << "alive after the maps are gone " << Fragile::alive
+            << std::endl;
+}
+
+// a copy that fails partway leaves nothing behind
+void test38() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  copy_fragile<CS280::AVLmap<Fragile, int>>();
+}
+
+// a sorted assign that fails partway leaves an empty map behind
+void test39() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  {
+    std::vector<std::pair<Fragile, int>> items;
+    for (int i = 0; i < 100; ++i) {
+      items.emplace_back(Fragile(i), i);
+    }
+
+    CS280::AVLmap<Fragile, int> map;
+    map[Fragile(-1)] = -1;
+
+    Fragile::copies_left = 49;
+    try {
+      map.assign(items.begin(), items.end());
+    } catch (const std::runtime_error& error) {
+      std::cout << "assign: " << error.what() << ", size " << map.size()
+                << ", sanity " << map.sanityCheck() << ", alive "
+                << Fragile::alive << std::endl;
+    }
+
+    Fragile::copies_left = 30;
+    try {
+      CS280::AVLmap<Fragile, int> built(items.begin(), items.end());
+    } catch (const std::runtime_error& error) {
+      std::cout << "range constructor: " << error.what() << ", alive "
+                << Fragile::alive << std::endl;
+    }
+
+    Fragile::copies_left = -1;
+    map.assign(items.begin(), items.end());
+    std::cout << "retried: size " << map.size() << ", sanity "
+              << map.sanityCheck() << ", alive " << Fragile::alive
+              << std::endl;
+  }
+  std::cout << "alive after the map is gone " << Fragile::alive << std::endl;
+}
+
+// a map past the cache size makes find_batch interleave its searches
+void test40() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  CS280::AVLmap<int, int> map;
+  for (int i = 0; i < 100000; ++i) {
+    map[i * 2] = i;
+  }
+
+  // Odd keys and keys past either end miss, the count is not a multiple of
+  // the searches kept in flight
+  std::vector<int> keys(5003);
+  std::mt19937 gen{280};
+  std::uniform_int_distribution<int> pick(-1000, 201000);
+  for (int& key: keys) {
+    key = pick(gen);
+  }
+
+  std::vector<CS280::AVLmap<int, int>::iterator> found(keys.size());
+  map.find_batch(keys.begin(), keys.end(), found.begin());
+
+  int hits = 0;
+  int mismatches = 0;
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    if (found[i] != map.find(keys[i])) {
+      mismatches++;
+    }
+    if (found[i] != map.end()) {
+      hits++;
+    }
+  }
+  std::cout << "keys " << keys.size() << ", hits " << hits << ", mismatches "
+            << mismatches << std::endl;
+}
+
+void test41() {
+  // The halves of a split share their pool and grow from their own threads
+  std::cout << "-------- " << __func__ << " --------\n";
+  CS280::AVLmap<int, int> lower;
+  for (int i = 0; i < 1000; ++i) {
+    lower[i] = i;
+  }
+  CS280::AVLmap<int, int> upper = lower.split(500);
+
+  std::thread low([&lower]() {
+    for (int i = 0; i < 20000; ++i) {
+      lower[-1 - i] = i;
+      if (i % 2 == 0) {
+        lower.erase(lower.find(-1 - i));
+      }
+    }
+  });
+  std::thread high([&upper]() {
+    for (int i = 0; i < 20000; ++i) {
+      upper[1000 + i] = i;
+      if (i % 2 == 0) {
+        upper.erase(upper.find(1000 + i));
+      }
+    }
+  });
+  low.join();
+  high.join();
+
+  std::cout << "lower: size " << lower.size() << ", sanity "
+            << lower.sanityCheck() << std::endl;
+  std::cout << "upper: size " << upper.size() << ", sanity "
+            << upper.sanityCheck() << std::endl;
+
+  lower.join(std::move(upper));
+  std::cout << "joined: size " << lower.size() << ", sanity "
+            << lower.sanityCheck() << std::endl;
+}
+
+void test42() {
+  // Maps with pools of their own on the heap relink their nodes, and the
+  // counters of each pool follow the nodes it holds
+  std::cout << "-------- " << __func__ << " --------\n";
+  typedef CS280::AVLmap<int, int, std::less<int>, CS280::HeapPool> HeapMap;
+  HeapMap first;
+  HeapMap second;
+  for (int i = 0; i < 10; ++i) {
+    first[i] = i;
+    second[i + 5] = i;
+  }
+
+  std::size_t allocations =
+    first.pool_stats().allocations + second.pool_stats().allocations;
+  auto report = [&](const char* step) {
+    std::cout << step << ": sizes " << first.size() << " " << second.size()
+              << ", held " << first.pool_stats().capacity << " "
+              << second.pool_stats().capacity << ", allocations "
+              << first.pool_stats().allocations
+                   + second.pool_stats().allocations - allocations
+              << std::endl;
+  };
+
+  first.insert(second.extract(14));
+  report("insert");
+  second.merge(first);
+  report("merge");
+
+  HeapMap upper = second.split(10);
+  first.join(std::move(upper));
+  report("join");
+  first.union_with(std::move(second));
+  report("union");
+
+  first.erase(first.begin(), first.end());
+  report("cleared");
+}
+
+// a copy of a map without parent pointers that fails partway leaves
+// nothing behind
+void test43() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  copy_fragile<CS280::AVLmap_parentless<Fragile, int>>();
+}
+
+// a copy of a compact map that fails partway leaves nothing behind
+void test44() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  copy_fragile<CS280::AVLmap_compact<Fragile, int>>();
+}
+
+// a copy of a block map that fails partway leaves nothing behind (the
+// blocks hold default keys in their free slots, so fewer keys stay alive
+// with fewer blocks)
+void test45() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  copy_fragile<CS280::AVLmap_block<Fragile, int>>();
+
+  // an insert whose key fails to copy leaves the map as it was
+  {
+    CS280::AVLmap_block<Fragile, int> map;
+    for (int i = 0; i < 100; ++i) {
+      map[Fragile(i * 2)] = i;
+    }
+
+    int failed = 0;
+    for (int i = 0; i < 100; ++i) {
+      Fragile::copies_left = 0;
+      try {
+        map[Fragile(i * 2 + 1)] = i;
+      } catch (const std::runtime_error&) {
+        failed++;
+      }
+    }
+    Fragile::copies_left = -1;
+
+    int in_order = 0;
+    for (CS280::AVLmap_block<Fragile, int>::iterator it = map.begin();
+         it != map.end(); ++it) {
+      in_order += it->Key().id == in_order * 2 ? 1 : 0;
+    }
+    std::cout << "failed inserts " << failed << ", size " << map.size()
+              << ", sanity " << map.sanityCheck() << ", keys kept "
+              << in_order << std::endl;
+  }
+  std::cout << "alive after the maps are gone " << Fragile::alive
+            << std::endl;
+}
+
 void (*pTests[])(void) = {
   test0,
   test1,
@@ -661,7 +1794,35 @@ void (*pTests[])(void) = {
   test14,
   test15,
   test16,
-  test17
+  test17,
+  test18,
+  test19,
+  test20,
+  test21,
+  test22,
+  test23,
+  test24,
+  test25,
+  test26,
+  test27,
+  test28,
+  test29,
+  test30,
+  test31,
+  test32,
+  test33,
+  test34,
+  test35,
+  test36,
+  test37,
+  test38,
+  test39,
+  test40,
+  test41,
+  test42,
+  test43,
+  test44,
+  test45
 };
 
 int main(int argc, char** argv) {
@@ -0,0 +1,231 @@
+/**
+ * @file fork-join-pool.cpp
+ * @author Edgar Jose Donoso Mansilla (e.donosomansilla)
+ * @course CS280
+ * @term Spring 2025
+ *
+ * @brief Implementation for the work stealing thread pool
+ */
+
+#include <algorithm>
+#include <iterator>
+
+#define FORKJOINPOOL_CPP
+
+#ifndef FORKJOINPOOL_H
+  #include "fork-join-pool.h"
+#endif
+
+namespace CS280 {
+
+  // The header includes this file, so the definitions are inline to keep
+  // them from being defined once per translation unit
+
+  inline ForkJoinPool::ForkJoinPool(unsigned thread_count) {
+    for (unsigned i = 0; i < thread_count; ++i) {
+      workers.push_back(std::make_unique<Worker>());
+    }
+
+    threads.reserve(thread_count);
+    for (unsigned i = 0; i < thread_count; ++i) {
+      threads.emplace_back(&ForkJoinPool::work, this, i);
+    }
+  }
+
+  inline ForkJoinPool::~ForkJoinPool() {
+    {
+      std::lock_guard<std::mutex> guard(sleep_lock);
+      stopping = true;
+    }
+    wake.notify_all();
+
+    for (std::thread& thread: threads) {
+      thread.join();
+    }
+  }
+
+  inline auto ForkJoinPool::concurrency() const -> unsigned {
+    return static_cast<unsigned>(threads.size());
+  }
+
+  template<typename Left, typename Right>
+  auto ForkJoinPool::invoke(Left&& left, Right&& right) -> void {
+    if (threads.empty()) {
+      left();
+      right();
+      return;
+    }
+
+    // From outside the pool the whole pair becomes one task for the workers
+    if (current_pool != this) {
+      auto both = [this, &left, &right]() {
+        invoke(left, right);
+      };
+
+      Task task{&call<decltype(both)>, &both, true};
+      submit(task);
+
+      if (task.error) {
+        std::rethrow_exception(task.error);
+      }
+      return;
+    }
+
+    typedef std::remove_reference_t<Right> RightType;
+    Task task{&call<RightType>, &right, false};
+    push(current_index, &task);
+
+    // The task lives in this frame, so it has to finish even if left throws
+    std::exception_ptr error{};
+    try {
+      left();
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    join(current_index, task);
+
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    if (task.error) {
+      std::rethrow_exception(task.error);
+    }
+  }
+
+  template<typename Function>
+  auto ForkJoinPool::call(void* function) -> void {
+    (*static_cast<Function*>(function))();
+  }
+
+  inline auto ForkJoinPool::work(unsigned index) -> void {
+    current_pool = this;
+    current_index = index;
+
+    while (true) {
+      Task* task = pop(index);
+      if (task == nullptr) {
+        task = steal(index);
+      }
+
+      if (task != nullptr) {
+        execute(task);
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(sleep_lock);
+      wake.wait(lock, [this]() {
+        return stopping || queued.load() != 0;
+      });
+
+      if (stopping) {
+        return;
+      }
+    }
+  }
+
+  inline auto ForkJoinPool::push(unsigned index, Task* task) -> void {
+    {
+      std::lock_guard<std::mutex> guard(workers[index]->lock);
+      workers[index]->tasks.push_back(task);
+      queued++;
+    }
+
+    // Taking the lock orders this with a worker checking queued before sleep
+    { std::lock_guard<std::mutex> guard(sleep_lock); }
+    wake.notify_one();
+  }
+
+  inline auto ForkJoinPool::pop(unsigned index) -> Task* {
+    std::lock_guard<std::mutex> guard(workers[index]->lock);
+    std::deque<Task*>& tasks = workers[index]->tasks;
+
+    if (tasks.empty()) {
+      return nullptr;
+    }
+
+    Task* task = tasks.back();
+    tasks.pop_back();
+    queued--;
+    return task;
+  }
+
+  inline auto ForkJoinPool::steal(unsigned thief) -> Task* {
+    std::size_t count = workers.size();
+
+    for (std::size_t i = 1; i < count; ++i) {
+      Worker& victim = *workers[(thief + i) % count];
+      std::lock_guard<std::mutex> guard(victim.lock);
+
+      if (!victim.tasks.empty()) {
+        Task* task = victim.tasks.front();
+        victim.tasks.pop_front();
+        queued--;
+        return task;
+      }
+    }
+
+    return nullptr;
+  }
+
+  inline auto ForkJoinPool::execute(Task* task) -> void {
+    try {
+      task->call(task->function);
+    } catch (...) {
+      task->error = std::current_exception();
+    }
+
+    if (!task->external) {
+      task->done.store(true, std::memory_order_release);
+      return;
+    }
+
+    // The submitting thread may destroy the task as soon as it sees done
+    std::lock_guard<std::mutex> guard(sleep_lock);
+    task->done.store(true, std::memory_order_release);
+    finished.notify_all();
+  }
+
+  inline auto ForkJoinPool::join(unsigned index, Task& task) -> void {
+    // Unless it was stolen the task is still in the deque (at the back, but
+    // a submitted task may have landed on top of it)
+    {
+      std::unique_lock<std::mutex> lock(workers[index]->lock);
+      std::deque<Task*>& tasks = workers[index]->tasks;
+
+      std::deque<Task*>::iterator found =
+        std::find(tasks.rbegin(), tasks.rend(), &task).base();
+      if (found != tasks.begin()) {
+        tasks.erase(std::prev(found));
+        queued--;
+        lock.unlock();
+        execute(&task);
+        return;
+      }
+    }
+
+    // Whoever stole the task may be waiting for one of ours, so the own
+    // deque is served too
+    while (!task.done.load(std::memory_order_acquire)) {
+      Task* other = pop(index);
+      if (other == nullptr) {
+        other = steal(index);
+      }
+
+      if (other != nullptr) {
+        execute(other);
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  inline auto ForkJoinPool::submit(Task& task) -> void {
+    push(next_submit++ % workers.size(), &task);
+
+    std::unique_lock<std::mutex> lock(sleep_lock);
+    finished.wait(lock, [&task]() {
+      return task.done.load(std::memory_order_acquire);
+    });
+  }
+} // namespace CS280
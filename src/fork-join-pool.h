@@ -0,0 +1,226 @@
+/**
+ * @file fork-join-pool.h
+ * @author Edgar Jose Donoso Mansilla (e.donosomansilla)
+ * @course CS280
+ * @term Spring 2025
+ *
+ * @brief Work stealing thread pool for fork-join recursion
+ */
+
+#ifndef FORKJOINPOOL_H
+  #define FORKJOINPOOL_H
+
+  #include <atomic>
+  #include <condition_variable>
+  #include <deque>
+  #include <exception>
+  #include <memory>
+  #include <mutex>
+  #include <thread>
+  #include <type_traits>
+  #include <vector>
+
+namespace CS280 {
+
+  /**
+   * @brief Thread pool for divide and conquer algorithms. Every worker has a
+   * deque of tasks: forking pushes onto the back of the own deque, idle
+   * workers steal from the front of the others (the oldest, and so biggest,
+   * pieces of work), and a worker waiting for a stolen task steals work of
+   * its own meanwhile.
+   *
+   * Tasks live on the stack of the thread that forked them, so forking never
+   * allocates besides the growth of the deques.
+   */
+  class ForkJoinPool {
+  public:
+
+    /**
+     * @brief Constructor
+     * @param thread_count The amount of worker threads (0 runs everything on
+     * the calling thread)
+     */
+    explicit ForkJoinPool(
+      unsigned thread_count = std::thread::hardware_concurrency()
+    );
+
+    // Deleted copy constructor
+    ForkJoinPool(const ForkJoinPool&) = delete;
+
+    // Deleted copy assignment operator
+    auto operator=(const ForkJoinPool&) -> ForkJoinPool& = delete;
+
+    /**
+     * @brief Destructor (joins the workers)
+     */
+    ~ForkJoinPool();
+
+    /**
+     * @brief Getter for the amount of worker threads
+     * @return The amount of workers (0 if everything runs on the caller)
+     */
+    auto concurrency() const -> unsigned;
+
+    /**
+     * @brief Runs two functions, the second one possibly on another worker,
+     * and returns once both are done. Called from outside the pool the pair
+     * is handed to the workers and the caller blocks. An exception of either
+     * function is rethrown after both finished.
+     * @param left The function run by the calling worker
+     * @param right The function left for other workers to steal
+     */
+    template<typename Left, typename Right>
+    auto invoke(Left&& left, Right&& right) -> void;
+
+  private:
+
+    /**
+     * @brief A function waiting to be run, owned by the thread that forked it
+     */
+    struct Task {
+      /**
+       * @brief Calls the function
+       */
+      void (*call)(void*);
+
+      /**
+       * @brief The function
+       */
+      void* function;
+
+      /**
+       * @brief Whether the thread that forked the task is outside the pool
+       * (and waits on a condition variable instead of stealing)
+       */
+      bool external;
+
+      /**
+       * @brief Set once the function returned
+       */
+      std::atomic<bool> done{false};
+
+      /**
+       * @brief The exception thrown by the function
+       */
+      std::exception_ptr error{};
+    };
+
+    /**
+     * @brief The tasks forked by a worker
+     */
+    struct Worker {
+      std::mutex lock{};
+      std::deque<Task*> tasks{};
+    };
+
+    /**
+     * @brief Calls a function of a given type through a type erased pointer
+     * @param function The function
+     */
+    template<typename Function>
+    static auto call(void* function) -> void;
+
+    /**
+     * @brief Loop of a worker thread
+     * @param index The position of the worker
+     */
+    auto work(unsigned index) -> void;
+
+    /**
+     * @brief Adds a task to the back of a deque and wakes a worker
+     * @param index The position of the worker owning the deque
+     * @param task The task
+     */
+    auto push(unsigned index, Task* task) -> void;
+
+    /**
+     * @brief Takes the newest task of a worker's own deque
+     * @param index The position of the worker
+     * @return The task (nullptr if there is none)
+     */
+    auto pop(unsigned index) -> Task*;
+
+    /**
+     * @brief Takes the oldest task of another worker's deque
+     * @param thief The position of the worker stealing
+     * @return The task (nullptr if every other deque is empty)
+     */
+    auto steal(unsigned thief) -> Task*;
+
+    /**
+     * @brief Runs a task, recording its exception and marking it done
+     * @param task The task
+     */
+    auto execute(Task* task) -> void;
+
+    /**
+     * @brief Waits for a forked task, running it right away if no one stole
+     * it and stealing other tasks otherwise
+     * @param index The position of the waiting worker
+     * @param task The task
+     */
+    auto join(unsigned index, Task& task) -> void;
+
+    /**
+     * @brief Hands a task to the workers and blocks until it is done
+     * @param task The task
+     */
+    auto submit(Task& task) -> void;
+
+    /**
+     * @brief The pool the current thread works for (nullptr outside pools)
+     */
+    inline static thread_local ForkJoinPool* current_pool{nullptr};
+
+    /**
+     * @brief The position of the current thread in its pool
+     */
+    inline static thread_local unsigned current_index{0};
+
+    /**
+     * @brief The deques of the workers
+     */
+    std::vector<std::unique_ptr<Worker>> workers{};
+
+    /**
+     * @brief The worker threads
+     */
+    std::vector<std::thread> threads{};
+
+    /**
+     * @brief Amount of tasks sitting in the deques
+     */
+    std::atomic<std::size_t> queued{0};
+
+    /**
+     * @brief Where submitted tasks go (spreads them over the workers)
+     */
+    std::atomic<unsigned> next_submit{0};
+
+    /**
+     * @brief Guards the sleeping of the workers and of submitting threads
+     */
+    std::mutex sleep_lock{};
+
+    /**
+     * @brief Wakes the workers when tasks are queued or the pool stops
+     */
+    std::condition_variable wake{};
+
+    /**
+     * @brief Wakes the threads waiting for a submitted task
+     */
+    std::condition_variable finished{};
+
+    /**
+     * @brief Set by the destructor to stop the workers
+     */
+    bool stopping{false};
+  };
+} // namespace CS280
+
+  #ifndef FORKJOINPOOL_CPP
+    #include "fork-join-pool.cpp"
+  #endif
+
+#endif
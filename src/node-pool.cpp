@@ -0,0 +1,318 @@
+/**
+ * @file node-pool.cpp
+ * @author Edgar Jose Donoso Mansilla (e.donosomansilla)
+ * @course CS280
+ * @term Spring 2025
+ *
+ * @brief Implementation for the allocation policies of the tree nodes
+ */
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#define NODEPOOL_CPP
+
+#ifndef NODEPOOL_H
+  #include "node-pool.h"
+#endif
+
+namespace CS280 {
+
+  /// NodePool Methods
+
+  template<typename T>
+  NodePool<T>::NodePool(): arena(std::make_shared<Arena>()) {}
+
+  template<typename T>
+  NodePool<T>::NodePool(const NodePool& rhs): arena(rhs.arena) {
+    if (arena != nullptr) {
+      arena->owners.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  template<typename T>
+  auto NodePool<T>::operator=(const NodePool& rhs) -> NodePool& {
+    if (arena != rhs.arena) {
+      leave();
+      arena = rhs.arena;
+
+      if (arena != nullptr) {
+        arena->owners.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    return *this;
+  }
+
+  template<typename T>
+  NodePool<T>::NodePool(NodePool&& rhs) noexcept:
+      arena(std::move(rhs.arena)) {}
+
+  template<typename T>
+  auto NodePool<T>::operator=(NodePool&& rhs) noexcept -> NodePool& {
+    if (this != &rhs) {
+      leave();
+      arena = std::move(rhs.arena);
+    }
+
+    return *this;
+  }
+
+  template<typename T>
+  NodePool<T>::~NodePool() {
+    leave();
+  }
+
+  template<typename T>
+  auto NodePool<T>::allocate() -> T* {
+    std::unique_lock<std::mutex> lock = guard();
+    Arena& state = *arena;
+    state.stats.allocations++;
+
+    if (state.free_list != nullptr) {
+      Block* block = state.free_list;
+      state.free_list = block->next;
+      state.free_count--;
+      state.stats.reused++;
+      return reinterpret_cast<T*>(block->storage);
+    }
+
+    if (state.unused == state.unused_end) {
+      state.add_slab(state.next_slab_size);
+    }
+
+    Block* block = state.unused++;
+    return reinterpret_cast<T*>(block->storage);
+  }
+
+  template<typename T>
+  auto NodePool<T>::deallocate(T* object) -> void {
+    if (object == nullptr) {
+      return;
+    }
+
+    std::unique_lock<std::mutex> lock = guard();
+    Arena& state = *arena;
+    Block* block = reinterpret_cast<Block*>(object);
+    block->next = state.free_list;
+    state.free_list = block;
+    state.free_count++;
+    state.stats.deallocations++;
+  }
+
+  template<typename T>
+  auto NodePool<T>::reserve(std::size_t count) -> void {
+    std::unique_lock<std::mutex> lock = guard();
+    Arena& state = *arena;
+    std::ptrdiff_t untouched = state.unused_end - state.unused;
+    std::size_t available =
+      state.free_count + static_cast<std::size_t>(untouched);
+
+    if (available >= count) {
+      return;
+    }
+
+    // The blocks left in the current slab go to the free list, the rest of
+    // the batch is then served from a single new slab
+    while (state.unused != state.unused_end) {
+      Block* block = state.unused++;
+      block->next = state.free_list;
+      state.free_list = block;
+      state.free_count++;
+    }
+
+    state.add_slab(std::max(count - state.free_count, state.next_slab_size));
+  }
+
+  template<typename T>
+  auto NodePool<T>::adopt(NodePool&, std::size_t) -> void {}
+
+  template<typename T>
+  auto NodePool<T>::release() -> void {
+    if (unique()) {
+      arena->release();
+    }
+  }
+
+  template<typename T>
+  auto NodePool<T>::unique() const -> bool {
+    return arena != nullptr
+           && arena->owners.load(std::memory_order_acquire) == 1;
+  }
+
+  template<typename T>
+  auto NodePool<T>::stats() const -> const PoolStats& {
+    static const PoolStats empty{0, 0, 0, 0, 0, sizeof(Block), 0};
+    return arena != nullptr ? arena->stats : empty;
+  }
+
+  template<typename T>
+  auto NodePool<T>::operator==(const NodePool& rhs) const -> bool {
+    return arena != nullptr && arena == rhs.arena;
+  }
+
+  template<typename T>
+  auto NodePool<T>::operator!=(const NodePool& rhs) const -> bool {
+    return !(*this == rhs);
+  }
+
+  template<typename T>
+  auto NodePool<T>::get_arena() -> Arena& {
+    if (arena == nullptr) {
+      arena = std::make_shared<Arena>();
+    }
+
+    return *arena;
+  }
+
+  template<typename T>
+  auto NodePool<T>::guard() -> std::unique_lock<std::mutex> {
+    Arena& state = get_arena();
+
+    // Only copies can share the slabs, and a copy is made by the thread using
+    // the pool, so a pool that sees no other owner cannot race with anyone
+    if (state.owners.load(std::memory_order_acquire) > 1) {
+      return std::unique_lock<std::mutex>(state.lock);
+    }
+
+    return std::unique_lock<std::mutex>();
+  }
+
+  template<typename T>
+  auto NodePool<T>::leave() -> void {
+    if (arena != nullptr) {
+      arena->owners.fetch_sub(1, std::memory_order_acq_rel);
+      arena.reset();
+    }
+  }
+
+  /// NodePool::Arena Methods
+
+  template<typename T>
+  NodePool<T>::Arena::Arena(): slabs() {
+    stats.bytes_per_node = sizeof(Block);
+  }
+
+  template<typename T>
+  NodePool<T>::Arena::~Arena() {
+    release();
+  }
+
+  template<typename T>
+  auto NodePool<T>::Arena::add_slab(std::size_t count) -> void {
+    std::allocator<Block> allocator;
+    Block* blocks = allocator.allocate(count);
+
+    slabs.push_back(Slab{blocks, count});
+    unused = blocks;
+    unused_end = blocks + count;
+    next_slab_size = std::min(next_slab_size * 2, max_slab_size);
+
+    stats.slabs++;
+    stats.capacity += count;
+    stats.bytes_reserved += count * sizeof(Block);
+  }
+
+  template<typename T>
+  auto NodePool<T>::Arena::release() -> void {
+    std::allocator<Block> allocator;
+
+    for (Slab& slab: slabs) {
+      allocator.deallocate(slab.blocks, slab.count);
+    }
+
+    slabs.clear();
+    free_list = nullptr;
+    free_count = 0;
+    unused = nullptr;
+    unused_end = nullptr;
+    next_slab_size = first_slab_size;
+
+    stats.slabs = 0;
+    stats.capacity = 0;
+    stats.bytes_reserved = 0;
+  }
+
+  /// HeapPool Methods
+
+  template<typename T>
+  HeapPool<T>::HeapPool():
+      stats_(std::make_shared<PoolStats>(
+        PoolStats{0, 0, 0, 0, 0, sizeof(T), 0}
+      )) {}
+
+  template<typename T>
+  auto HeapPool<T>::allocate() -> T* {
+    PoolStats& stats = get_stats();
+    stats.allocations++;
+    stats.capacity++;
+    stats.bytes_reserved += sizeof(T);
+    return std::allocator<T>().allocate(1);
+  }
+
+  template<typename T>
+  auto HeapPool<T>::deallocate(T* object) -> void {
+    if (object == nullptr) {
+      return;
+    }
+
+    PoolStats& stats = get_stats();
+    stats.deallocations++;
+    stats.capacity--;
+    stats.bytes_reserved -= sizeof(T);
+    std::allocator<T>().deallocate(object, 1);
+  }
+
+  template<typename T>
+  auto HeapPool<T>::reserve(std::size_t) -> void {}
+
+  template<typename T>
+  auto HeapPool<T>::adopt(HeapPool& from, std::size_t count) -> void {
+    PoolStats& stats = get_stats();
+    PoolStats& from_stats = from.get_stats();
+    if (&stats == &from_stats) {
+      return;
+    }
+
+    from_stats.capacity -= count;
+    from_stats.bytes_reserved -= count * sizeof(T);
+    stats.capacity += count;
+    stats.bytes_reserved += count * sizeof(T);
+  }
+
+  template<typename T>
+  auto HeapPool<T>::release() -> void {}
+
+  template<typename T>
+  auto HeapPool<T>::unique() const -> bool {
+    return stats_.use_count() == 1;
+  }
+
+  template<typename T>
+  auto HeapPool<T>::stats() const -> const PoolStats& {
+    static const PoolStats empty{0, 0, 0, 0, 0, sizeof(T), 0};
+    return stats_ != nullptr ? *stats_ : empty;
+  }
+
+  template<typename T>
+  auto HeapPool<T>::operator==(const HeapPool&) const -> bool {
+    return true;
+  }
+
+  template<typename T>
+  auto HeapPool<T>::operator!=(const HeapPool& rhs) const -> bool {
+    return !(*this == rhs);
+  }
+
+  template<typename T>
+  auto HeapPool<T>::get_stats() -> PoolStats& {
+    if (stats_ == nullptr) {
+      stats_ = std::make_shared<PoolStats>(
+        PoolStats{0, 0, 0, 0, 0, sizeof(T), 0}
+      );
+    }
+
+    return *stats_;
+  }
+} // namespace CS280
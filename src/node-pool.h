@@ -0,0 +1,402 @@
+/**
+ * @file node-pool.h
+ * @author Edgar Jose Donoso Mansilla (e.donosomansilla)
+ * @course CS280
+ * @term Spring 2025
+ *
+ * @brief Allocation policies for the nodes of the trees
+ */
+
+#ifndef NODEPOOL_H
+  #define NODEPOOL_H
+
+  #include <atomic>
+  #include <cstddef>
+  #include <memory>
+  #include <mutex>
+  #include <vector>
+
+namespace CS280 {
+
+  /**
+   * @brief Counters describing the memory used by a pool.
+   */
+  struct PoolStats {
+    /**
+     * @brief Amount of nodes handed out by the pool.
+     */
+    std::size_t allocations{0};
+
+    /**
+     * @brief Amount of nodes given back to the pool.
+     */
+    std::size_t deallocations{0};
+
+    /**
+     * @brief Amount of allocations served by a previously freed node.
+     */
+    std::size_t reused{0};
+
+    /**
+     * @brief Amount of slabs currently held by the pool.
+     */
+    std::size_t slabs{0};
+
+    /**
+     * @brief Amount of nodes that fit in the slabs currently held.
+     */
+    std::size_t capacity{0};
+
+    /**
+     * @brief Amount of bytes used by every node (including padding).
+     */
+    std::size_t bytes_per_node{0};
+
+    /**
+     * @brief Amount of bytes currently held by the pool.
+     */
+    std::size_t bytes_reserved{0};
+  };
+
+  /**
+   * @brief Pool of fixed size blocks for objects of type T. Memory is taken
+   * from the system in slabs that hold many blocks and freed blocks are kept
+   * in a free list so they can be reused by later allocations.
+   *
+   * Copies of a pool share its slabs, so an object allocated by one copy can
+   * be deallocated by any other. The slabs are freed along with the last copy.
+   *
+   * A single pool is not thread safe, but while copies share the slabs every
+   * allocation takes the lock of the slabs, so each copy can be used from a
+   * different thread (the maps left by a split, for instance). A pool nobody
+   * shares skips the lock.
+   *
+   * @param T The type of the objects that will live in the pool
+   */
+  template<typename T>
+  class NodePool {
+  public:
+
+    /**
+     * @brief Whether release() gives back the memory of every object at once.
+     */
+    static constexpr bool bulk_release{true};
+
+    /**
+     * @brief Constructor
+     */
+    NodePool();
+
+    /**
+     * @brief Copy Constructor (the copy shares the slabs of rhs)
+     */
+    NodePool(const NodePool& rhs);
+
+    /**
+     * @brief Copy Assignment Operator (this pool will share the slabs of rhs)
+     */
+    auto operator=(const NodePool& rhs) -> NodePool&;
+
+    /**
+     * @brief Move Constructor
+     */
+    NodePool(NodePool&& rhs) noexcept;
+
+    /**
+     * @brief Move Assignment Operator
+     */
+    auto operator=(NodePool&& rhs) noexcept -> NodePool&;
+
+    /**
+     * @brief Destructor (frees every slab if no other pool shares them)
+     */
+    ~NodePool();
+
+    /**
+     * @brief Gets uninitialized memory for one object.
+     * @return Pointer to the memory.
+     */
+    auto allocate() -> T*;
+
+    /**
+     * @brief Gives back the memory of one object. The object must have been
+     * destroyed already.
+     * @param object Pointer to the memory.
+     */
+    auto deallocate(T* object) -> void;
+
+    /**
+     * @brief Makes sure the next count allocations will not need to go to the
+     * system. If a new slab is needed it will be big enough for all of them.
+     * @param count The amount of allocations to prepare for.
+     */
+    auto reserve(std::size_t count) -> void;
+
+    /**
+     * @brief Takes over objects allocated by an equal pool. Does nothing, as
+     * equal pools share their slabs and their counters.
+     * @param from The pool the objects came from.
+     * @param count The amount of objects.
+     */
+    auto adopt(NodePool& from, std::size_t count) -> void;
+
+    /**
+     * @brief Frees every slab at once. All the objects in the pool must have
+     * been destroyed already (or be trivially destructible). Does nothing if
+     * another pool shares the slabs.
+     */
+    auto release() -> void;
+
+    /**
+     * @brief Returns whether no other pool shares the slabs of this one.
+     * @return Whether the slabs are only used by this pool.
+     */
+    auto unique() const -> bool;
+
+    /**
+     * @brief Getter for the counters of the pool (shared with its copies, and
+     * not synchronized with the allocations of the other copies).
+     * @return The counters.
+     */
+    auto stats() const -> const PoolStats&;
+
+    /**
+     * @brief Returns whether memory from one pool can be given back to the
+     * other (they share their slabs).
+     * @return Whether the pools share their slabs.
+     */
+    auto operator==(const NodePool& rhs) const -> bool;
+
+    /**
+     * @brief Returns whether the pools do not share their slabs.
+     * @return Whether the pools do not share their slabs.
+     */
+    auto operator!=(const NodePool& rhs) const -> bool;
+
+  private:
+
+    /**
+     * @brief A block is either free (and linked to the next free block) or
+     * holds an object.
+     */
+    union Block {
+      Block* next;
+      alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    /**
+     * @brief A contiguous run of blocks taken from the system at once.
+     */
+    struct Slab {
+      Block* blocks;
+      std::size_t count;
+    };
+
+    /**
+     * @brief The state shared by all the copies of a pool.
+     */
+    struct Arena {
+      Arena();
+
+      // Deleted copy constructor
+      Arena(const Arena&) = delete;
+
+      // Deleted copy assignment operator
+      auto operator=(const Arena&) -> Arena& = delete;
+
+      /**
+       * @brief Destructor (frees every slab)
+       */
+      ~Arena();
+
+      /**
+       * @brief Takes a new slab from the system.
+       * @param count The amount of blocks in the slab.
+       */
+      auto add_slab(std::size_t count) -> void;
+
+      /**
+       * @brief Frees every slab.
+       */
+      auto release() -> void;
+
+      /**
+       * @brief The slabs held by the pool.
+       */
+      std::vector<Slab> slabs;
+
+      /**
+       * @brief The first of the blocks that were freed.
+       */
+      Block* free_list{nullptr};
+
+      /**
+       * @brief Amount of blocks in the free list.
+       */
+      std::size_t free_count{0};
+
+      /**
+       * @brief Next block of the last slab that has never been used.
+       */
+      Block* unused{nullptr};
+
+      /**
+       * @brief End of the last slab.
+       */
+      Block* unused_end{nullptr};
+
+      /**
+       * @brief Size in blocks of the next slab.
+       */
+      std::size_t next_slab_size{first_slab_size};
+
+      /**
+       * @brief The counters of the pool.
+       */
+      PoolStats stats{};
+
+      /**
+       * @brief Taken by every allocation while the slabs are shared.
+       */
+      std::mutex lock{};
+
+      /**
+       * @brief Amount of pools sharing the slabs.
+       */
+      std::atomic<std::size_t> owners{1};
+    };
+
+    /**
+     * @brief Gets the shared state, creating it for a moved-from pool.
+     * @return The shared state.
+     */
+    auto get_arena() -> Arena&;
+
+    /**
+     * @brief Takes the lock of the slabs if other pools share them.
+     * @return The lock (not holding anything if the slabs are not shared).
+     */
+    auto guard() -> std::unique_lock<std::mutex>;
+
+    /**
+     * @brief Stops sharing the slabs (freed if this was the last pool).
+     */
+    auto leave() -> void;
+
+    /**
+     * @brief Size of the first slab in blocks.
+     */
+    static constexpr std::size_t first_slab_size{32};
+
+    /**
+     * @brief Size limit in blocks for the geometric growth of the slabs.
+     */
+    static constexpr std::size_t max_slab_size{1 << 16};
+
+    /**
+     * @brief The state of the pool (nullptr once moved from).
+     */
+    std::shared_ptr<Arena> arena;
+  };
+
+  /**
+   * @brief Allocation policy that uses new and delete for every object. Has
+   * the same interface as NodePool. Copies of a pool share its counters.
+   *
+   * Every pool can give back the objects of any other, so maps with pools
+   * of their own still relink their nodes between them. adopt moves the
+   * accounting of the relinked objects along, so the counters of each pool
+   * keep describing the objects it holds.
+   *
+   * @param T The type of the objects to allocate
+   */
+  template<typename T>
+  class HeapPool {
+  public:
+
+    /**
+     * @brief Whether release() gives back the memory of every object at once.
+     */
+    static constexpr bool bulk_release{false};
+
+    /**
+     * @brief Constructor
+     */
+    HeapPool();
+
+    /**
+     * @brief Gets uninitialized memory for one object.
+     * @return Pointer to the memory.
+     */
+    auto allocate() -> T*;
+
+    /**
+     * @brief Gives back the memory of one object.
+     * @param object Pointer to the memory.
+     */
+    auto deallocate(T* object) -> void;
+
+    /**
+     * @brief Does nothing as every object is allocated on its own.
+     */
+    auto reserve(std::size_t count) -> void;
+
+    /**
+     * @brief Takes over objects allocated by another pool, which will be
+     * given back to this one (the counters of both are moved along).
+     * @param from The pool the objects came from.
+     * @param count The amount of objects.
+     */
+    auto adopt(HeapPool& from, std::size_t count) -> void;
+
+    /**
+     * @brief Does nothing as every object is freed on its own.
+     */
+    auto release() -> void;
+
+    /**
+     * @brief Returns whether no other pool shares the counters of this one.
+     * @return Whether the counters are only used by this pool.
+     */
+    auto unique() const -> bool;
+
+    /**
+     * @brief Getter for the counters of the pool (shared with its copies).
+     * @return The counters.
+     */
+    auto stats() const -> const PoolStats&;
+
+    /**
+     * @brief Returns whether memory from one pool can be given back to the
+     * other (always, it all comes from the heap).
+     * @return true
+     */
+    auto operator==(const HeapPool& rhs) const -> bool;
+
+    /**
+     * @brief Returns whether memory from one pool cannot be given back to
+     * the other.
+     * @return false
+     */
+    auto operator!=(const HeapPool& rhs) const -> bool;
+
+  private:
+
+    /**
+     * @brief Gets the counters, creating them for a moved-from pool.
+     * @return The counters.
+     */
+    auto get_stats() -> PoolStats&;
+
+    /**
+     * @brief The counters of the pool (nullptr once moved from).
+     */
+    std::shared_ptr<PoolStats> stats_;
+  };
+} // namespace CS280
+
+  #ifndef NODEPOOL_CPP
+    #include "node-pool.cpp"
+  #endif
+
+#endif